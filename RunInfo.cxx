@@ -37,6 +37,17 @@ RunInfo::RunInfo()
    ntrigs	= 0 ;		// total frames triggered
    ntrigs_period= 0 ;		// total frames triggered
    ntrigs_cds	= 0 ;		// total frames triggered
+   pipeline_max	= 0 ;
+   timewait	= 0 ;
+   timeout	= 0 ;
+   tune_t_read	= 0 ;
+   tune_t_comm	= 0 ;
+   tune_t_write	= 0 ;
+   for (int k=0; k < SHED_LEVELS; k++) {
+      shed_entered[k] = 0;
+      shed_frames[k]  = 0;
+      shed_seconds[k] = 0;
+   }
    //trig_cds[NROWS][NCOLS];	// CDS noise of each pixel
    for (int i=0; i < nrows; i++) {
       for (int j=0; j < ncols; j++) {
@@ -91,9 +102,51 @@ void RunInfo::Print(Option_t *option) const
 	 << endl;
 
    }
+   if (shed_entered[SHED_PERIOD]) {
+      cout << setw(30) << "load-shedding (level: entered frames sec)";
+      for (int k=1; k < SHED_LEVELS; k++) {
+	 cout << " " << k << ": " << shed_entered[k] << " " << shed_frames[k] << " " << shed_seconds[k];
+      }
+      cout << endl;
+   }
+   if (tune_t_read > 0) {
+      cout << setw(30) << "autotune (usec read/comm/write) = "
+	   << tune_t_read << "/" << tune_t_comm << "/" << tune_t_write
+	   << " -> pipeline_max=" << pipeline_max
+	   << " timewait=" << timewait << " timeout=" << timeout << endl;
+      if (tune_frame.size()) {
+	 cout << setw(30) << "retuned = " << tune_frame.size() << " times (frame:pipeline)";
+	 for (size_t i=0; i < tune_frame.size(); i++)
+	    cout << " " << tune_frame[i] << ":" << tune_pipeline[i];
+	 cout << endl;
+      }
+   }
+   if (shed_post_frame.size()) {
+      cout << setw(30) << "post_trigs shed = " << shed_post_frame.size() << " times (frame:post)";
+      for (size_t i=0; i < shed_post_frame.size(); i++)
+	 cout << " " << shed_post_frame[i] << ":" << shed_post_trigs[i];
+      cout << endl;
+   }
+   if (ctrl_frame.size()) {
+      cout << setw(30) << "trig_cds_x adjusted = " << ctrl_frame.size() << " times (frame:x)";
+      for (size_t i=0; i < ctrl_frame.size(); i++) {
+	 cout << " " << ctrl_frame[i] << ":" << ctrl_cds_x[i];
+      }
+      cout << endl;
+   }
 }
 
 
+// post_trigs of load-shedding in effect at frame
+//______________________________________________________________________
+int RunInfo::get_post_trigs(unsigned long frame) const
+{
+   int n = post_trigs;
+   for (size_t i=0; i < shed_post_frame.size() && shed_post_frame[i] <= frame; i++)
+      n = shed_post_trigs[i];
+   return n;
+}
+
 // CDS thresholds
 //______________________________________________________________________
 void RunInfo::Print_threshold() const
@@ -13,6 +13,7 @@
 #include "mydefs.h"
 #include "TObject.h"
 #include <time.h>
+#include <vector>
 
 // run information
 //______________________________________________________________________
@@ -44,6 +45,26 @@ public:
    double cds_sigma[NROWS][NCOLS];	// CDS noise sigma of each pixel
    double adc_mean[NROWS][NCOLS];	// ADC noise mean of each pixel
    double adc_sigma[NROWS][NCOLS];	// ADC noise sigma of each pixel
+   // trig_cds_x adjusted by the threshold controller, trig_cds[][] is the last
+   std::vector<unsigned long> ctrl_frame;	// frame where adjusted, effective from the next
+   std::vector<double>	ctrl_cds_x;	// new trig_cds_x
+   // load-shedding per level, see shed_levels_t
+   unsigned long shed_entered[SHED_LEVELS];	// times entered
+   unsigned long shed_frames[SHED_LEVELS];	// frames processed at the level
+   double  shed_seconds[SHED_LEVELS];		// time at the level
+   // post_trigs shortened by load-shedding (SHED_POST) and restored: of the
+   // triggers from shed_post_frame[i] on, up to the next entry
+   std::vector<unsigned long> shed_post_frame;
+   std::vector<int>	shed_post_trigs;
+   // DAQ configuration, tuned at run start with daq.exe -A
+   int	pipeline_max;		// frames in use of the pipeline
+   int	timewait;		// usec
+   int	timeout;		// usec
+   double tune_t_read;		// calibration, usec per frame read, 0 = not tuned
+   double tune_t_comm;		// calibration, usec per frame decoded and triggered
+   double tune_t_write;		// calibration, usec per frame written
+   std::vector<unsigned long> tune_frame;	// retuned online at frame
+   std::vector<int>	tune_pipeline;	// new pipeline_max
 
    // must have a default constructor or an I/O constructor
    RunInfo();
@@ -58,6 +79,7 @@ public:
    
    void set_time_start();
    void set_time_stop();
+   int get_post_trigs(unsigned long frame) const;	// of a trigger at frame
 
    // run start time
 
@@ -69,7 +91,11 @@ public:
    //     4 : ADC noise arrays
    //     5 : daq_mode
    //     6 : trig_cds[_x] changd to double
-   ClassDef(RunInfo, 6);
+   //     7 : ctrl_frame & ctrl_cds_x
+   //     8 : shed_entered, shed_frames & shed_seconds
+   //     9 : pipeline_max, timewait, timeout & tune_*
+   //    10 : shed_post_frame & shed_post_trigs
+   ClassDef(RunInfo, 10);
 };
 
 #endif //~ RunInfo_h
@@ -8,7 +8,11 @@
  * @copyright:  (c)2019 HEPG - Shandong University. All Rights Reserved.
  ***********************************************************************/
 #include "SupixAnly.h"
+#include "SupixIndex.h"
 #include "Timer.h"
+#include "densehist.h"
+#include "clusweep.h"
+#include "fakescan.h"
 
 #include <TH1D.h>
 #include <TH2D.h>
@@ -17,15 +21,53 @@
 #include <TPaveStats.h>
 #include <TMultiGraph.h>
 #include <TGraph.h>
+#include <TROOT.h>
+#include <TChain.h>
+#include <TChainElement.h>
+#include <TFile.h>
+
+#include <pthread.h>
+#include <fcntl.h>	// posix_fadvise()
+#include <unistd.h>
+#include <string.h>	// strerror()
+#include <errno.h>
+#include <sys/stat.h>	// mkdir()
 
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <set>
 using namespace std;
 #define ALLPIXS			// control pixel-wise histograms
 #define MAXGRAPHS	100	// max saved graphs
 
+// Mean of ADC_{normal pixel}   --LongLI 2021-10-24
+static const double g_pix_mean_nor[100] = {
+   0,0,0,0,0,0,0,0,0,0,
+   0,0,0,5.46664,4.32249,4.30971,4.41694,4.6719,5.10492,5.0715,
+   5.58685,5.5901,5.62377,6.04017,6.02815,6.33619,6.55763,6.33782,6.80423,6.75667,
+   6.70185,6.8082,6.95955,6.73127,6.79323,6.86964,6.63521,6.51712,6.48791,6.35799,
+   6.23003,6.1698,5.94241,5.76254,5.64788,5.67928,5.66383,5.99773,5.98289,5.5885,
+   6.02573,5.94561,6.467,6.36298,6.57126,6.80028,6.85928,6.85512,7.05563,7.12313,
+   7.40827,7.42279,7.63819,7.70161,7.72629,7.75554,7.92468,7.92804,7.99664,7.96075,
+   8.14537,8.17192,8.14017,8.21287,8.20517,8.3405,8.4356,8.53593,8.51158,8.59353,
+   8.73125,8.73658,8.60807,8.97186,8.96729,8.98774,9.03495,9.16369,9.1426,9.24362,
+   9.37923,9.42668,9.53806,9.4106,9.74709,9.80555,9.91234,9.85703,9.81151,9.89866
+};
+static const double g_pix_mean_cor[100] = {
+   0,0,0,0,0,0,0,0,0,0,
+   0,0,0,1.32152,2.79376,2.28484,2.95986,3.1873,3.21223,4.04305,
+   3.40222,3.99839,4.47288,4.51717,4.84964,5.06274,4.59626,4.9941,4.67707,5.07054,
+   4.98284,5.11267,4.53954,5.07006,5.23708,5.07674,5.21115,4.98198,5.30596,4.69664,
+   3.9978,3.9801,4.39313,4.27648,4.27723,3.66075,4.02171,3.97604,3.8803,4.28023,
+   4.29398,4.36328,4.80771,4.82283,4.86522,4.90933,5.29831,5.63844,5.84625,5.74713,
+   5.7366,6.32607,6.37832,6.4796,6.47173,6.58061,6.66941,6.80146,6.29387,6.78597,
+   6.93655,6.63726,7.08871,7.00549,7.24587,7.25348,7.38817,7.53857,7.32099,7.53989,
+   7.63595,7.82506,8.0588,7.51866,7.39809,7.81781,7.86724,7.70332,8.32736,8.10022,
+   8.38531,8.71637,8.52362,8.76948,9.10689,8.6232,8.6507,9.00265,9.15226,9.29647
+};
+
 //
 // constructor(s)
 //______________________________________________________________________
@@ -78,6 +120,29 @@ SupixAnly::SupixAnly(TTree *tree)
    
    m_c1 = 0;
    m_booked = false;
+   m_nthreads = 1;
+   m_nhits = 0;
+   m_nconsecutives = 0;
+   m_frame_first = 0;
+   m_frame_last = 0;
+   m_cache_size = 0;
+   m_cache_learn = 0;
+   m_open_ahead = 0;
+   m_opener = 0;
+   m_index = 0;
+   m_calib.runinfo = 0;
+   m_calib_tree = -1;
+   m_dense_adc = 0;
+   m_dense_cds = 0;
+   m_sweep = new ClusterSweep(NROWS, NCOLS);
+   m_cluster_sweep = false;
+   std::vector<double> thr;
+   for (int k=0; k < 20; k++)
+      thr.push_back(0.2*k + 1);		// of m_sum_alg[] ...
+   m_sweep->set_thresholds(thr);
+   m_fake_scan = 0;
+   m_fake_scan_def = 0;
+   set_fake_grid(0, 0.1, 200);
 }
 
 
@@ -86,6 +151,12 @@ SupixAnly::SupixAnly(TTree *tree)
 //______________________________________________________________________
 SupixAnly::~SupixAnly()
 {
+   delete m_index;
+   delete m_dense_adc;
+   delete m_dense_cds;
+   delete m_sweep;
+   delete m_fake_scan;
+   delete m_fake_scan_def;
    // for (int i=0; i < NCOLS; i++) {
    //    delete m_mg_adc_pixs[i];
    // }
@@ -154,41 +225,13 @@ void SupixAnly::Book()
    TH2D* h2d;
    
 #ifdef ALLPIXS
+   // pixel-wise histograms dense, cds_i_j & adc_i_j of dense_to_hists()
    m_list_adc = new TList;
    m_list_cds = new TList;
-   for (int i=0; i < NROWS; i++) {
-      for (int j=0; j < NCOLS; j++) {
-	 // CDS
-	 oss.str("");
-	 oss << "cds_" << i << "_" << j;
-	 hname = oss.str();
-	 oss.str("");
-	 oss << "CDS[" << i << "][" << j << "];CDS";
-	 htitle = oss.str();
-	 h1d = (TH1D*)gDirectory->Get(hname.c_str() );
-	 if (h1d) delete h1d;
-	 xmin = -30, xmax = 300;
-	 xbins = xmax - xmin;
-	 h1d = new TH1D(hname.c_str(), htitle.c_str(), xbins, xmin, xmax);
-	 m_cds[i][j] = h1d;
-	 m_list_cds->Add(h1d);
-
-	 // ADC
-	 oss.str("");
-	 oss << "adc_" << i << "_" << j;
-	 hname = oss.str();
-	 oss.str("");
-	 oss << "ADC[" << i << "][" << j << "];ADC";
-	 htitle = oss.str();
-	 h1d = (TH1D*)gDirectory->Get(hname.c_str() );
-	 if (h1d) delete h1d;
-	 xmin = g_adc_cor_min, xmax = g_adc_cor_max;
-	 xbins = xmax - xmin;
-	 h1d = new TH1D(hname.c_str(), htitle.c_str(), 70000, 0, 70000);
-	 m_adc[i][j] = h1d;
-	 m_list_adc->Add(h1d);
-      }
-   }
+   delete m_dense_cds;
+   delete m_dense_adc;
+   m_dense_cds = new DenseHist(NPIXS, -30, 330);		// [-30, 300)
+   m_dense_adc = new DenseHist(NPIXS, 0, 70000, 0, 65535);	// [0, 70000) of adc_t
 #endif
 
    m_list_misc = new TList;
@@ -1275,6 +1318,12 @@ void SupixAnly::Book()
 	m_frame_num = clu;
 	m_list_fake_hit->Add(clu);	
 
+	// rates on the fine grid: fake_scan* of fake_scan_hists() at Write()
+	delete m_fake_scan;
+	delete m_fake_scan_def;
+	m_fake_scan = new FakeScan(m_fake_xmin, m_fake_step, m_fake_nbins);
+	m_fake_scan_def = new FakeScan(m_fake_xmin, m_fake_step, m_fake_nbins);
+
 
 
 
@@ -1407,6 +1456,39 @@ void SupixAnly::Book()
 	m_booked = true;
 }
 
+// fake-trigger and fake-hit rates vs. threshold of the scans, once
+//______________________________________________________________________
+void SupixAnly::fake_scan_hists()
+{
+   TRACE;
+   if (! m_fake_scan || m_list_fake_hit->FindObject("fake_scan") )	return;
+   FakeScan *scan[2] = { m_fake_scan, m_fake_scan_def };
+   const char *suffix[2] = { "", "_def" };
+   for (int h=0; h < 2; h++) {
+      FakeScan *f = scan[h];
+      int n = f->get_nbins();
+      double lo = f->get_xmin() - 0.5 * f->get_step();	// grid points at bin centres
+      double hi = f->get_threshold(n) + 0.5 * f->get_step();
+      string name = string("fake_scan") + suffix[h];
+      TH1D *frames = new TH1D(name.c_str(), "Fake-trigger rate vs. threshold; Threshold [#sigma]; Frames fired / frame"
+			      , n + 1, lo, hi);
+      name = string("fake_pix_scan") + suffix[h];
+      TH1D *pixs = new TH1D(name.c_str(), "Fake-hit rate vs. threshold; Threshold [#sigma]; Pixels fired / pixel"
+			    , n + 1, lo, hi);
+      for (int i=0; i <= n; i++) {
+	 double t = f->get_threshold(i);
+	 if (f->get_frames() )
+	    frames->SetBinContent(i + 1, f->frames_over(t) / (double)f->get_frames() );
+	 if (f->get_pixels() )
+	    pixs->SetBinContent(i + 1, f->pixels_over(t) / (double)f->get_pixels() );
+      }
+      frames->SetEntries(f->get_frames() );
+      pixs->SetEntries(f->get_pixels() );
+      m_list_fake_hit->Add(frames);
+      m_list_fake_hit->Add(pixs);
+   }
+}
+
 // write out non-histogram objects
 //______________________________________________________________________
 void SupixAnly::write_waveform()
@@ -1429,10 +1511,55 @@ void SupixAnly::write_waveform()
    gFile->cd();
 }
 
+// cds_i_j & adc_i_j of the dense sets, once; each dense row given back
+// when converted, so the TH1Ds never add up to them
+//______________________________________________________________________
+void SupixAnly::dense_to_hists()
+{
+   TRACE;
+   if (! m_dense_cds || m_list_cds->GetSize() )	return;
+   DenseHist *dense[2] = { m_dense_cds, m_dense_adc };
+   TList *list[2] = { m_list_cds, m_list_adc };
+   const char *name[2] = { "cds", "adc" }, *title[2] = { "CDS", "ADC" };
+   double xmin[2] = { -30, 0 };
+   ostringstream oss;
+   for (int i=0; i < NROWS; i++) {
+      for (int j=0; j < NCOLS; j++) {
+	 int p = i*NCOLS + j;
+	 for (int h=0; h < 2; h++) {
+	    oss.str("");
+	    oss << name[h] << "_" << i << "_" << j;
+	    string hname = oss.str();
+	    oss.str("");
+	    oss << title[h] << "[" << i << "][" << j << "];" << title[h];
+	    TH1D *h1d = (TH1D*)gDirectory->Get(hname.c_str() );
+	    if (h1d) delete h1d;
+	    int nbins = dense[h]->get_nbins();
+	    h1d = new TH1D(hname.c_str(), oss.str().c_str(), nbins, xmin[h], xmin[h] + nbins);
+	    for (int b=0; b <= nbins + 1; b++) {
+	       unsigned long n = dense[h]->get_bin(p, b);
+	       if (n)	h1d->SetBinContent(b, n);
+	    }
+	    double stats[4];
+	    dense[h]->get_stats(p, stats);
+	    h1d->PutStats(stats);
+	    h1d->SetEntries(dense[h]->get_entries() );
+	    dense[h]->release(p);
+	    list[h]->Add(h1d);
+	    (h ? m_adc : m_cds)[i][j] = h1d;
+	 }
+      }
+   }
+}
+
 // write out non-histogram objects
 //______________________________________________________________________
 void SupixAnly::Write()
 {
+#ifdef ALLPIXS
+   dense_to_hists();
+#endif
+   fake_scan_hists();
    m_list_adc->Write("pix_adc", 1);
    m_list_cds->Write("pix_cds", 1);
    m_list_seed->Write("seed", 1);
@@ -1469,6 +1596,20 @@ void SupixAnly::Loop()
 
 //______________________________________________________________________
 void SupixAnly::Loop(Long64_t nentries)
+{
+   TRACE;
+   if (fChain == 0) return;
+   if (! m_booked)
+      Book();
+   if (m_nthreads > 1)
+      LoopMT(nentries);
+   else
+      LoopRange(0, nentries);
+}
+
+// fill entries [first, last); last = 0 for all
+//______________________________________________________________________
+void SupixAnly::LoopRange(Long64_t first, Long64_t nentries)
 {
    TRACE;
    //   In a ROOT session, you can do:
@@ -1499,7 +1640,6 @@ void SupixAnly::Loop(Long64_t nentries)
    Timer timer(__func__);
    timer.start();
  	
-	Double_t pix_rms[NROWS][NCOLS]; 
    Double_t cds_snr[NROWS][NCOLS];
    Double_t cds_snr_raw[NROWS][NCOLS];
    Double_t cds_output[NROWS][NCOLS];
@@ -1517,7 +1657,7 @@ void SupixAnly::Loop(Long64_t nentries)
 
 
    //For  SNR  noise average
-   Double_t sigma_sum =0, sigma_mean=0;
+   Double_t sigma_mean=0;
    if (! m_booked)
       Book();
 
@@ -1528,44 +1668,51 @@ void SupixAnly::Loop(Long64_t nentries)
    // before starting the global loop
    //
    ULong64_t frame_last = 0;	// of last triged event
+   // dTevt of the first triged event of a range by LoopMT(), unknown here
+   bool frame_known = first == 0;
 
    unsigned long nconsecutives = 0;	// consecutive trigs
    unsigned long nhits = 0;		// real trig
+   m_frame_first = 0;
    Long64_t nbytes = 0, nb = 0;
-   for (Long64_t jentry=0; jentry<nentries;jentry++) {
+   // fired pixels of triged frames only
+   begin_stage("Loop", BR_ALL & ~BR_PIXID, BR_PIXID);
+   for (Long64_t jentry=first; jentry<nentries;jentry++) {
       Long64_t ientry = LoadTree(jentry);
       if (ientry < 0) break;
-      nb = fChain->GetEntry(jentry);
+      nb = read_light(ientry);
+      if (true_trig(trig) )	nb += read_heavy(ientry);
       nbytes += nb;
       // if (Cut(ientry) < 0) continue;
       //--------------------------------------->> start here
 
       // for each new tree
-      if (ientry == 0) {
+      if (ientry == 0 || jentry == first) {
 	 m_runinfo = (RunInfo*)fChain->GetTree()->GetUserInfo()->At(0);
+	 calibrate();
       }
+      const calib_t &cal = m_calib;
       
       adc_t*	padc = (adc_t*)pixel_adc;
       cds_t*	pcds = (cds_t*)pixel_cds;
-      double	cds_x = m_runinfo->trig_cds_x;
-      double*	pthr = (double*)(m_runinfo->trig_cds);
-      double*	pcds_mean = (double*)(m_runinfo->cds_mean);
-      double*	pcds_sigma = (double*)(m_runinfo->cds_sigma);
-      double*	padc_mean = (double*)(m_runinfo->adc_mean);
-      double*	padc_sigma = (double*)(m_runinfo->adc_sigma);
       double	cds_cor, adc_cor;
       double	chi2_cds = 0;
       double	chi2_trig = 0;
+#ifdef ALLPIXS
+      m_dense_cds->fill( (const int*)pixel_cds);	// whole frame
+      m_dense_adc->fill( (const unsigned short*)pixel_adc);
+#endif
 #ifdef DEBUG
       LOG << "DEBUG"
 	  << " ientry=" << ientry
 	  << " runinfo=" << m_runinfo
-	  << " *pcds_mean=" << *pcds_mean
-	  << " *pcds_sigma=" << *pcds_sigma
+	  << " cds_mean=" << cal.cds_mean[0]
+	  << " cds_sigma=" << cal.cds_sigma[0]
 	  << endl;
 #endif
       for (int i=0; i < NROWS; i++) {//+++++++++++++++++++++++++++++++++start a frame
 	 for (int j=0; j < NCOLS; j++) {
+		 int p = i*NCOLS + j;
 
 		 cds_output_raw[i][j] = *pcds;
 		 adc_output_raw[i][j] = *padc;
@@ -1574,19 +1721,16 @@ void SupixAnly::Loop(Long64_t nentries)
 		//Non-normalized frame output --Long LI
 		cds_output[i][j] = *pcds;
 
-		//Non-normalized CDS
-		m_cds[i][j] ->Fill(*pcds);		
+		//Non-normalized CDS: m_dense_cds
 		// CDS profile
 	   if( j > 7){   // for Half matrix --LongLI 21-10-23
 	  	 m_cds_frame_raw->Fill(NROWS*j + i, *pcds);
 	    m_cds_frame_cor->Fill(NROWS*j + i, cds_cor);
 		}
-		cds_cor /= *pcds_sigma;		// normalized
-	    adc_cor = *padc - *padc_mean;
+		cds_cor *= cal.inv_cds_sigma[p];		// normalized
+	    adc_cor = *padc - cal.adc_mean[p];
 	   
 		// fill the hitmap half matrix -- LongLI 2021-10-28
-		
-		pix_rms[i][j] = *pcds_sigma;		
 
 
 		// ADC profile
@@ -1594,7 +1738,7 @@ void SupixAnly::Loop(Long64_t nentries)
 	    m_adc_frame_raw->Fill(NROWS*j + i, *padc);
 	    m_adc_frame_cor->Fill(NROWS*j + i, adc_cor);
 		}
-		 adc_cor /= *padc_sigma;		// normalized
+		 adc_cor *= cal.inv_adc_sigma[p];		// normalized
 	    chi2_cds += cds_cor * cds_cor;
 #ifdef ALLPIXS
 	    // m_cds[i][j]->Fill( *pcds );
@@ -1603,8 +1747,7 @@ void SupixAnly::Loop(Long64_t nentries)
 //		m_cds[i][j]->Fill(cds_cor);
 		cds_snr[i][j] = cds_cor;
 		cds_snr_raw[i][j] = cds_cor;
-	    // m_adc[i][j]->Fill(*padc);
-	    m_adc[i][j]->Fill(*padc);
+	    // m_adc[i][j]->Fill(*padc);	m_dense_adc
 #endif
 	    // CDS
 	    m_cds_raw->Fill(*pcds);
@@ -1622,24 +1765,14 @@ void SupixAnly::Loop(Long64_t nentries)
 	 //   m_adc_frame_raw->Fill(NROWS*j + i, *padc);
 	 //   m_adc_frame_cor->Fill(NROWS*j + i, adc_cor);
 	    
-		// noise sum
-		sigma_sum += m_runinfo->cds_sigma[i][j];
-		// hitmap threshold
-	    
 		// next pixel
 	    padc++;
 	    pcds++;
-	    pthr++;
-	    pcds_mean++;
-	    pcds_sigma++;
-	    padc_mean++;
-	    padc_sigma++;
 	 }
       }//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~end a frame
 
 		//noise average
-		sigma_mean = sigma_sum/(NROWS*NCOLS);
-		sigma_sum =0;
+		sigma_mean = cal.sigma_mean;
 
 		// show the base line of the pixel output 
 		if(jentry ==1){
@@ -1671,14 +1804,14 @@ void SupixAnly::Loop(Long64_t nentries)
 	       int col = pixid[i] &  MASK_COL;
 	       m_hitmap_cds->Fill(col+0.5, row+0.5);
 
-	       double cds_cor = pixel_cds[row][col] - m_runinfo->cds_mean[row][col];
+	       double cds_cor = pixel_cds[row][col] - cal.cds_mean[pixid[i]];
 
 		   //save the fired pixel output for  not more than 25 pixels		   
 		   if(npixs < 26){
 			   pixel_fired[i] = -cds_output[row][col];
 			}
 
-	       cds_cor /= m_runinfo->cds_sigma[row][col];	// normalize by sigma
+	       cds_cor *= cal.inv_cds_sigma[pixid[i]];	// normalize by sigma
 	       m_trig_cds->Fill(pixel_cds[row][col]);
 	       cds_sum += cds_cor;
 		
@@ -1727,7 +1860,7 @@ void SupixAnly::Loop(Long64_t nentries)
 					if(i == seed_row+1 && j == seed_col){
 				
 						cds_snr[i][j] = (charge_correction(cds_output[seed_row][seed_col], cds_output[i][j]) -
-							m_runinfo->cds_mean[i][j])/(m_runinfo->cds_sigma[i][j]);
+							cal.cds_mean[i*NCOLS + j]) * cal.inv_cds_sigma[i*NCOLS + j];
 						cds_output[i][j] = charge_correction(cds_output[seed_row][seed_col], cds_output[i][j]);
 					}
 
@@ -1778,54 +1911,31 @@ void SupixAnly::Loop(Long64_t nentries)
 
 
 
-			double pix_rms[NROWS][NCOLS] = {0};
-
-			if(pix_rms[0][0] == 0){
-				ifstream fin("pixel_noise/a0_pixel_noise.txt");
-				if(!fin.is_open()){
-					cout<<"Fail to open the noise file!"<<endl;
-					exit(-1);
-				}
-				
-				for(int i=0; i<NROWS; i++){
-					for(int j=0; j<NCOLS; j++){
-						fin>>pix_rms[i][j];
-					}
-				}
-				fin.close();
-			}	
+			// noise of pixel_noise/, read once per analysis
+			const double *inv_rms = pix_rms_inv();
 		
 		// for fake-hit   LongLI 2021-11-03
-		bool over_thr[20] = {0};
-		bool over_thr_def[20] = {0};
+		// max SNR of the frame once: a threshold is fired if max >= it
+		double snr_rms[NPIXS/2], snr_def[NPIXS/2];
+		int nhalf = 0;
 		for(int i=0; i<NROWS; i++){
 			for(int j=0; j<NCOLS; j++){
 				if(j < 8) continue;
-				m_snr_allpix->Fill(-cds_output[i][j]/pix_rms[i][j]);	
-				m_snr_def->Fill(-cds_snr[i][j]);
-				
-				for(int k=0; k<20; k++){
-					if(-cds_output[i][j]/pix_rms[i][j] >= k ){
-						over_thr[k] = true;	
-					}
-					if(-cds_snr[i][j] >=k ){
-						over_thr_def[k] = true;
-					}	
-				}
+				snr_rms[nhalf] = -cds_output[i][j]*inv_rms[i*NCOLS + j];
+				snr_def[nhalf] = -cds_snr[i][j];
+				m_snr_allpix->Fill(snr_rms[nhalf]);	
+				m_snr_def->Fill(snr_def[nhalf]);
+				nhalf++;
 			}
 				
 		}
+		double max_rms = m_fake_scan->fill(snr_rms, nhalf);
+		double max_def = m_fake_scan_def->fill(snr_def, nhalf);
 
-		for(int k=0; k<20; k++){
-			if(over_thr[k] == true)
-				m_fake_frames->Fill(k);
-			
-			if(over_thr_def[k] == true)
-				m_fake_frames_def->Fill(k);
-
-			over_thr[k] == false;
-			over_thr_def[k] == false;
-		}
+		for(int k=0; k<20 && max_rms >= k; k++)
+			m_fake_frames->Fill(k);
+		for(int k=0; k<20 && max_def >= k; k++)
+			m_fake_frames_def->Fill(k);
 
 
 		m_frame_num->Fill(1);
@@ -1858,31 +1968,7 @@ void SupixAnly::Loop(Long64_t nentries)
 
 
 
-			// Mean of ADC_{normal pixel}   --LongLI 2021-10-24
-			double pix_mean_nor[100] = {
-		  		 0,0,0,0,0,0,0,0,0,0,                                                                                                         
-  				 0,0,0,5.46664,4.32249,4.30971,4.41694,4.6719,5.10492,5.0715,
-  				 5.58685,5.5901,5.62377,6.04017,6.02815,6.33619,6.55763,6.33782,6.80423,6.75667,
-  				 6.70185,6.8082,6.95955,6.73127,6.79323,6.86964,6.63521,6.51712,6.48791,6.35799,
-  				 6.23003,6.1698,5.94241,5.76254,5.64788,5.67928,5.66383,5.99773,5.98289,5.5885,
-  				 6.02573,5.94561,6.467,6.36298,6.57126,6.80028,6.85928,6.85512,7.05563,7.12313,
-  				 7.40827,7.42279,7.63819,7.70161,7.72629,7.75554,7.92468,7.92804,7.99664,7.96075,
-  				 8.14537,8.17192,8.14017,8.21287,8.20517,8.3405,8.4356,8.53593,8.51158,8.59353,
-  				 8.73125,8.73658,8.60807,8.97186,8.96729,8.98774,9.03495,9.16369,9.1426,9.24362,
- 				 9.37923,9.42668,9.53806,9.4106,9.74709,9.80555,9.91234,9.85703,9.81151,9.89866
-			};
-			double pix_mean_cor[100] = {
-				 0,0,0,0,0,0,0,0,0,0,                                                                                                         
-  				 0,0,0,1.32152,2.79376,2.28484,2.95986,3.1873,3.21223,4.04305,
-  				 3.40222,3.99839,4.47288,4.51717,4.84964,5.06274,4.59626,4.9941,4.67707,5.07054,
-  				 4.98284,5.11267,4.53954,5.07006,5.23708,5.07674,5.21115,4.98198,5.30596,4.69664,
-  				 3.9978,3.9801,4.39313,4.27648,4.27723,3.66075,4.02171,3.97604,3.8803,4.28023,
-  				 4.29398,4.36328,4.80771,4.82283,4.86522,4.90933,5.29831,5.63844,5.84625,5.74713,
-  				 5.7366,6.32607,6.37832,6.4796,6.47173,6.58061,6.66941,6.80146,6.29387,6.78597,
-  				 6.93655,6.63726,7.08871,7.00549,7.24587,7.25348,7.38817,7.53857,7.32099,7.53989,
-  				 7.63595,7.82506,8.0588,7.51866,7.39809,7.81781,7.86724,7.70332,8.32736,8.10022,
- 				 8.38531,8.71637,8.52362,8.76948,9.10689,8.6232,8.6507,9.00265,9.15226,9.29647
-			};
+			// Mean of ADC_{normal pixel}: g_pix_mean_nor, g_pix_mean_cor
 
 			// profile of the normal pixel --LongLI 2021-10-20
 			double pix_diff = 0;
@@ -1900,7 +1986,7 @@ void SupixAnly::Loop(Long64_t nentries)
 
 				for(int i=0; i<100; i++){
 					if(seedpix > i && seedpix <= i+1){
-						pix_diff = pix_mean_cor[i] - pix_mean_nor[i];
+						pix_diff = g_pix_mean_cor[i] - g_pix_mean_nor[i];
 					}
 				}
 
@@ -1986,22 +2072,14 @@ void SupixAnly::Loop(Long64_t nentries)
 
 
 
-			//find the most significant charge contribution pixels
-			sort(snr25_raw, snr25_raw+25);
+			//find the most significant charge contribution pixels: 5x5 by SNR
+			int order25[25];
+			for(int k =0; k <25; k++) order25[k] = k;
+			sort(order25, order25+25, [&](int a, int b) { return snr25_raw[a] < snr25_raw[b]; });
 			int matrix_row[25] = {0}, matrix_col[25] = {0};
 			for(int k =0; k <25; k++){
-				for(int i =0; i<5; i++){
-					for(int j=0; j<5; j++){
-						if(cds_snr_raw[seed_row + i -2][seed_col + j -2] == snr25_raw[k]){
-							matrix_row[k] = i;
-						    matrix_col[k] = j;	
-						}
-						
-					}
-
-				}
-				
-
+				matrix_row[k] = order25[k] / 5;
+				matrix_col[k] = order25[k] % 5;
 			}
 
 			for(int i = 0; i<25; i++){
@@ -2098,9 +2176,9 @@ void SupixAnly::Loop(Long64_t nentries)
 
 				
 				row_9 = mat9_row[i]; col_9 = mat9_col[i];
-				noise_single = m_runinfo->cds_sigma[row_9][col_9];
+				noise_single = cal.cds_sigma[row_9*NCOLS + col_9];
 //				cout<<"DEBUG: _9 "<<i<<" ROW: "<<row_9<<" COL "
-//					<<col_9<<" SIGMA: "<<m_runinfo->cds_sigma[row_9][col_9]<<endl;
+//					<<col_9<<" SIGMA: "<<cal.cds_sigma[row_9*NCOLS + col_9]<<endl;
 
 				noise_cum2 += noise_single*noise_single;
 				snr_9 = sum_9/(sqrt(noise_cum2));
@@ -2134,7 +2212,7 @@ void SupixAnly::Loop(Long64_t nentries)
 					m_clst_q[1]->Fill(i+1, sum_9);
 
 
-					noise_single = m_runinfo->cds_sigma[row_9][col_9];
+					noise_single = cal.cds_sigma[row_9*NCOLS + col_9];
 					noise_cum2 += noise_single*noise_single;
 					snr_9 = sum_9/(sqrt(noise_cum2));
 					m_clst_snr[1] ->Fill(i+1, snr_9);
@@ -2143,7 +2221,7 @@ void SupixAnly::Loop(Long64_t nentries)
 					if(-cds_snr[row_9][col_9] > k+2){
 						sum_fix += -cds_output[row_9][col_9];
 
-						noise_single = m_runinfo->cds_sigma[row_9][col_9];
+						noise_single = cal.cds_sigma[row_9*NCOLS + col_9];
 						noise_fix += noise_single*noise_single;
 						snr_fix = sum_fix/sqrt(noise_fix);
 						size_fix++;
@@ -2183,7 +2261,7 @@ void SupixAnly::Loop(Long64_t nentries)
 					if(row_9 != -1 && col_9 != -1){
 						sum_9 += -cds_output[row_9][col_9];
 
-						noise_single = m_runinfo->cds_sigma[row_9][col_9];
+						noise_single = cal.cds_sigma[row_9*NCOLS + col_9];
 						noise_cum2 += noise_single*noise_single;
 						snr_9 = sum_9/(sqrt(noise_cum2));
 						snr_cum[k][i] = -snr_9;	
@@ -2242,7 +2320,6 @@ void SupixAnly::Loop(Long64_t nentries)
 		// copy the raw pixel
 	double cds_cpy[NROWS][NCOLS], snr_cpy[NROWS][NCOLS];
 	int firemax[20];
-	int firecnt = 0;	
 	int row_alg[20][49], col_alg[20][49];
 	// extrapolation
 	int num_alg =0;
@@ -2401,148 +2478,185 @@ void SupixAnly::Loop(Long64_t nentries)
 
 		
 		// start to extrapolation   LongLI 2021.12.23		
-		
+		// clusters of the 20 thresholds 0.2*k+1: by default the 3-hop growth
+		// from the seed's 3x3 of earlier productions; with set_cluster_sweep()
+		// the full 8-connected components in the 7x7 around the seed, in one sweep
 		bool row01 = false;	
-		double cds_cpy2[NROWS][NCOLS], snr_cpy2[NROWS][NCOLS];
-		for(int k =0; k<20; k++){
+		if(m_cluster_sweep){
+			double sweep_snr[NPIXS], sweep_charge[NPIXS], sweep_noise[NPIXS];
+			for(int k=0; k<20; k++) firemax[k] = 0;
+			for(int p=0; p<NPIXS; p++){
+				int i = p / NCOLS, j = p % NCOLS;
+				bool in = abs(i - seed_row) <= 3 && abs(j - seed_col) <= 3;
+				sweep_snr[p] = in ? -cds_snr[i][j] : -1e30;
+				sweep_charge[p] = -cds_output[i][j];
+				sweep_noise[p] = cal.cds_sigma[p];
+				if(j < 8) continue;
+				for(int k=0; k<20 && -cds_snr[i][j] > 0.2*k+1; k++) firemax[k]++;
+			}
+			m_sweep->run(sweep_snr, sweep_charge, sweep_noise, seed_row*NCOLS + seed_col);
+
+			// members by SNR; none next to rows 0-1 or the left half (col 15 at cut 3)
+			for(int k=0; k<20; k++){
+				const sweep_cluster_t &clu = m_sweep->get_cluster(k);
+				int pix[49];
+				int n = m_sweep->get_members(k, pix, 49);
+				for(int i=0; i<49; i++){
+					row_alg[k][i] = i < n ? pix[i] / NCOLS : -1;
+					col_alg[k][i] = i < n ? pix[i] % NCOLS : -1;
+				}
+				if(n && (clu.row_min < 3 || clu.col_min < 9 || (k == 10 && clu.col_max == NCOLS-1)))
+					row01 = true;
+			}
+		}
+		else{
+			int firecnt = 0;
+			double cds_cpy2[NROWS][NCOLS], snr_cpy2[NROWS][NCOLS];
+			for(int k =0; k<20; k++){
 			
-			// copy the pixels
-			for(int i=0; i<NROWS; i++){
-				for(int j=0; j<NCOLS; j++){
+				// copy the pixels
+				for(int i=0; i<NROWS; i++){
+					for(int j=0; j<NCOLS; j++){
 					
-					 cds_cpy2[i][j] = cds_output[i][j];
-					 snr_cpy2[i][j] = cds_snr[i][j];
+						 cds_cpy2[i][j] = cds_output[i][j];
+						 snr_cpy2[i][j] = cds_snr[i][j];
 					 
-					 if(-cds_snr[i][j] > 0.2*k+1){
-						if(j < 8) continue;	
-						firecnt++;							
+						 if(-cds_snr[i][j] > 0.2*k+1){
+							if(j < 8) continue;	
+							firecnt++;							
 						
+						}
 					}
 				}
-			}
-			firemax[k] = firecnt;
-			firecnt =0;
+				firemax[k] = firecnt;
+				firecnt =0;
 
 
-		for(int i=seed_row-1; i<=seed_row+1; i++){
-			for(int j=seed_col-1; j<=seed_col+1; j++){
-				//1st	
-				if(-snr_cpy2[i][j] > 0.2*k+1){
-					row_alg[k][num_alg] = i; 
-					col_alg[k][num_alg] = j;
-			   	num_alg++;
+			for(int i=seed_row-1; i<=seed_row+1; i++){
+				for(int j=seed_col-1; j<=seed_col+1; j++){
+					//1st	
+					if(-snr_cpy2[i][j] > 0.2*k+1){
+						row_alg[k][num_alg] = i; 
+						col_alg[k][num_alg] = j;
+				   	num_alg++;
 
-				  	row_cntr = i; col_cntr =j;
-				  	snr_cpy2[i][j] = 0;
+					  	row_cntr = i; col_cntr =j;
+					  	snr_cpy2[i][j] = 0;
 					
-					if(i<2 && k == 10){
-						row01 = true;
-						continue;
-					}
-
-				  for(int a =row_cntr-1; a<=row_cntr+1; a++){
-					  for(int b=col_cntr-1; b<=col_cntr+1; b++){
-						  if(a<2 || a>63 || b<8 || b>15 && k== 10){
-								row01 = true;
-							  	continue; // row0 row1 exclude
-						  }
-						  //2nd
-						  if(-snr_cpy2[a][b] > 0.2*k+1){
-							  row_alg[k][num_alg] = a;
-							  col_alg[k][num_alg] = b;
-							  num_alg++;
-
-							  row_cntr = a; col_cntr = b;
-							  snr_cpy2[a][b] = 0;
-
+						if(i<2 && k == 10){
+							row01 = true;
+							continue;
+						}
 
-							  for(int c =row_cntr-1; c<=row_cntr+1; c++){
-								  for(int d=col_cntr-1; d<=col_cntr+1; d++){
-									  if(c<2 || c>63 || d<8 || d>15 && k==10){
-											row01 = true;  
-											continue;
-										}
-									  //3rd
-									  if(-snr_cpy2[c][d]> 0.2*k+1){
-										  row_alg[k][num_alg] = c;
-										  col_alg[k][num_alg] = d;
-										  num_alg++;
-										  snr_cpy2[c][d] =0;
-									  }
+					  for(int a =row_cntr-1; a<=row_cntr+1; a++){
+						  for(int b=col_cntr-1; b<=col_cntr+1; b++){
+							  if(a<2 || a>63 || b<8 || b>15 && k== 10){
+									row01 = true;
+								  	continue; // row0 row1 exclude
+							  }
+							  //2nd
+							  if(-snr_cpy2[a][b] > 0.2*k+1){
+								  row_alg[k][num_alg] = a;
+								  col_alg[k][num_alg] = b;
+								  num_alg++;
+
+								  row_cntr = a; col_cntr = b;
+								  snr_cpy2[a][b] = 0;
+
+
+								  for(int c =row_cntr-1; c<=row_cntr+1; c++){
+									  for(int d=col_cntr-1; d<=col_cntr+1; d++){
+										  if(c<2 || c>63 || d<8 || d>15 && k==10){
+												row01 = true;  
+												continue;
+											}
+										  //3rd
+										  if(-snr_cpy2[c][d]> 0.2*k+1){
+											  row_alg[k][num_alg] = c;
+											  col_alg[k][num_alg] = d;
+											  num_alg++;
+											  snr_cpy2[c][d] =0;
+										  }
 									  
 									  
-								  }
+									  }
 							  
-							  }
+								  }
 
 
-						  }	
+							  }	
 					  
+						  }
 					  }
-				  }
 
 					  
-			  }
+				  }
 				  
 			  
+			  }
 		  }
-	  }
 			
 
-		//	cout<<"THRESHOLD: "<<k<<"\t SIZE: "<<num_alg<<endl;
-			num_alg = 0;
+			//	cout<<"THRESHOLD: "<<k<<"\t SIZE: "<<num_alg<<endl;
+				num_alg = 0;
 				
-	}
-
+		}
+		}
 
 	if(row01) continue;	
 		
-		num_alg =0;
-		int firealg[20];
-		double charge_alg[20][49] = {0}, snr_alg[20][49] = {0}, snr_alg_cpy[20][49]={0};	
+		if(m_cluster_sweep){
+			// pixels over each threshold left out of the cluster
+			for(int k=0; k<20; k++)
+				m_pxs_left[k]->Fill(firemax[k] - m_sweep->get_cluster(k).size);
+		}
+		else{
+			num_alg =0;
+			int firealg[20];
+			double charge_alg[20][49] = {0}, snr_alg[20][49] = {0}, snr_alg_cpy[20][49]={0};	
 		
-		for(int k=0; k<20; k++){
-			for(int i=0; i<49; i++){
-				if(row_alg[k][i] == -1 || col_alg[k][i] == -1) continue;
-				row_9 = row_alg[k][i]; col_9 = col_alg[k][i];
-				snr_alg[k][num_alg] = cds_snr[row_9][col_9]; 
-				snr_alg_cpy[k][num_alg] = cds_snr[row_9][col_9]; 
-				num_alg++;
+			for(int k=0; k<20; k++){
+				for(int i=0; i<49; i++){
+					if(row_alg[k][i] == -1 || col_alg[k][i] == -1) continue;
+					row_9 = row_alg[k][i]; col_9 = col_alg[k][i];
+					snr_alg[k][num_alg] = cds_snr[row_9][col_9]; 
+					snr_alg_cpy[k][num_alg] = cds_snr[row_9][col_9]; 
+					num_alg++;
+				}
+				firealg[k] = num_alg;
+				m_pxs_left[k]->Fill(firemax[k] - firealg[k]);
+				num_alg =0;
 			}
-			firealg[k] = num_alg;
-			m_pxs_left[k]->Fill(firemax[k] - firealg[k]);
-			num_alg =0;
-		}
 	
 
-		//reset the position infomation
-		int row_alg_cpy[20][49], col_alg_cpy[20][49];
-		for(int k=0; k<20; k++){
-			for(int i =0; i<49; i++){
-				row_alg_cpy[k][i] = row_alg[k][i];
-				col_alg_cpy[k][i] = col_alg[k][i];
-				row_alg[k][i] = -1;
-				col_alg[k][i] = -1;
+			//reset the position infomation
+			int row_alg_cpy[20][49], col_alg_cpy[20][49];
+			for(int k=0; k<20; k++){
+				for(int i =0; i<49; i++){
+					row_alg_cpy[k][i] = row_alg[k][i];
+					col_alg_cpy[k][i] = col_alg[k][i];
+					row_alg[k][i] = -1;
+					col_alg[k][i] = -1;
+				}
 			}
-		}
 
-		// pixel ordering by SNR
-		for(int k=0; k<20; k++){
-			sort(snr_alg[k], snr_alg[k]+49);
-			for(int i=0; i<49; i++){
-				if(snr_alg[k][i] ==0) continue;
-				for(int m=0; m<49; m++){
+			// pixel ordering by SNR
+			for(int k=0; k<20; k++){
+				sort(snr_alg[k], snr_alg[k]+49);
+				for(int i=0; i<49; i++){
+					if(snr_alg[k][i] ==0) continue;
+					for(int m=0; m<49; m++){
 
 
-					if(snr_alg_cpy[k][m] == snr_alg[k][i]){
-						row_alg[k][i] = row_alg_cpy[k][m]; 
-						col_alg[k][i] = col_alg_cpy[k][m]; 
-					}
+						if(snr_alg_cpy[k][m] == snr_alg[k][i]){
+							row_alg[k][i] = row_alg_cpy[k][m]; 
+							col_alg[k][i] = col_alg_cpy[k][m]; 
+						}
 				
-				}
-			}	
+					}
+				}	
+			}
 		}
-				
 
 
 		// ADC sum and  SNR
@@ -2558,7 +2672,7 @@ void SupixAnly::Loop(Long64_t nentries)
 				num_alg++;
 				m_sum_alg[k]->Fill(num_alg, sum_9);
 
-				noise_single = m_runinfo->cds_sigma[row_9][col_9];
+				noise_single = cal.cds_sigma[row_9*NCOLS + col_9];
 				noise_cum2 += noise_single*noise_single;
 				snr_9 = sum_9/sqrt(noise_cum2);
 				m_snr_alg[k]->Fill(num_alg, snr_9);
@@ -3137,7 +3251,7 @@ void SupixAnly::Loop(Long64_t nentries)
 		
 				c_sum = -cds_output[seed_row][seed_col];
 
-				c_noise_s = m_runinfo->cds_sigma[seed_row][seed_col];
+				c_noise_s = cal.cds_sigma[seed_row*NCOLS + seed_col];
 				c_noise_c = sqrt(c_noise_s * c_noise_s);
 
 				c_snr_c = c_sum/c_noise_c;
@@ -3203,8 +3317,11 @@ void SupixAnly::Loop(Long64_t nentries)
 	    m_npixs->Fill(npixs);
 	    m_trig_cds_sum->Fill(cds_sum);
 	    m_trig_cds_npixs->Fill(cds_sum, npixs);
-	    m_dTevt->Fill((double)(frame - frame_last) );
-	    if (1 == frame - frame_last) {
+	    if (! frame_known)
+	       m_frame_first = frame;
+	    else
+	       m_dTevt->Fill((double)(frame - frame_last) );
+	    if (frame_known && 1 == frame - frame_last) {
 	       nconsecutives++;
 	       if (nconsecutives % 100 == 1) {
 		  cout << "DEBUG"
@@ -3217,14 +3334,15 @@ void SupixAnly::Loop(Long64_t nentries)
 		  for (int i=0; i < npixs; i++) {
 		     int row = pixid[i] >> NBITS_COL;
 		     int col = pixid[i] &  MASK_COL;
-		     double cds_cor = pixel_cds[row][col] - m_runinfo->cds_mean[row][col];
-		     cds_cor /= m_runinfo->cds_sigma[row][col];	// normalize by sigma
+		     double cds_cor = pixel_cds[row][col] - cal.cds_mean[row*NCOLS + col];
+		     cds_cor *= cal.inv_cds_sigma[row*NCOLS + col];	// normalize by sigma
 		     cout << " [" << row << " " << col << " " << cds_cor << "]";
 		  }
 		  cout << endl;
 	       }
 	    }
 	    frame_last = frame;
+	    frame_known = true;
 	 }
       }
 
@@ -3239,8 +3357,12 @@ void SupixAnly::Loop(Long64_t nentries)
 	      << endl;
    }
 
+   end_stage();
+   m_nhits		= nhits;
+   m_nconsecutives	= nconsecutives;
+   m_frame_last		= frame_last;
    cout << __PRETTY_FUNCTION__ << " END:"
-	<< " Total entries = " << nentries
+	<< " Total entries = " << nentries - first
 	<< " nhits=" << nhits
 	<< " nconsecutives=" << nconsecutives
 	<< endl;
@@ -3250,6 +3372,936 @@ void SupixAnly::Loop(Long64_t nentries)
    // fChain->GetUserInfo()->Dump();
 }
 
+// a thread of LoopMT()
+typedef struct anly_worker_t
+{
+   SupixAnly *	anly;
+   TChain *	chain;
+   Long64_t	first;
+   Long64_t	last;
+}
+   anly_worker_t
+   ;
+
+static void * anly_worker(void *arg)
+{
+   anly_worker_t *w = (anly_worker_t*)arg;
+   w->anly->LoopRange(w->first, w->last);
+   return NULL;
+}
+
+// a new chain of the same files, as a TChain is not shared by threads
+//______________________________________________________________________
+TChain * SupixAnly::clone_chain()
+{
+   TChain *chain = new TChain(fChain->GetName() );
+   if (fChain->InheritsFrom(TChain::Class() ) )
+      chain->Add( (TChain*)fChain);
+   else
+      chain->Add(fChain->GetCurrentFile()->GetName() );
+   return chain;
+}
+
+// analyses of the same files with histograms booked, not in any directory
+//______________________________________________________________________
+void SupixAnly::new_workers(int n, std::vector<SupixAnly*> &anly, std::vector<TChain*> &chain)
+{
+   TDirectory *cwd = gDirectory;
+   bool adddir = TH1::AddDirectoryStatus();
+   TH1::AddDirectory(kFALSE);
+   // empty: Book() deletes objects of the same names in gDirectory
+   gROOT->mkdir("SupixAnly_workers")->cd();
+   for (int k=0; k < n; k++) {
+      chain.push_back(clone_chain() );
+      anly.push_back(new SupixAnly(chain.back() ) );
+      anly.back()->set_cache(m_cache_size, m_cache_learn);
+      anly.back()->set_open_ahead(m_open_ahead);
+      anly.back()->set_fake_grid(m_fake_xmin, m_fake_step, m_fake_nbins);
+      anly.back()->set_cluster_sweep(m_cluster_sweep);
+      anly.back()->Book();
+   }
+   cwd->cd();
+   gROOT->rmdir("SupixAnly_workers");
+   TH1::AddDirectory(adddir);
+}
+
+void SupixAnly::delete_workers(std::vector<SupixAnly*> &anly, std::vector<TChain*> &chain)
+{
+   for (size_t k=0; k < anly.size(); k++) {
+      anly[k]->delete_hists();
+      delete anly[k];
+      delete chain[k];
+   }
+   anly.clear();
+   chain.clear();
+}
+
+// entries in contiguous ranges on m_nthreads threads, each with its own
+// chain and histograms; merged in the order of ranges, i.e. independent
+// of thread scheduling.
+// - dTevt of the first triged event of a range against the last one of
+//   the ranges before, as the serial loop.
+//______________________________________________________________________
+void SupixAnly::LoopMT(Long64_t nentries)
+{
+   TRACE;
+   Timer timer(__func__);
+   timer.start();
+
+   Long64_t ntot = fChain->GetEntries();
+   if (nentries <= 0 || nentries > ntot)
+      nentries = ntot;
+   int n = m_nthreads;
+   if (n > nentries)	n = nentries > 0 ? nentries : 1;
+
+   ROOT::EnableThreadSafety();
+   vector<SupixAnly*> anly;
+   vector<TChain*> chain;
+   new_workers(n, anly, chain);
+   if (m_dense_cds)		// resident: the pages filled only
+      LOG << n << " workers, histograms of "
+	  << (m_dense_cds->get_bytes() + m_dense_adc->get_bytes() ) / 1048576.
+	  << " MB mapped each" << endl;
+
+   // stage "Loop" of the workers as one: sums, disk & wall time of all
+   io_stage_t io;
+   memset(&io, 0, sizeof(io) );
+   io.name	= "Loop";
+   io.tree	= -1;
+   io.disk0	= TFile::GetFileBytesRead();
+   io.calls0	= TFile::GetFileReadCalls();
+   io.t0	= timer_now_ns();
+
+   vector<anly_worker_t> w(n);
+   vector<pthread_t> tid(n);
+   for (int k=0; k < n; k++) {
+      w[k].anly		= anly[k];
+      w[k].chain	= chain[k];
+      w[k].first	= nentries * k / n;
+      w[k].last		= nentries * (k+1) / n;
+      int err = pthread_create(&tid[k], NULL, anly_worker, &w[k]);
+      if (err) {
+	 LOG << "pthread_create: " << strerror(err) << endl;
+	 exit(-1);
+      }
+   }
+   for (int k=0; k < n; k++)
+      pthread_join(tid[k], NULL);
+   io.sec	= (timer_now_ns() - io.t0) * 1e-9;
+   io.disk	= TFile::GetFileBytesRead() - io.disk0;
+   io.calls	= TFile::GetFileReadCalls() - io.calls0;
+   for (int k=0; k < n; k++) {
+      if (anly[k]->m_io.empty() )	continue;
+      const io_stage_t &wio = anly[k]->m_io.back();
+      io.light	 = wio.light;
+      io.heavy	 = wio.heavy;
+      io.entries += wio.entries;
+      io.nheavy	+= wio.nheavy;
+      io.bytes	+= wio.bytes;
+   }
+   m_io.push_back(io);		// print_io() of the caller
+
+   unsigned long nhits = 0, nconsecutives = 0;
+   ULong64_t frame_last = 0;
+   for (int k=0; k < n; k++) {
+      Merge(anly[k]);
+      if (! anly[k]->m_nhits)	continue;
+      if (k > 0) {
+	 ULong64_t frame = anly[k]->m_frame_first;
+	 m_dTevt->Fill((double)(frame - frame_last) );
+	 if (1 == frame - frame_last)	nconsecutives++;
+      }
+      nhits		+= anly[k]->m_nhits;
+      nconsecutives	+= anly[k]->m_nconsecutives;
+      frame_last	 = anly[k]->m_frame_last;
+   }
+   delete_workers(anly, chain);
+   m_nhits		= nhits;
+   m_nconsecutives	= nconsecutives;
+   m_frame_last		= frame_last;
+
+   cout << __PRETTY_FUNCTION__ << " END:"
+	<< " Total entries = " << nentries
+	<< " threads=" << n
+	<< " nhits=" << nhits
+	<< " nconsecutives=" << nconsecutives
+	<< endl;
+   timer.stop();
+   timer.print(1);
+}
+
+// histogram lists filled by Loop(), in the order booked
+//______________________________________________________________________
+std::vector<TList*> SupixAnly::get_lists()
+{
+   TList * lists[] = {
+      m_list_adc, m_list_cds, m_list_misc, m_list_seed, m_list_shape
+      , m_list_correction, m_list_matrix, m_list_cluster_rec, m_list_cluster_opt
+      , m_list_cluster_alg, m_list_cluster_anal, m_list_special_evt, m_list_multievt
+      , m_list_correction_estimation, m_list_spatial_resolution, m_list_hitmap_thres
+      , m_list_fake_hit, m_list_pix_snr, m_list_cluster_size, m_list_hit
+   };
+   return std::vector<TList*>(lists, lists + sizeof(lists)/sizeof(TList*) );
+}
+
+// add histograms of another analysis booked alike, each once
+//______________________________________________________________________
+void SupixAnly::Merge(SupixAnly *o)
+{
+   if (m_dense_cds && o->m_dense_cds) {
+      m_dense_cds->add(*o->m_dense_cds);
+      m_dense_adc->add(*o->m_dense_adc);
+   }
+   if (m_fake_scan && o->m_fake_scan) {
+      m_fake_scan->add(*o->m_fake_scan);
+      m_fake_scan_def->add(*o->m_fake_scan_def);
+   }
+   std::vector<TList*> mine = get_lists(), theirs = o->get_lists();
+   std::set<TObject*> done;
+   for (size_t i=0; i < mine.size(); i++) {
+      TIter it1(mine[i]), it2(theirs[i]);
+      TObject *h1, *h2;
+      while ( (h1 = it1()) && (h2 = it2()) ) {
+	 if (! h1->InheritsFrom(TH1::Class() ) || ! done.insert(h1).second)	continue;
+	 ((TH1*)h1)->Add( (TH1*)h2);
+      }
+   }
+}
+
+// max |difference| of bin contents & entries to another analysis booked alike
+//______________________________________________________________________
+double SupixAnly::Compare(SupixAnly *o)
+{
+   std::vector<TList*> mine = get_lists(), theirs = o->get_lists();
+   double dmax = 0;
+   int ndiff = 0;
+   if (m_dense_cds && o->m_dense_cds) {
+      DenseHist *d1[2] = { m_dense_cds, m_dense_adc }, *d2[2] = { o->m_dense_cds, o->m_dense_adc };
+      for (int h=0; h < 2; h++) {
+	 for (int p=0; p < NPIXS; p++) {
+	    double d = fabs( (double)d1[h]->get_entries() - d2[h]->get_entries() );
+	    for (int b=0; b <= d1[h]->get_nbins() + 1; b++)
+	       d = max(d, fabs( (double)d1[h]->get_bin(p, b) - d2[h]->get_bin(p, b) ) );
+	    if (d > 0)	ndiff++;
+	    dmax = max(dmax, d);
+	 }
+      }
+   }
+   for (size_t i=0; i < mine.size(); i++) {
+      TIter it1(mine[i]), it2(theirs[i]);
+      TObject *o1, *o2;
+      while ( (o1 = it1()) && (o2 = it2()) ) {
+	 if (! o1->InheritsFrom(TH1::Class() ) )	continue;
+	 TH1 *h1 = (TH1*)o1, *h2 = (TH1*)o2;
+	 double d = fabs(h1->GetEntries() - h2->GetEntries() );
+	 for (int b=0; b < h1->GetNcells(); b++)
+	    d = max(d, fabs(h1->GetBinContent(b) - h2->GetBinContent(b) ) );
+	 if (d > 0)	ndiff++;
+	 dmax = max(dmax, d);
+      }
+   }
+   if (ndiff)	LOG << ndiff << " histograms differ, max " << dmax << endl;
+   return dmax;
+}
+
+void SupixAnly::delete_hists()
+{
+   std::vector<TList*> lists = get_lists();
+   std::set<TObject*> hists;
+   for (size_t i=0; i < lists.size(); i++) {
+      TIter it(lists[i]);
+      while (TObject *h = it() )
+	 hists.insert(h);
+      lists[i]->Clear();
+   }
+   for (std::set<TObject*>::iterator it = hists.begin(); it != hists.end(); ++it)
+      delete *it;
+}
+
+// time Loop() on each number of threads, checked against the first
+//______________________________________________________________________
+void SupixAnly::Scaling(Long64_t nentries, const std::vector<int> &nthreads)
+{
+   TRACE;
+   vector<SupixAnly*> ref, anly;
+   vector<TChain*> ref_chain, chain;
+   double tref = 0;		// sec of the first
+   cout << "threads\tsec\tentries_per_sec\tspeedup\tefficiency\tmax_diff" << endl;
+   for (size_t i=0; i < nthreads.size(); i++) {
+      new_workers(1, anly, chain);
+      anly[0]->set_nthreads(nthreads[i]);
+      unsigned long long t0 = timer_now_ns();
+      anly[0]->Loop(nentries);
+      double sec = (timer_now_ns() - t0) * 1e-9;
+      Long64_t n = nentries > 0 ? nentries : chain[0]->GetEntries();
+      double diff = 0;
+      if (i == 0) {
+	 tref = sec;
+	 ref.swap(anly);
+	 ref_chain.swap(chain);
+      }
+      else {
+	 diff = ref[0]->Compare(anly[0]);
+	 delete_workers(anly, chain);
+      }
+      cout << nthreads[i] << "\t" << sec << "\t" << n / sec
+	   << "\t" << tref / sec << "\t" << tref / sec * nthreads[0] / nthreads[i]
+	   << "\t" << diff << endl;
+   }
+   delete_workers(ref, ref_chain);
+}
+
+// inverse sigmas etc. of ri in pixel order
+//______________________________________________________________________
+void SupixAnly::make_calib(const RunInfo *ri, calib_t &c)
+{
+   c.runinfo = ri;
+   double sigma_sum = 0;
+   for (int i=0; i < NROWS; i++) {
+      for (int j=0; j < NCOLS; j++) {
+	 int p = i*NCOLS + j;
+	 c.cds_mean[p]		= ri->cds_mean[i][j];
+	 c.cds_sigma[p]		= ri->cds_sigma[i][j];
+	 c.inv_cds_sigma[p]	= 1. / ri->cds_sigma[i][j];
+	 c.adc_mean[p]		= ri->adc_mean[i][j];
+	 c.inv_adc_sigma[p]	= 1. / ri->adc_sigma[i][j];
+	 sigma_sum += ri->cds_sigma[i][j];
+      }
+   }
+   c.sigma_mean = sigma_sum / NPIXS;
+}
+
+// once per tree; keyed on the tree number, the RunInfo of the next file
+// may well reuse the address of the last one
+const calib_t & SupixAnly::calibrate()
+{
+   Int_t tree = fChain->GetTreeNumber();
+   if (m_runinfo && tree != m_calib_tree) {
+      make_calib(m_runinfo, m_calib);
+      m_calib_tree = tree;
+   }
+   return m_calib;
+}
+
+const double * SupixAnly::pix_rms_inv()
+{
+   if (m_pix_rms_inv.size() )
+      return &m_pix_rms_inv[0];
+   ifstream fin("pixel_noise/a0_pixel_noise.txt");
+   if(!fin.is_open()){
+      cout<<"Fail to open the noise file!"<<endl;
+      exit(-1);
+   }
+   m_pix_rms_inv.resize(NPIXS);
+   for (int p=0; p < NPIXS; p++) {
+      double rms = 0;
+      fin >> rms;
+      m_pix_rms_inv[p] = 1. / rms;
+   }
+   fin.close();
+   return &m_pix_rms_inv[0];
+}
+
+//______________________________________________________________________
+SupixIndex * SupixAnly::get_index()
+{
+   if (! m_index) {
+      m_index = new SupixIndex(fChain);
+      m_index->Build(m_nthreads);
+   }
+   return m_index;
+}
+
+//======================================================================
+// derived quantities as Loop() computes them
+//______________________________________________________________________
+// in derived/ beside the file, out of the way of pattern*.root
+string SupixAnly::derived_name(const string &file)
+{
+   size_t n = file.rfind(".root");
+   string base	= n == string::npos ? file : file.substr(0, n);
+   size_t slash	= base.rfind('/');
+   string dir	= slash == string::npos ? string("derived") : base.substr(0, slash) + "/derived";
+   return dir + "/" + base.substr(slash + 1) + "-derived.root";
+}
+
+void SupixAnly::derive_frame(const calib_t &cal, const Int_t cds[NROWS][NCOLS], const UShort_t *pixid
+			     , int npixs, int trig, derived_t &d)
+{
+   memset(&d, 0, sizeof(d) );
+   double chi2_cds = 0;
+   for (int i=0; i < NROWS; i++) {
+      for (int j=0; j < NCOLS; j++) {
+	 double snr = cds[i][j] * cal.inv_cds_sigma[i*NCOLS + j];
+	 chi2_cds += snr * snr;
+      }
+   }
+   d.chi2_cds = chi2_cds;
+   if (! (trig > 1 && trig < TRIG_PRE) )	return;
+
+   // seed: starting at (0,0) as Loop()
+   int seed_row = 0, seed_col = 0;
+   double fired_sum = 0;
+   for (int i=0; i < npixs; i++) {
+      int row = pixid[i] >> NBITS_COL;
+      int col = pixid[i] &  MASK_COL;
+      if (cds[row][col] * cal.inv_cds_sigma[pixid[i]]
+	  < cds[seed_row][seed_col] * cal.inv_cds_sigma[seed_row*NCOLS + seed_col]) {
+	 seed_row = row;
+	 seed_col = col;
+      }
+      fired_sum += -cds[row][col];
+   }
+   d.seed_row	= seed_row;
+   d.seed_col	= seed_col;
+   d.fired_sum	= fired_sum;
+   d.roi	= seed_row > 1 && seed_row < 63 && seed_col > 8 && seed_col < 14;
+   if (! d.roi)	return;
+
+   int k = 0;
+   for (int i = seed_row-2; i <= seed_row+2; i++) {
+      for (int j = seed_col-2; j <= seed_col+2; j++) {
+	 d.cds25[k] = cds[i][j];
+	 d.snr25[k] = cds[i][j] * cal.inv_cds_sigma[i*NCOLS + j];
+	 k++;
+      }
+   }
+   double cor = charge_correction(cds[seed_row][seed_col], cds[seed_row+1][seed_col]);
+   d.cor_cds = cor;
+   int below = (seed_row+1)*NCOLS + seed_col;
+   d.cor_snr = (cor - cal.cds_mean[below]) * cal.inv_cds_sigma[below];
+}
+
+// friend tree of a data file
+static bool derive_file(const string &name, const string &tree)
+{
+   TFile *file = TFile::Open(name.c_str(), "READ");
+   if (! file || file->IsZombie() ) {
+      LOG << name << ": can't open" << endl;
+      delete file;
+      return false;
+   }
+   TTree *t = 0;
+   file->GetObject(tree.c_str(), t);
+   RunInfo *ri = t ? (RunInfo*)t->GetUserInfo()->At(0) : 0;
+   if (! ri) {
+      LOG << name << ": no tree " << tree << " or RunInfo" << endl;
+      delete file;
+      return false;
+   }
+   Int_t	pixel_cds[NROWS][NCOLS];
+   UShort_t	pixid[NPIXS];
+   UShort_t	npixs;
+   UChar_t	trig;
+   t->SetBranchStatus("*", 0);
+   t->SetBranchStatus("pixel_cds", 1);
+   t->SetBranchStatus("pixid", 1);
+   t->SetBranchStatus("npixs", 1);
+   t->SetBranchStatus("trig", 1);
+   t->SetBranchAddress("pixel_cds", pixel_cds);
+   t->SetBranchAddress("pixid", pixid);
+   t->SetBranchAddress("npixs", &npixs);
+   t->SetBranchAddress("trig", &trig);
+
+   string dname = SupixAnly::derived_name(name);
+   string ddir	= dname.substr(0, dname.rfind('/') );
+   if (mkdir(ddir.c_str(), 0755) < 0 && errno != EEXIST)
+      LOG << ddir << ": " << strerror(errno) << endl;
+   TFile *out = TFile::Open(dname.c_str(), "RECREATE");
+   if (! out || out->IsZombie() ) {
+      LOG << dname << ": can't create" << endl;
+      delete out;
+      delete file;
+      return false;
+   }
+   calib_t *cal = new calib_t;		// 40 kB, off the thread stack
+   SupixAnly::make_calib(ri, *cal);
+   derived_t d;
+   TTree *dt = new TTree("supix_derived", "derived per-frame quantities");
+   dt->Branch("chi2_cds",	&d.chi2_cds,	"chi2_cds/F");
+   dt->Branch("seed_row",	&d.seed_row,	"seed_row/b");
+   dt->Branch("seed_col",	&d.seed_col,	"seed_col/b");
+   dt->Branch("roi",		&d.roi,		"roi/b");
+   dt->Branch("fired_sum",	&d.fired_sum,	"fired_sum/F");
+   dt->Branch("cds25",		d.cds25,	"cds25[25]/F");
+   dt->Branch("snr25",		d.snr25,	"snr25[25]/F");
+   dt->Branch("cor_cds",	&d.cor_cds,	"cor_cds/F");
+   dt->Branch("cor_snr",	&d.cor_snr,	"cor_snr/F");
+
+   Long64_t nentries = t->GetEntries();
+   for (Long64_t i=0; i < nentries; i++) {
+      t->GetEntry(i);
+      if (npixs > NPIXS)	npixs = NPIXS;
+      SupixAnly::derive_frame(*cal, pixel_cds, pixid, npixs, trig, d);
+      dt->Fill();
+   }
+   out->Write();
+   delete out;		// dt too
+   delete file;
+   delete cal;
+   return true;
+}
+
+typedef struct derive_job_t
+{
+   vector<string> *	files;
+   string		tree;
+   size_t		next;
+   int			nok;
+   pthread_mutex_t	mutex;
+}
+   derive_job_t
+   ;
+
+static void * derive_worker(void *arg)
+{
+   derive_job_t *job = (derive_job_t*)arg;
+   while (1) {
+      pthread_mutex_lock(&job->mutex);
+      size_t i = job->next++;
+      pthread_mutex_unlock(&job->mutex);
+      if (i >= job->files->size() )	break;
+      bool ok = derive_file( (*job->files)[i], job->tree);
+      pthread_mutex_lock(&job->mutex);
+      job->nok += ok;
+      pthread_mutex_unlock(&job->mutex);
+   }
+   return NULL;
+}
+
+// data files of the chain
+static vector<string> chain_files(TTree *chain)
+{
+   vector<string> files;
+   if (chain->InheritsFrom(TChain::Class() ) ) {
+      TObjArray *l = ( (TChain*)chain)->GetListOfFiles();
+      for (int i=0; l && i < l->GetEntriesFast(); i++)
+	 files.push_back(l->At(i)->GetTitle() );
+   }
+   else if (chain->GetCurrentFile() )
+      files.push_back(chain->GetCurrentFile()->GetName() );
+   return files;
+}
+
+//______________________________________________________________________
+void SupixAnly::Derive(int nthreads)
+{
+   TRACE;
+   Timer timer(__func__);
+   timer.start();
+
+   vector<string> files = chain_files(fChain);
+   derive_job_t job;
+   job.files	= &files;
+   job.tree	= fChain->GetName();
+   job.next	= 0;
+   job.nok	= 0;
+   pthread_mutex_init(&job.mutex, NULL);
+   TDirectory *cwd = gDirectory;
+   int n = nthreads > 0 ? nthreads : m_nthreads;
+   if (n > (int)files.size() )	n = files.size();
+   if (n > 1) {
+      ROOT::EnableThreadSafety();
+      vector<pthread_t> tid(n);
+      for (int k=0; k < n; k++) {
+	 int err = pthread_create(&tid[k], NULL, derive_worker, &job);
+	 if (err) {
+	    LOG << "pthread_create: " << strerror(err) << endl;
+	    exit(-1);
+	 }
+      }
+      for (int k=0; k < n; k++)
+	 pthread_join(tid[k], NULL);
+   }
+   else
+      derive_worker(&job);
+   pthread_mutex_destroy(&job.mutex);
+   cwd->cd();
+
+   cout << __PRETTY_FUNCTION__ << " END:"
+	<< " files=" << job.nok << "/" << files.size()
+	<< " threads=" << n
+	<< endl;
+   timer.stop();
+   timer.print(1);
+}
+
+// the seed & 5x5 histograms of Loop() from derived_t
+//______________________________________________________________________
+void SupixAnly::LoopDerived(Long64_t nentries)
+{
+   TRACE;
+   if (fChain == 0) return;
+   Timer timer(__func__);
+   timer.start();
+   if (! m_booked)
+      Book();
+
+   vector<string> files = chain_files(fChain);
+   TChain *friends = new TChain("supix_derived");
+   for (size_t i=0; i < files.size(); i++)
+      friends->Add(derived_name(files[i]).c_str() );
+   if (friends->GetEntries() != fChain->GetEntries() ) {
+      LOG << "derived trees of " << friends->GetEntries() << " entries, not "
+	  << fChain->GetEntries() << ": Derive() first!!!" << endl;
+      delete friends;
+      return;
+   }
+   fChain->AddFriend(friends);
+
+   derived_t d;
+   fChain->SetBranchStatus("*", 0);
+   fChain->SetBranchStatus("trig", 1);
+   fChain->SetBranchStatus("npixs", 1);
+   const char *names[] = { "chi2_cds", "seed_row", "seed_col", "roi", "fired_sum"
+			   , "cds25", "snr25", "cor_cds", "cor_snr" };
+   void *addrs[] = { &d.chi2_cds, &d.seed_row, &d.seed_col, &d.roi, &d.fired_sum
+		     , d.cds25, d.snr25, &d.cor_cds, &d.cor_snr };
+   for (int k=0; k < 9; k++) {
+      friends->SetBranchStatus(names[k], 1);
+      friends->SetBranchAddress(names[k], addrs[k]);
+   }
+
+   if (nentries <= 0 || nentries > fChain->GetEntries() )
+      nentries = fChain->GetEntries();
+   Long64_t nbytes = 0;
+   for (Long64_t jentry=0; jentry < nentries; jentry++) {
+      if (LoadTree(jentry) < 0)	break;
+      nbytes += fChain->GetEntry(jentry);
+
+      if (trig > 1 && trig < TRIG_PRE)	m_chi2_trig->Fill(d.chi2_cds);
+      else				m_chi2_cds->Fill(d.chi2_cds);
+      if (! (trig > 1 && trig < TRIG_PRE) || ! d.roi)	continue;
+
+      if (d.fired_sum > 300)	m_special_evt->Fill(npixs, d.fired_sum);
+
+      // corrected: the pixel below the seed
+      double crt[25], snr_crt[25];
+      for (int i=0; i < 25; i++) {
+	 crt[i]		= d.cds25[i];
+	 snr_crt[i]	= d.snr25[i];
+      }
+      crt[17]		= d.cor_cds;
+      snr_crt[17]	= d.cor_snr;
+      double seed_raw = d.cds25[12], seed_crt = crt[12];
+
+      // 1, 3x3, 5x5 sums
+      double sum_raw[3] = { seed_raw, 0, 0 }, sum_crt[3] = { seed_crt, 0, 0 };
+      double snr_raw[3] = { d.snr25[12], 0, 0 }, snr_sum_crt[3] = { snr_crt[12], 0, 0 };
+      for (int i=0; i < 5; i++) {
+	 for (int j=0; j < 5; j++) {
+	    int k = i*5 + j;
+	    int m = (i > 0 && i < 4 && j > 0 && j < 4) ? 1 : 2;
+	    for (; m < 3; m++) {
+	       sum_raw[m]	+= d.cds25[k];
+	       sum_crt[m]	+= crt[k];
+	       snr_raw[m]	+= d.snr25[k];
+	       snr_sum_crt[m]	+= snr_crt[k];
+	    }
+	 }
+      }
+      for (int m=0; m < 3; m++) {
+	 m_sum_raw[m]->Fill(-sum_raw[m]);
+	 m_sum_crt[m]->Fill(-sum_crt[m]);
+	 m_snr_raw[m]->Fill(-snr_raw[m]);
+	 m_snr_crt[m]->Fill(-snr_sum_crt[m]);
+      }
+      m_seed_snr->Fill(-d.snr25[12]);
+      m_seed_single->Fill(-seed_crt);
+
+      // neighbours: 0-up, 1-down, 2-left, 3-right
+      m_pix_prf[0]->Fill(-seed_raw, -d.cds25[7]);
+      m_pix_prf[1]->Fill(-seed_raw, -d.cds25[17]);
+      m_pix_prf[2]->Fill(-seed_raw, -d.cds25[11]);
+      m_pix_prf[3]->Fill(-seed_raw, -d.cds25[13]);
+      m_pix2_correct->Fill(-seed_raw, -crt[17]);
+
+      // charge by pixels in order, as Loop() after its sort()
+      sort(crt, crt + 25);
+      double adc_sum = 0;
+      for (int i=0; i < 25; i++) {
+	 adc_sum += -crt[i];
+	 m_matrix_prf->Fill(i+1, adc_sum);
+	 m_matrix_prf_s->Fill(i+1, adc_sum);
+	 m_mat_pix_prf->Fill(i+1, -crt[i]);
+	 m_matrix_pnt_prf->Fill(i+1, adc_sum/124.2);
+	 m_matrix_pnt_prf_s->Fill(i+1, adc_sum/124.2);
+      }
+      for (int i=0; i < 5; i++) {
+	 for (int j=0; j < 5; j++) {
+	    m_prf_matrix[i][j]->Fill(-seed_raw, -d.cds25[i*5+j]);
+	    m_prf_matrix_crt[i][j]->Fill(-seed_crt, -crt[i*5+j]);
+	 }
+      }
+   }
+
+   fChain->SetBranchStatus("*", 1);
+   fChain->RemoveFriend(friends);
+   delete friends;
+
+   cout << __PRETTY_FUNCTION__ << " END:"
+	<< " Total entries = " << nentries
+	<< " bytes = " << nbytes
+	<< endl;
+   timer.stop();
+   timer.print(1);
+}
+
+// files of the chain opened ahead of the reader: the header, keys and
+// streamer infos of a file read, its tree loaded, and the rest of a local
+// file read ahead by the kernel (POSIX_FADV_WILLNEED), so that LoadTree()
+// of the next file finds it in the page cache.
+typedef struct anly_opener_t
+{
+   std::vector<std::string> files;
+   std::string		tree;		// name
+   int			ahead;
+   int			current;	// tree number being read
+   int			next;		// first file not opened yet
+   bool			stop;
+   int			opened;
+   pthread_mutex_t	mutex;
+   pthread_cond_t	cond;
+   pthread_t		tid;
+}
+   anly_opener_t
+   ;
+
+static void open_ahead(const anly_opener_t *o, const std::string &name)
+{
+   TFile *f = TFile::Open(name.c_str(), "READ");
+   if (! f)	return;
+   TTree *t = 0;
+   f->GetObject(o->tree.c_str(), t);
+   if (t)	t->GetEntries();
+   delete f;
+   if (name.find("://") != std::string::npos)	return;
+   int fd = open(name.c_str(), O_RDONLY);
+   if (fd < 0)	return;
+   posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+   close(fd);
+}
+
+static void * opener_run(void *arg)
+{
+   anly_opener_t *o = (anly_opener_t*)arg;
+   pthread_mutex_lock(&o->mutex);
+   while (! o->stop) {
+      if (o->next <= o->current)	o->next = o->current + 1;
+      if (o->next >= (int)o->files.size() || o->next > o->current + o->ahead) {
+	 pthread_cond_wait(&o->cond, &o->mutex);
+	 continue;
+      }
+      std::string name = o->files[o->next++];
+      pthread_mutex_unlock(&o->mutex);
+      open_ahead(o, name);
+      pthread_mutex_lock(&o->mutex);
+      o->opened++;
+   }
+   pthread_mutex_unlock(&o->mutex);
+   return NULL;
+}
+
+static void opener_next(anly_opener_t *o, int tree)
+{
+   pthread_mutex_lock(&o->mutex);
+   o->current = tree;
+   pthread_cond_signal(&o->cond);
+   pthread_mutex_unlock(&o->mutex);
+}
+
+// bits of branch_bits_t
+static const char *branch_names[NBRANCHES] = {
+   "pixel_cds", "pixel_adc", "pixid", "frame", "npixs", "trig", "fid" };
+
+TBranch * SupixAnly::get_branch(int k)
+{
+   switch (1 << k) {
+   case BR_PIXEL_CDS:	return b_pixel_cds;
+   case BR_PIXEL_ADC:	return b_pixel_adc;
+   case BR_PIXID:	return b_pixid;
+   case BR_FRAME:	return b_frame;
+   case BR_NPIXS:	return b_npixs;
+   case BR_TRIG:	return b_trig;
+   case BR_FID:		return b_fid;
+   }
+   return 0;
+}
+
+// bytes of an entry read in full, uncompressed
+static Long64_t entry_size(int bits)
+{
+   const Long64_t size[NBRANCHES] = {
+      NROWS*NCOLS*sizeof(Int_t), NROWS*NCOLS*sizeof(UShort_t), NPIXS*sizeof(UShort_t)
+      , sizeof(ULong64_t), sizeof(UShort_t), sizeof(UChar_t), sizeof(Char_t) };
+   Long64_t n = 0;
+   for (int k=0; k < NBRANCHES; k++)
+      if (bits & (1 << k) )	n += size[k];
+   return n;
+}
+
+// only branches of light|heavy enabled, until end_stage()
+//______________________________________________________________________
+void SupixAnly::begin_stage(const char *name, int light, int heavy)
+{
+   TRACE;
+   io_stage_t io;
+   io.name	= name;
+   io.light	= light;
+   io.heavy	= heavy & ~light;
+   io.entries	= 0;
+   io.nheavy	= 0;
+   io.bytes	= 0;
+   io.sec	= 0;
+   io.disk	= 0;
+   io.calls	= 0;
+   m_io.push_back(io);
+
+   fChain->SetBranchStatus("*", 0);
+   for (int k=0; k < NBRANCHES; k++)
+      if ( (light | heavy) & (1 << k) )
+	 fChain->SetBranchStatus(branch_names[k], 1);
+
+   if (m_cache_size) {
+      fChain->SetCacheSize(m_cache_size < 0 ? 0 : m_cache_size);
+      if (m_cache_size > 0 && m_cache_learn > 0)
+	 fChain->SetCacheLearnEntries(m_cache_learn);
+      else if (m_cache_size > 0) {
+	 // no learning: baskets of the stage only, from the first entry
+	 for (int k=0; k < NBRANCHES; k++)
+	    if ( (light | heavy) & (1 << k) )
+	       fChain->AddBranchToCache(branch_names[k], kTRUE);
+	 fChain->StopCacheLearningPhase();
+      }
+   }
+   start_opener();
+
+   io_stage_t &cur = m_io.back();
+   cur.tree	= fChain->GetTreeNumber();
+   cur.disk0	= TFile::GetFileBytesRead();
+   cur.calls0	= TFile::GetFileReadCalls();
+   cur.t0	= timer_now_ns();
+}
+
+// ientry of the current tree, as returned by LoadTree()
+//______________________________________________________________________
+Int_t SupixAnly::read_light(Long64_t ientry)
+{
+   io_stage_t &io = m_io.back();
+   Int_t nb = 0;
+   for (int k=0; k < NBRANCHES; k++)
+      if (io.light & (1 << k) )	nb += get_branch(k)->GetEntry(ientry);
+   if (io.tree != fChain->GetTreeNumber() ) {
+      io.tree = fChain->GetTreeNumber();
+      if (m_opener)	opener_next(m_opener, io.tree);
+   }
+   io.entries++;
+   io.bytes += nb;
+   return nb;
+}
+
+Int_t SupixAnly::read_heavy(Long64_t ientry)
+{
+   io_stage_t &io = m_io.back();
+   Int_t nb = 0;
+   for (int k=0; k < NBRANCHES; k++)
+      if (io.heavy & (1 << k) )	nb += get_branch(k)->GetEntry(ientry);
+   io.nheavy++;
+   io.bytes += nb;
+   return nb;
+}
+
+//______________________________________________________________________
+void SupixAnly::end_stage()
+{
+   TRACE;
+   stop_opener();
+   fChain->SetBranchStatus("*", 1);
+   if (m_cache_size > 0 && m_cache_learn <= 0)
+      fChain->DropBranchFromCache("*", kTRUE);
+   if (m_io.empty() )	return;
+   io_stage_t &io = m_io.back();
+   io.sec	= (timer_now_ns() - io.t0) * 1e-9;
+   io.disk	= TFile::GetFileBytesRead() - io.disk0;
+   io.calls	= TFile::GetFileReadCalls() - io.calls0;
+   double sec	= io.sec;
+   double mb	= io.bytes / 1048576.;
+   double full	= io.entries * entry_size(BR_ALL) / 1048576.;
+   double disk	= io.disk / 1048576.;
+   LOG << io.name << ": entries " << io.entries << ", heavy " << io.nheavy
+       << ", read " << mb << " MB of " << full << " MB, saved "
+       << (full > 0 ? 100 * (1 - mb / full) : 0) << "%" << endl;
+   LOG << io.name << ": " << sec << " s, " << (sec > 0 ? mb / sec : 0) << " MB/s unzipped, "
+       << disk << " MB from files at " << (sec > 0 ? disk / sec : 0) << " MB/s in "
+       << io.calls << " reads" << endl;
+}
+
+// disk bytes & reads are process-wide: of all workers in LoopMT()
+void SupixAnly::print_io()
+{
+   cout << "stage\tentries\theavy\tMB\tMB_full\tsaved_pct\tsec\tMB_per_sec\tMB_disk\tdisk_MB_per_sec\treads" << endl;
+   for (size_t i=0; i < m_io.size(); i++) {
+      const io_stage_t &io = m_io[i];
+      double sec	= io.sec;
+      double mb	= io.bytes / 1048576.;
+      double full	= io.entries * entry_size(BR_ALL) / 1048576.;
+      double disk	= io.disk / 1048576.;
+      cout << io.name << "\t" << io.entries << "\t" << io.nheavy << "\t" << mb
+	   << "\t" << full << "\t" << (full > 0 ? 100 * (1 - mb / full) : 0)
+	   << "\t" << sec << "\t" << (sec > 0 ? mb / sec : 0)
+	   << "\t" << disk << "\t" << (sec > 0 ? disk / sec : 0)
+	   << "\t" << io.calls << endl;
+   }
+}
+
+//______________________________________________________________________
+void SupixAnly::start_opener()
+{
+   if (m_opener || m_open_ahead <= 0 || ! fChain->InheritsFrom(TChain::Class() ) )
+      return;
+   TObjArray *files = ( (TChain*)fChain)->GetListOfFiles();
+   if (! files || files->GetEntriesFast() < 2)
+      return;
+
+   ROOT::EnableThreadSafety();
+   anly_opener_t *o = new anly_opener_t;
+   for (int i=0; i < files->GetEntriesFast(); i++)
+      o->files.push_back(files->At(i)->GetTitle() );
+   o->tree	= fChain->GetName();
+   o->ahead	= m_open_ahead;
+   o->current	= std::max(0, fChain->GetTreeNumber() );	// -1 before the first LoadTree(): file 0 is the chain's own
+   o->next	= 0;
+   o->stop	= false;
+   o->opened	= 0;
+   pthread_mutex_init(&o->mutex, NULL);
+   pthread_cond_init(&o->cond, NULL);
+   int err = pthread_create(&o->tid, NULL, opener_run, o);
+   if (err) {
+      LOG << "pthread_create: " << strerror(err) << ", no files opened ahead" << endl;
+      pthread_mutex_destroy(&o->mutex);
+      pthread_cond_destroy(&o->cond);
+      delete o;
+      return;
+   }
+   m_opener = o;
+}
+
+void SupixAnly::stop_opener()
+{
+   anly_opener_t *o = m_opener;
+   if (! o)	return;
+   pthread_mutex_lock(&o->mutex);
+   o->stop = true;
+   pthread_cond_signal(&o->cond);
+   pthread_mutex_unlock(&o->mutex);
+   pthread_join(o->tid, NULL);
+   LOG << "opened ahead: " << o->opened << " of " << o->files.size() << " files" << endl;
+   pthread_mutex_destroy(&o->mutex);
+   pthread_cond_destroy(&o->cond);
+   delete o;
+   m_opener = 0;
+}
+
 // after a full waveform found
 //______________________________________________________________________
 void SupixAnly::fill_waveform()
@@ -3417,12 +4469,18 @@ void SupixAnly::build_waveform(Long64_t nentries, int row, int col)
    m_nwaves = 0;
    m_nwave_frames = 0;		// for continuous mode
    m_nwave_trig = 0;
+   m_nwave_end = -1;
+   // windows of load-shedding runs: post frames as recorded in RunInfo
+   bool shed_post = m_runinfo_version >= 10 && ! m_continuous;
    
    Long64_t nbytes = 0, nb = 0;
+   // fired pixels of frames with any
+   begin_stage("build_waveform", BR_ALL & ~BR_PIXID, BR_PIXID);
    for (Long64_t jentry=0; jentry<nentries;jentry++) {
       Long64_t ientry = LoadTree(jentry);
       if (ientry < 0) break;
-      nb = fChain->GetEntry(jentry);
+      nb = read_light(ientry);
+      if (npixs > 0)	nb += read_heavy(ientry);
       nbytes += nb;
 
       //--------------------------------------->> start here
@@ -3431,6 +4489,7 @@ void SupixAnly::build_waveform(Long64_t nentries, int row, int col)
       if (frame - frame_last != 1			// discontinued #frame
 	  || (trig_last == 0 && trig == TRIG_PRE)	// trig: post -> pre
 	  || (m_continuous && m_nwave_frames % NWAVE_MAX == 0)	// continuous daq mode
+	  || (m_nwave_end >= 0 && m_nwave_frames > m_nwave_end)	// past the post frames
 	  )
       {//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++start a new waveform
 	 if (m_nwaves >= m_nwaves_max)
@@ -3454,6 +4513,7 @@ void SupixAnly::build_waveform(Long64_t nentries, int row, int col)
 	 m_exceedings = 0;		// exceeded frames
 	 m_npixs_trig = npixs;		// npixs of triged frame
 	 m_frame_start = frame;		// start #frame
+	 m_nwave_end = -1;
 
 	 // select a pixel
 	 m_pix_row = row;
@@ -3518,9 +4578,13 @@ void SupixAnly::build_waveform(Long64_t nentries, int row, int col)
 	 if (trig_last == TRIG_PRE) {		// pre -> trig
 	    m_nwave_trig = m_nwave_frames;	// triged frame-index
 	    m_wave_trig = trig;			// triged pattern
+	    if (shed_post)
+	       m_nwave_end = m_nwave_frames + m_runinfo->get_post_trigs(frame);
 	 }
-	 else
+	 else {
 	    ntrigs_after++;
+	    if (m_nwave_end >= 0)	m_nwave_end++;	// O_T1P1: post not counted down
+	 }
       }
       
       // pixel-wise histograms
@@ -3571,6 +4635,7 @@ void SupixAnly::build_waveform(Long64_t nentries, int row, int col)
       
       //cout<<"Total entries = "<<nentries<<endl;
    }
+   end_stage();
 
    // last waveform
    if (m_nwaves) {
@@ -3622,8 +4687,6 @@ void SupixAnly::event_display(long ievt)
    //by  b_branchname->GetEntry(ientry); //read only this branch
    if (fChain == 0) return;
 
-   Long64_t nentries = fChain->GetEntriesFast();
-
    // fChain->SetBranchStatus("*",0);		// disable all branches
    // fChain->SetBranchStatus("npixs",1);		// activate branchname
    // fChain->SetBranchStatus("pixel_cds",1);	// activate branchname
@@ -3642,79 +4705,28 @@ void SupixAnly::event_display(long ievt)
    // first execute
    // - scan for potential events
    if (jevent.size() == 0) {
-      Long64_t nbytes = 0, nb = 0;
-      for (Long64_t jentry=0; jentry<nentries;jentry++) {
-	 Long64_t ientry = LoadTree(jentry);
-	 if (ientry < 0) break;
-	 nb = fChain->GetEntry(jentry);   nbytes += nb;
-	 // if (Cut(ientry) < 0) continue;
-   
-   	 // if not physics trigged, continue;
-	 if(trig != 2) continue; 
-
-	 // pixel-wise histograms
-	 double cds_raw[NROWS][NCOLS];
-	 cds_t*		pcds = (cds_t*)pixel_cds;
-	 double*	pcds_mean = (double*)(m_runinfo->cds_mean);
-	 double*	pcds_sigma = (double*)(m_runinfo->cds_sigma);
-	 double	cds_cor;
-	 int ncuts = 0;
-	 double cutmin = 999;
-	 double chi2_cds = 0;
-	 for (int i=0; i < NROWS; i++) {//++++++++++++++++++++++++++++++start loop a frame
-	    for (int j=0; j < NCOLS; j++) {
-	       cds_cor = *pcds - *pcds_mean;
-	       cds_cor /= *pcds_sigma;		// normalized
-	       chi2_cds += cds_cor*cds_cor;
-	       
-	       if (cds_cor < -g_cds_sum_x) {	// Esum???
-		  ncuts++;
-		  if (cutmin > -cds_cor)
-		     cutmin = -cds_cor;
-	       }
-			//record the raw pixel
-			cds_raw[i][j] = *pcds;
-
-	       // next pixel
-	       pcds++;
-	       pcds_mean++;
-	       pcds_sigma++;
-	    }
-	 }//------------------------------------------------------------end loop a frame
-
-	
-//	 if (! (npixs > 0 || ncuts > 10 || chi2_cds > g_chi2_cds_x) ) continue;
-	//select the output sum over 1000
-	double adc_sum =0;
-	int seed_row =0, seed_col =0;
-   for (int i=0; i < npixs; i++) {
-      int row = pixid[i] >> NBITS_COL;
-      int col = pixid[i] &  MASK_COL;
-		if(cds_raw[row][col] < cds_raw[seed_row][seed_col]){
-			seed_row = row;
-			seed_col = col;
-		}
-      adc_sum += -cds_raw[row][col];
-   }
-	if(npixs < 12) continue;
-	if(seed_row<1 || seed_row>63 || seed_col<8 || seed_col >14) continue;	
-	if(adc_sum < 300) continue;
-	adc_sum =0;
+      // physics triged frames of the index, no entry read
+      const vector<idx_entry_t> &idx = get_index()->entries();
+      for (size_t i=0; i < idx.size(); i++) {
+	 const idx_entry_t &e = idx[i];
+	 if (e.trig != 2)	continue;
+	 if (e.npixs < 12)	continue;
+	 if (e.seed_row < 1 || e.seed_row > 63 || e.seed_col < 8 || e.seed_col > 14)	continue;
+	 if (e.cds_sum < 300)	continue;
 
-	 
 	 // special events
-	 if (chi2_cds > g_chi2_cds_x ) {
+	 if (e.chi2_cds > g_chi2_cds_x ) {
 	    cout << "\tspecial #" << jevent.size()
-		 << " frame=" << frame
-		 << " chi2_cds=" << chi2_cds
-		 << " npixs=" << npixs
-		 << " ncuts=" << ncuts
+		 << " frame=" << e.frame
+		 << " chi2_cds=" << e.chi2_cds
+		 << " npixs=" << e.npixs
+		 << " ncuts=" << e.ncuts
 		 << endl;
 	 }
 
-	 jevent.push_back(jentry);
-	 jcut.push_back(ncuts);
-	 jcutmin.push_back(cutmin);
+	 jevent.push_back(e.entry);
+	 jcut.push_back(e.ncuts);
+	 jcutmin.push_back(e.cutmin);
       }
 
       // prepare plots
@@ -3913,8 +4925,6 @@ void SupixAnly::special_display(long ievt, int fired)
    //by  b_branchname->GetEntry(ientry); //read only this branch
    if (fChain == 0) return;
 
-   Long64_t nentries = fChain->GetEntriesFast();
-
    // fChain->SetBranchStatus("*",0);		// disable all branches
    // fChain->SetBranchStatus("npixs",1);		// activate branchname
    // fChain->SetBranchStatus("pixel_cds",1);	// activate branchname
@@ -3933,122 +4943,24 @@ void SupixAnly::special_display(long ievt, int fired)
    // first execute
    // - scan for potential events
    if (jevent.size() == 0) {
-      Long64_t nbytes = 0, nb = 0;
-      for (Long64_t jentry=0; jentry<nentries;jentry++) {
-	 Long64_t ientry = LoadTree(jentry);
-	 if (ientry < 0) break;
-	 nb = fChain->GetEntry(jentry);   nbytes += nb;
-	 // if (Cut(ientry) < 0) continue;
-      
-	 // pixel-wise histograms
-	 cds_t*		pcds = (cds_t*)pixel_cds;
-	 double*	pcds_mean = (double*)(m_runinfo->cds_mean);
-	 double*	pcds_sigma = (double*)(m_runinfo->cds_sigma);
-	 double	cds_cor;
-	 int ncuts = 0;
-	 double cutmin = 999;
-	 double chi2_cds = 0;
-
-	//find the target frames, physics frames
-	 if(npixs < fired || trig != 2) continue;
-
-
-	//Find the seed
-	double cds_sum = 0; 
-	Int_t seed_row = 0, seed_col = 0;
-	double pixel_fired[NROWS][NCOLS] = {0};
-	Int_t pix_row[npixs], pix_col[npixs];
-	bool special = false;
-	for (int i=0; i < npixs; i++) {
-	   int row = pixid[i] >> NBITS_COL;
-	   int col = pixid[i] &  MASK_COL;
-
-	   double cds_cor = pixel_cds[row][col] - m_runinfo->cds_mean[row][col];
-	   cds_cor /= m_runinfo->cds_sigma[row][col];	// normalize by sigma
-	
-	   pixel_fired[row][col] = cds_cor;
-	  
-	   cds_sum += -cds_cor;
-
-	   if(cds_cor > -1){
-	    cout<<"cds_raw: "<<pixel_cds[row][col]
-			<<"\tcds_mean: "<<m_runinfo->cds_mean[row][col]
-			<<"\tcds_sigma: "<<m_runinfo->cds_sigma[row][col]
-			<<"\tcds_cor: "<<cds_cor<<endl;
-	   }
-
-
-
-
-	   pix_row[i] = row;
-	   pix_col[i] = col;
-
-	   if(pixel_fired[row][col] < pixel_fired[seed_row][seed_col]){
-			seed_row = row;
-			seed_col = col;
-		}
-
-	}
-	//for calibration peak analysis 
-	//		if(cds_sum < 60) continue;
-		cds_sum = 0;
-	//	if (seed_col < 8 || seed_row < 1 || seed_row > 62|| pixel_fired[seed_row][seed_col]> -90/fired ) continue;
-
-	//find pileup events
-	bool pileup = false;
-	double e_sum =0;
-	for(int i =0; i<npixs; i++){
-		if(npixs > 9 || TMath::Abs(pix_row[i] - seed_row) > 1 || TMath::Abs(pix_col[i] - seed_col) > 1){
-			Int_t p_col = pix_col[i];
-			Int_t p_row = pix_row[i];
-			special = true;
-			e_sum+= pixel_fired[p_row][p_col];
-		}
-	}
-//	if(e_sum < -60) pileup = true;
-	e_sum =0;
-//	special = special && pileup;
-	
-	if(!special) continue;
-	double pix_raw[NROWS][NCOLS];
-	 for (int i=0; i < NROWS; i++) {//++++++++++++++++++++++++++++++start loop a frame
-	    for (int j=0; j < NCOLS; j++) {
-	       cds_cor = *pcds - *pcds_mean;
-	       cds_cor /= *pcds_sigma;		// normalized
-	       chi2_cds += cds_cor*cds_cor;
-	       
-	       if (cds_cor < -g_cds_sum_x) {	// Esum???
-		  ncuts++;
-		  if (cutmin > -cds_cor)
-		     cutmin = -cds_cor;
-	       }
-	       pix_raw[i][j] = cds_cor;
-	       // next pixel
-	       pcds++;
-	       pcds_mean++;
-	       pcds_sigma++;
-	    }
-	 }//------------------------------------------------------------end loop a frame
-
-
-
-	 if (! (npixs > 0 || ncuts > 10 || chi2_cds > g_chi2_cds_x) ) continue;
-//	 if(!(npixs > 0)) continue;
-	 // special events
-	 
-//	 if (chi2_cds > g_chi2_cds_x && npixs < 1) {
-	 if(special){
-		 cout << "\tspecial #" << jevent.size()
-		 << " frame=" << frame
-		 << " chi2_cds=" << chi2_cds
-		 << " npixs=" << npixs
-		 << " ncuts=" << ncuts
-		 << endl;
-	 }
+      // physics triged frames of the index with pixels off the seed, no entry read
+      const vector<idx_entry_t> &idx = get_index()->entries();
+      for (size_t i=0; i < idx.size(); i++) {
+	 const idx_entry_t &e = idx[i];
+	 if (e.npixs < fired || e.trig != 2)	continue;
+	 if (! e.spread)	continue;
+	 if (! (e.npixs > 0 || e.ncuts > 10 || e.chi2_cds > g_chi2_cds_x) ) continue;
+
+	 cout << "\tspecial #" << jevent.size()
+	      << " frame=" << e.frame
+	      << " chi2_cds=" << e.chi2_cds
+	      << " npixs=" << e.npixs
+	      << " ncuts=" << e.ncuts
+	      << endl;
 
-	 jevent.push_back(jentry);
-	 jcut.push_back(ncuts);
-	 jcutmin.push_back(cutmin);
+	 jevent.push_back(e.entry);
+	 jcut.push_back(e.ncuts);
+	 jcutmin.push_back(e.cutmin);
       }
 	
   	  //if no special events	  
@@ -4201,7 +5113,7 @@ void SupixAnly::special_display(long ievt, int fired)
 
 }
 
-void SupixAnly::frame_display(Long64_t iframe){
+void SupixAnly::frame_display(Long64_t iframe, int tree){
 	  if (fChain == 0) return;
       
       // frame display
@@ -4222,41 +5134,32 @@ void SupixAnly::frame_display(Long64_t iframe){
 	  h2d->SetStats(0);
    	  
 
-      Long64_t nbytes, nb;
-      Long64_t nentries = fChain->GetEntriesFast();
-      if(iframe > nentries) return; 
-      for(Long64_t jentry =0; jentry < nentries; jentry++){
-   
+      // entry of the frame by the index
+      Long64_t jentry = get_index()->find_frame(iframe, tree);
+      if (jentry < 0) return;
       Long64_t ientry = LoadTree(jentry);
-	 if (ientry < 0) return;
-	 nb = fChain->GetEntry(jentry);   nbytes += nb;
-
-	 if(frame == iframe){
-	 // pixel-wise histograms
-	 adc_t*		padc = (adc_t*)pixel_adc;
-	 double*	padc_mean = (double*)(m_runinfo->adc_mean);
-	 double*	padc_sigma = (double*)(m_runinfo->adc_sigma);
-	 double*	pcds_sigma = (double*)(m_runinfo->cds_sigma);
-	 double	adc_cor;
-	 for (int i=0; i < NROWS; i++) {//++++++++++++++++++++++++++++++start loop a frame
-	    for (int j=0; j < NCOLS; j++) {
-	       adc_cor = *padc - *padc_mean;
-	       adc_cor /= *pcds_sigma;		// normalized
-	       
-	  	   
-	  	   m_iframe.display_frame -> Fill(i+1, j+1, -adc_cor);
-	       // next pixel
-	       padc++;
-	       padc_mean++;
-	       padc_sigma++;
-	       pcds_sigma++;
-	    }
-	 }//------------------------------------------------------------end loop a frame
-   
-	 }
+      if (ientry < 0) return;
+      fChain->GetEntry(jentry);
 
-   }
+      // pixel-wise histograms
+      adc_t*	padc = (adc_t*)pixel_adc;
+      double*	padc_mean = (double*)(m_runinfo->adc_mean);
+      double*	padc_sigma = (double*)(m_runinfo->adc_sigma);
+      double*	pcds_sigma = (double*)(m_runinfo->cds_sigma);
+      double	adc_cor;
+      for (int i=0; i < NROWS; i++) {//++++++++++++++++++++++++++++++start loop a frame
+	 for (int j=0; j < NCOLS; j++) {
+	    adc_cor = *padc - *padc_mean;
+	    adc_cor /= *pcds_sigma;		// normalized
 
+	    m_iframe.display_frame -> Fill(i+1, j+1, -adc_cor);
+	    // next pixel
+	    padc++;
+	    padc_mean++;
+	    padc_sigma++;
+	    pcds_sigma++;
+	 }
+      }//------------------------------------------------------------end loop a frame
 }
 
 double SupixAnly::charge_correction(double charge_seed, double charge_raw){
@@ -18,6 +18,8 @@
 #include "TGraph.h"
 #include <math.h>
 #include <fstream>
+#include <string>
+#include <vector>
 
 #define NWAVE_MAX	1000	// limit frames of a waveform
 
@@ -40,7 +42,14 @@ class TH1D;
 class TH2D;
 class TProfile;
 class TMultiGraph;
+class TChain;
+class TList;
 class TPaveText;
+struct anly_opener_t;
+class SupixIndex;
+class DenseHist;
+class ClusterSweep;
+class FakeScan;
 
 struct event_t {
    // void set(unsigned long i=0);
@@ -53,6 +62,68 @@ struct frame_t{
    TH2D*   display_frame;
 } ;
 
+// branches of SupixTree, for begin_stage()
+enum branch_bits_t {
+   BR_PIXEL_CDS	= 0x01,
+   BR_PIXEL_ADC	= 0x02,
+   BR_PIXID	= 0x04,
+   BR_FRAME	= 0x08,
+   BR_NPIXS	= 0x10,
+   BR_TRIG	= 0x20,
+   BR_FID	= 0x40,
+   NBRANCHES	= 7,
+   BR_ALL	= 0x7f
+};
+
+typedef struct io_stage_t
+{
+   const char *	name;
+   int		light;		// branches read every entry
+   int		heavy;		// branches read on demand
+   Long64_t	entries;
+   Long64_t	nheavy;		// entries with heavy branches read
+   Long64_t	bytes;		// uncompressed
+   double	sec;
+   Long64_t	disk;		// bytes read from files, all threads
+   Int_t	calls;		// reads from files, all threads
+   unsigned long long t0;	// ns at start
+   Long64_t	disk0;		// TFile::GetFileBytesRead() at start
+   Int_t	calls0;		// TFile::GetFileReadCalls() at start
+   int		tree;		// tree number of the chain being read
+}
+   io_stage_t
+   ;
+
+// per-run constants of Loop(), pixel p = row*NCOLS + col = pixid
+typedef struct calib_t
+{
+   const RunInfo * runinfo;		// built from, 0 = none yet
+   double	cds_mean[NPIXS];
+   double	cds_sigma[NPIXS];
+   double	inv_cds_sigma[NPIXS];
+   double	adc_mean[NPIXS];
+   double	inv_adc_sigma[NPIXS];
+   double	sigma_mean;		// of cds_sigma
+}
+   calib_t
+   ;
+
+// derived quantities of a frame, friend tree supix_derived of Derive()
+typedef struct derived_t
+{
+   Float_t	chi2_cds;	// sum of (CDS/sigma)^2 of all pixels
+   UChar_t	seed_row;	// fired pixel of min CDS/sigma, triged frames
+   UChar_t	seed_col;
+   UChar_t	roi;		// 5x5 of the seed analysed by Loop()
+   Float_t	fired_sum;	// -sum of CDS of fired pixels
+   Float_t	cds25[25];	// CDS of 5x5 around the seed, row by row
+   Float_t	snr25[25];	// CDS/sigma of 5x5
+   Float_t	cor_cds;	// charge_correction() of the pixel below the seed
+   Float_t	cor_snr;	// (cor_cds - mean)/sigma
+}
+   derived_t
+   ;
+
 class SupixAnly : public SupixTree
 {
    event_t m_event;
@@ -64,7 +135,7 @@ public:
    
    void event_display(long);
 
-   void frame_display(Long64_t);
+   void frame_display(Long64_t, int tree=-1);	// tree: file of the chain, runs
    
    event_t get_event(long ievt = -1) {
       if (ievt >= 0)
@@ -81,9 +152,9 @@ public:
 	return m_event;
    }
 
-   frame_t get_frame(Long64_t iframe = -1){
+   frame_t get_frame(Long64_t iframe = -1, int tree = -1){
    	if(iframe >=0)
-		frame_display(iframe);
+		frame_display(iframe, tree);
 	return m_iframe;
    }
    // retrieve RunInfo
@@ -101,6 +172,15 @@ public:
    // why can't it be overridden? -- NOT virtual inheritance!
    void Loop();
 
+   // fill entries [first, last) only, last = 0 for all
+   void LoopRange(Long64_t first, Long64_t last);
+   // Loop() on n threads, each booking its own histograms; 1 = serial
+   void set_nthreads(int n)		{ m_nthreads = n < 1 ? 1 : n; }
+   // max |difference| of bin contents to another analysis booked alike
+   double Compare(SupixAnly *o);
+   // Loop() timed on each number of threads, checked against the first
+   void Scaling(Long64_t nentries, const std::vector<int> &nthreads);
+
    void set_nwaves_max(int x)	{ m_nwaves_max = x; }
    void build_waveform(Long64_t nentries=0, int row=-1, int col=-1);
    void fill_waveform();
@@ -112,9 +192,75 @@ public:
 
    void scan(int row=0, int col=0, const char* cut="");
 
-   double charge_correction(double charge_seed, double charge_raw);
+   static double charge_correction(double charge_seed, double charge_raw);
+
+   // friend tree "derived/<file>-derived.root" of derived_t per data file, files
+   // on nthreads (0 = set_nthreads() ); no histograms
+   void Derive(int nthreads=0);
+   static std::string derived_name(const std::string &file);
+   // histograms of the seed & 5x5 matrix by the friend trees of Derive(),
+   // no pixel arrays read; the rest as booked
+   void LoopDerived(Long64_t nentries=0);
+   static void derive_frame(const calib_t &cal, const Int_t cds[NROWS][NCOLS], const UShort_t *pixid
+			    , int npixs, int trig, derived_t &d);
+   static void make_calib(const RunInfo *ri, calib_t &c);
+
+   // branch-selective reading: only light|heavy branches enabled
+   void begin_stage(const char *name, int light, int heavy);
+   Int_t read_light(Long64_t ientry);	// light branches of ientry, bytes read
+   Int_t read_heavy(Long64_t ientry);	// heavy ones, if the entry needs them
+   void end_stage();			// all branches back, bytes saved printed
+   void print_io();			// all stages so far
+
+   // TTreeCache of each stage: bytes, 0 = ROOT default, < 0 = none;
+   // learn entries, 0 = the branches of the stage without learning
+   void set_cache(Long64_t bytes, Int_t learn=0)
+   { m_cache_size = bytes; m_cache_learn = learn; }
+   // files of the chain opened ahead in the background, 0 = none
+   void set_open_ahead(int n)		{ m_open_ahead = n < 0 ? 0 : n; }
+   // threshold grid of the fake-hit scans, sigma; before Book()
+   void set_fake_grid(double xmin, double step, int nbins)
+   { m_fake_xmin = xmin; m_fake_step = step; m_fake_nbins = nbins; }
+   // clusters of m_*_alg[]: full 7x7 components and bounding box veto,
+   // not the 3-hop growth of earlier productions
+   void set_cluster_sweep(bool x)	{ m_cluster_sweep = x; }
+
+   // event index of the chain, loaded or built on first use on m_nthreads
+   SupixIndex * get_index();
    
 private:
+   TBranch * get_branch(int k);		// k-th bit of branch_bits_t
+   const calib_t & calibrate();		// m_calib of m_runinfo, rebuilt per tree
+   const double * pix_rms_inv();	// 1/noise of pixel_noise/a0_pixel_noise.txt
+
+   calib_t	m_calib;
+   Int_t	m_calib_tree;		// of fChain m_calib was built for, -1 none
+   std::vector<double> m_pix_rms_inv;	// empty until pix_rms_inv()
+
+   void start_opener();
+   void stop_opener();
+
+   std::vector<io_stage_t> m_io;
+   Long64_t	m_cache_size;
+   Int_t	m_cache_learn;
+   int		m_open_ahead;
+   anly_opener_t * m_opener;		// of the current stage
+   SupixIndex *	m_index;
+   // multi-threaded Loop()
+   void LoopMT(Long64_t nentries);
+   void Merge(SupixAnly *o);		// add histograms of o, booked alike
+   std::vector<TList*> get_lists();	// histograms filled by Loop()
+   void delete_hists();
+   TChain * clone_chain();
+   void new_workers(int n, std::vector<SupixAnly*> &anly, std::vector<TChain*> &chain);
+   static void delete_workers(std::vector<SupixAnly*> &anly, std::vector<TChain*> &chain);
+
+   int		m_nthreads;
+   unsigned long m_nhits;		// of the last Loop()
+   unsigned long m_nconsecutives;
+   ULong64_t	m_frame_first;		// first triged frame of a range, dTevt unknown
+   ULong64_t	m_frame_last;		// last triged frame
+
    TCanvas *	m_c1;
    RunInfo *	m_runinfo;
    int		m_runinfo_version;
@@ -122,8 +268,11 @@ private:
    // histograms
    TList *	m_list_adc;
    TList *	m_list_cds;
-   TH1D *	m_adc[NROWS][NCOLS];
+   TH1D *	m_adc[NROWS][NCOLS];	// of m_dense_adc at Write()
    TH1D *	m_cds[NROWS][NCOLS];
+   DenseHist *	m_dense_adc;		// filled by Loop(), a frame at a time
+   DenseHist *	m_dense_cds;
+   void dense_to_hists();
 
    TList *	m_list_misc;
    TH1D *	m_trig;
@@ -215,6 +364,8 @@ private:
    TH1D*		m_size_alg[20];
    TH1D* 		m_dist_alg[20];
    TH1D*		m_snr_clu[20];
+   ClusterSweep * m_sweep;		// clusters of m_*_alg[] thresholds
+   bool		m_cluster_sweep;	// m_sweep, not the growth
    TProfile*	m_sum_extr;
    TProfile*	m_snr_extr;
 	TProfile*	m_size_thres;
@@ -311,6 +462,11 @@ private:
 	TH1D*			m_snr_def;
 	TH1D*			m_fake_frames_def;
 	TH1D*			m_frame_num;
+	FakeScan *		m_fake_scan;		// -cds/rms of pixel_noise/, any grid
+	FakeScan *		m_fake_scan_def;	// -cds_snr
+	double		m_fake_xmin, m_fake_step;
+	int			m_fake_nbins;
+	void fake_scan_hists();
 	//	TH1D*			m_rate_per_frame_thr[20];
 
 
@@ -377,6 +533,7 @@ private:
    int		m_nwave_frames;	// frame index of a waveform
    int		m_exceedings;
    int		m_nwave_trig;	// offset of first triged frame
+   int		m_nwave_end;	// offset of its last post frame, -1 = not yet
    int		m_nwave_norm;	// normal waveform length
    int		m_npixs_trig;	// npixs of triged frame
    ULong64_t	m_frame_start;	// start frame of a waveform
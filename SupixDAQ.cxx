@@ -62,6 +62,7 @@ enum timers_t
     , Tstart_run, Tread
     , Tchild_run, Tprocd, Tdecode_frame, Tis_first
     , Tdo_trig, Ttriged, Twrite, Tskip, Tnext_out
+    , Tnew_outfiles
     , NTIMERS
    };
 const char *timers_name[NTIMERS] =
@@ -72,8 +73,21 @@ const char *timers_name[NTIMERS] =
     // writer
     , "child_run", "process", "decode_frame", "is_first"
     , "do_trig", "@triged", "@write", "@skip", "@next_out"
+    , "@new_outfiles"
+   };
+// owner thread of timers for live statistics
+const int timers_thread[NTIMERS] =
+   {
+    SHM_RD, SHM_WR, SHM_WR
+    , SHM_RD, SHM_RD
+    , SHM_WR, SHM_WR, SHM_WR, SHM_WR
+    , SHM_WR, SHM_WR, SHM_WR, SHM_WR, SHM_WR
+    , SHM_WR
    };
 Timer *x_timers[NTIMERS] = { NULL };
+// stages of the end-to-end benchmark, timed even under NOTIMERS
+static const int bench_timers[] =
+   { Trd_fifo, Tprocd, Tdecode_frame, Tdo_trig, Twrite, Tskip, Twr_raw, Twr_root };
 // usage:
 //   Timer m_timer("\tread FIFO");
 //   m_timer.start();
@@ -138,11 +152,13 @@ SupixDAQ::SupixDAQ()
    m_filesize_max	= (long)2*GB;	// max bytes/file
    m_filesize_raw	= 0;
    m_filesize_root	= 0;
+   m_filesize_sum	= 0;
    m_tfile	= NULL;
    m_tree	= NULL;
    m_frame		= 0;	// frame id, starting 0
    m_trig	= 0;		// trigger pattern
    m_frame_1st	= true;		// default be first frame
+   m_quiet	= false;
    m_pre_adc	= NULL;
    m_pixel_adc	= NULL;
    m_pre_cds	= NULL;
@@ -153,6 +169,52 @@ SupixDAQ::SupixDAQ()
    m_maxframe	= 0;		// 0 = infinity
    m_pipeline	= NULL;
    m_pipeline_max = 10000;	// total frames
+   m_trig_ctrl	= NULL;		// threshold controller
+   m_ctrl_occ	= 0;
+   m_ctrl_bw	= 0;
+   m_ctrl_xmin	= -1;		// -1 = trig_cds_x
+   m_ctrl_xmax	= -1;		// -1 = 2 * trig_cds_x
+   m_ctrl_every	= 1000;		// frames per sample
+   m_shed	= NULL;		// load-shedding
+   m_shed_low	= 0;		// 0 = disabled
+   m_shed_high	= 0.9;
+   m_shed_level	= SHED_NONE;
+   m_zs_adc	= NULL;
+   m_zs_cds	= NULL;
+   m_zs_npixs	= 0;
+   m_shm	= NULL;		// live statistics
+   m_shm_name	= SHMSTATS_NAME;
+   m_shm_every	= 64;		// frames per update
+   m_timer_sample = 1;
+   m_timer_frame[SHM_RD] = 0;
+   m_timer_frame[SHM_WR] = 0;
+   m_perf	= false;
+   m_perf_stage	= NULL;
+   m_trace_every  = 0;
+   m_trace_thresh = 0;
+   m_trace[SHM_RD] = NULL;
+   m_trace[SHM_WR] = NULL;
+   m_trace_ndump  = 0;
+   m_trace_run    = false;
+   m_tune	= false;
+   m_tune_ratio	= 0;
+   m_tune_frames = 2000;
+   m_tune_capacity = 0;
+   m_tune_every	= 100000;	// ~3 sec
+   m_tune_drift	= 0.2;
+   m_tune_sim	= NULL;
+   m_tune_nprocd = 0;
+   m_tune_busy	= 0;
+   m_source	= NULL;
+   m_isfull_ns	= 0;
+   m_root_compress = -1;
+   m_root_basket   = 0;
+   m_root_autoflush = 0;
+   for (int k=0; k < 2; k++) {
+      CPU_ZERO(&m_cpus[k]);
+      m_rt_prio[k] = 0;
+   }
+   m_mem_flags	= 0;
    m_buffer = NULL;		// temporary for a frame
    m_childs	= 0;		// number of child threads
    m_npixs	= 0;
@@ -166,6 +228,7 @@ SupixDAQ::SupixDAQ()
 //______________________________________________________________________
 SupixDAQ::~SupixDAQ()
 {  TRACE;
+   if (m_source)	delete m_source;
    LOG << "THE END" << endl;
 }
 
@@ -190,35 +253,150 @@ void SupixDAQ::initialize()
       m_runinfo.pre_trigs	= 0;
       m_runinfo.post_trigs	= 0;
    }
+
+   // threshold controller for triggered runs only
+   if (m_runinfo.daq_mode == M_NORMAL && (m_ctrl_occ > 0 || m_ctrl_bw > 0) ) {
+      if (m_ctrl_xmin < 0)	m_ctrl_xmin = m_runinfo.trig_cds_x;
+      if (m_ctrl_xmax < 0)	m_ctrl_xmax = 2 * m_runinfo.trig_cds_x;
+      if (m_ctrl_occ <= 0)	m_ctrl_occ = 0.5;
+      m_trig_ctrl = new trig_control_t(m_ctrl_xmin, m_ctrl_xmax, m_ctrl_occ, m_ctrl_bw);
+      LOG << "threshold controller: trig_cds_x in [" << m_ctrl_xmin << ", " << m_ctrl_xmax << "]"
+	  << " occupancy < " << m_ctrl_occ
+	  << " bandwidth < " << m_ctrl_bw / MiB << " MiB/s"
+	  << " per " << m_ctrl_every << " frames"
+	  << endl;
+   }
    
    // lock before any action
    int rv = 0;
-   if (m_mode_debug)
+   if (m_mode_debug || m_source)
       rv = getpid();
    else
       rv = lock_run();
    m_pid = rv;
    
-   m_fd_mem	= open_fd(m_dev_mem,  O_WRONLY);
-   m_fd_fifo	= open_fd(m_dev_fifo, O_RDONLY);
+   if (m_source)
+      LOG << "synthetic frames at " << m_source->get_fps() << " fps, no devices" << endl;
+   else {
+      m_fd_mem	= open_fd(m_dev_mem,  O_WRONLY);
+      m_fd_fifo	= open_fd(m_dev_fifo, O_RDONLY);
+   }
 
-   // after nrow and ncol set
-   m_pipeline = new pipeline_t(FRAMESIZE, m_pipeline_max,
-			       m_runinfo.pre_trigs, m_runinfo.post_trigs);
+   // sets m_pipeline_max, m_tune_capacity, m_timewait & m_timeout
+   if (m_tune && m_runinfo.daq_mode != M_NOISE)
+      calibrate();
+
+   alloc_buffers();
+   m_runinfo.pipeline_max = m_pipeline_max;
+   m_runinfo.timewait	  = m_timewait;
+   m_runinfo.timeout	  = m_timeout;
+
+   // asynchronous log of hot paths
+   alog_start(m_log_fn.c_str() );
+
+   // instantiate timers
+   for (int i=0; i < NTIMERS; i++) {
+      x_timers[i] = new Timer(timers_name[i]);
+      x_timers[i]->set_sample(m_timer_sample, &m_timer_frame[timers_thread[i]]);
+   }
+   x_timers[Tnew_outfiles]->set_sample(1);	// rare, every one for retune()
+   if (m_source)
+      for (size_t i=0; i < sizeof(bench_timers)/sizeof(int); i++)
+	 x_timers[bench_timers[i]]->set_always(true);	// bench_report()
+   if (m_trace_every > 0 || m_trace_thresh > 0) {
+      m_trace[SHM_RD] = new trace_ring_t("reader");
+      m_trace[SHM_WR] = new trace_ring_t("writer");
+      for (int k=0; k < 2; k++) {
+	 m_trace[k]->set_sample(m_trace_every);
+	 if (m_trace_thresh > 0)
+	    m_trace[k]->set_threshold(m_trace_thresh * 1000);
+      }
+      for (int i=0; i < NTIMERS; i++)
+	 x_timers[i]->set_trace(m_trace[timers_thread[i]]);
+      trace_signal(SIGUSR1);	// dumped by its own thread, off the DAQ threads
+      m_trace_run = true;
+      int err = pthread_create(&m_trace_thr, NULL, trace_dumper, this);
+      if (err) {
+	 m_trace_run = false;
+	 CERR << "trace dumper: pthread_create: " << strerror(err) << ", no dump on signal" << endl;
+      }
+      LOG << "tracing: 1 in " << m_trace_every << " frames, >= " << m_trace_thresh << " usec"
+	  << ", kill -USR1 " << getpid() << " to dump" << endl;
+   }
+   if (m_perf) {	// groups opened by the owner threads
+      m_perf_stage = new perf_stage_t[NTIMERS];
+      for (int i=0; i < NTIMERS; i++) {
+	 m_perf_stage[i].group = &m_perf_group[timers_thread[i]];
+	 x_timers[i]->set_perf(&m_perf_stage[i]);
+      }
+   }
+
+   // live statistics
+   if (m_shm_name.size() ) {
+      m_shm = shmstats_create(m_shm_name.c_str() );
+      if (m_shm) {
+	 m_shm->pipeline_max = m_pipeline_max;
+	 m_shm->ntimers = NTIMERS < SHMSTATS_TIMERS ? NTIMERS : SHMSTATS_TIMERS;
+	 for (int i=0; i < m_shm->ntimers; i++) {
+	    strncpy(m_shm->timer_name[i], timers_name[i], SHMSTATS_NAMELEN-1);
+	    m_shm->timer_thread[i] = timers_thread[i];
+	 }
+	 LOG << "live statistics: /dev/shm" << m_shm_name << endl;
+      }
+   }
+   
+   // cores reserved to the DAQ threads: the rest of the process, incl.
+   // the ALOG flusher, kept off; threads created later inherit it
+   cpu_set_t reserved;
+   CPU_OR(&reserved, &m_cpus[SHM_RD], &m_cpus[SHM_WR]);
+   if (CPU_COUNT(&reserved) ) {
+      int n = cpus_exclude(&reserved);
+      LOG << "cores reserved: " << cpus_sprint(&reserved) << ", " << n << " threads moved off" << endl;
+   }
+
+   // RunInfo timing start
+   m_runinfo.set_time_start();
+   build_pathbase();		// after m_runinfo.set_time_start()
+
+   print(__PRETTY_FUNCTION__);
+   
+}
+
+
+// pipeline, stacks and buffers of a run
+// - after nrow and ncol set
+//______________________________________________________________________
+void SupixDAQ::alloc_buffers()
+{  TRACE;
+   int capacity = m_tune_capacity > m_pipeline_max ? m_tune_capacity : m_pipeline_max;
+   m_pipeline = new pipeline_t(FRAMESIZE, capacity,
+			       m_runinfo.pre_trigs, m_runinfo.post_trigs, m_mem_flags);
+   m_pipeline->set_limit(m_pipeline_max);
    
    m_buffer = (unsigned char*)malloc(FRAMESIZE);
 
+   // load-shedding under back-pressure
+   if (m_runinfo.daq_mode != M_NOISE && m_shed_low > 0) {
+      m_shed	= new shed_t(SHED_LEVELS, m_shed_low, m_shed_high);
+      m_zs_adc	= (adc_t*)malloc(sizeof(adc_t) * NPIXS);
+      m_zs_cds	= (cds_t*)malloc(sizeof(cds_t) * NPIXS);
+      LOG << "load-shedding watermarks:";
+      for (int k=1; k < SHED_LEVELS; k++)
+	 COUT << " " << k << "=" << m_shed->get_watermark(k);
+      COUT << endl;
+   }
+
    // stacks for decoded data
    int maxfs	= m_runinfo.pre_trigs + 1;
    if (maxfs <= 1)
       maxfs = 2;	// at least 2 from cds calculation
    int adc_size	= sizeof(adc_t) * NROWS * NCOLS;	// object size
-   m_pre_adc	= new ostack_t(adc_size, maxfs);
+   m_pre_adc	= new ostack_t(adc_size, maxfs, m_mem_flags);
    m_pixel_adc	= (adc_t*)(m_pre_adc->get_top());
    m_pixel_last	= (adc_t*)(m_pre_adc->get_top() + adc_size);
    
    int cds_size	= sizeof(cds_t) * NROWS * NCOLS;
-   m_pre_cds	= new ostack_t(cds_size, maxfs);
+   m_pre_cds	= new ostack_t(cds_size, maxfs, m_mem_flags);
    m_pixel_cds	= (cds_t*)(m_pre_cds->get_top());
 
    LOG << "STACK pointers:"
@@ -230,18 +408,32 @@ void SupixDAQ::initialize()
        << " pixel_cds=" << (void*)m_pixel_cds
        << " cds_size=" << cds_size
        << endl;
+   if (m_mem_flags)
+      LOG << "memory: pipeline " << mem_sprint(m_pipeline->get_in_ptr() )
+	  << ", pre_adc " << mem_sprint(m_pre_adc->get_top() )
+	  << ", pre_cds " << mem_sprint(m_pre_cds->get_top() )
+	  << endl;
+}
 
-   // instantiate timers
-   for (int i=0; i < NTIMERS; i++) {
-      x_timers[i] = new Timer(timers_name[i]);
+//______________________________________________________________________
+void SupixDAQ::free_buffers()
+{  TRACE;
+   if (m_buffer)		free(m_buffer);
+   if (m_pre_adc)		delete m_pre_adc;
+   if (m_pre_cds)		delete m_pre_cds;
+   if (m_pipeline)		delete m_pipeline;
+   if (m_shed) {
+      delete m_shed;
+      free(m_zs_adc);
+      free(m_zs_cds);
    }
-   
-   // RunInfo timing start
-   m_runinfo.set_time_start();
-   build_pathbase();		// after m_runinfo.set_time_start()
-
-   print(__PRETTY_FUNCTION__);
-   
+   m_buffer	= NULL;
+   m_pre_adc	= NULL;
+   m_pre_cds	= NULL;
+   m_pipeline	= NULL;
+   m_shed	= NULL;
+   m_zs_adc	= NULL;
+   m_zs_cds	= NULL;
 }
 
 
@@ -251,6 +443,8 @@ void SupixDAQ::finalize()
 
    // RunInfo timing stop
    m_runinfo.set_time_stop();
+   save_shed();
+   alog_stop();		// DAQ threads done, the rest written directly
    //if (! m_write_root)		m_runinfo.Print();
 
    // if (m_noise_run) {
@@ -265,16 +459,29 @@ void SupixDAQ::finalize()
 
    if (m_fd_raw >= 0)		close_raw();
    if (m_tfile)			close_root();
+   if (m_source && m_runinfo.daq_mode != M_NOISE)
+      m_bench_line = bench_report();
 
    print(__PRETTY_FUNCTION__);
-   if (m_buffer)		free(m_buffer);
-   if (m_pre_adc)		delete m_pre_adc;
-   if (m_pre_cds)		delete m_pre_cds;
-   if (m_pipeline)		delete m_pipeline;
+   free_buffers();
+   if (m_shm) {
+      shmstats_close(m_shm);
+      m_shm = NULL;
+   }
+   if (m_tune_sim) {
+      delete m_tune_sim;
+      m_tune_sim = NULL;
+   }
+   if (m_trig_ctrl) {
+      LOG << "threshold controller: " << m_trig_ctrl->get_nadjust() << " adjustments"
+	  << ", last trig_cds_x=" << m_runinfo.trig_cds_x << endl;
+      delete m_trig_ctrl;
+   }
 
    if (m_runinfo.daq_mode != M_NOISE) {
       // timing
       recommend();		// before x_timers[] deleted
+      save_timing();
       LOG << "timing..." << endl;
       for (int i=0; i < NTIMERS; i++) {
 	 x_timers[i]->print();
@@ -282,9 +489,29 @@ void SupixDAQ::finalize()
       }
       //COUT << endl;
    }
+   if (m_trace[SHM_RD]) {
+      if (m_trace_run.exchange(false) )
+	 pthread_join(m_trace_thr, NULL);
+      dump_trace();
+      for (int k=0; k < 2; k++) {
+	 delete m_trace[k];
+	 m_trace[k] = NULL;
+      }
+   }
+   if (m_perf_stage) {
+      if (m_runinfo.daq_mode != M_NOISE) {
+	 LOG << "performance counters..." << endl;
+	 for (int i=0; i < NTIMERS; i++)
+	    m_perf_stage[i].print(timers_name[i]);
+      }
+      m_perf_group[SHM_RD].close();
+      m_perf_group[SHM_WR].close();
+      delete[] m_perf_stage;
+      m_perf_stage = NULL;
+   }
    
    // unlock after all actions
-   if (! m_mode_debug) {
+   if (! m_mode_debug && ! m_source) {
       // remove the lock file
       string shcmd = "rm ";
       shcmd += m_lock_file;
@@ -299,13 +526,10 @@ void SupixDAQ::finalize()
 #ifdef DEBUG
 #define DBG_RUN(x)						\
    if (m_verbosity >= V_DEBUG)					\
-      COUT << "DBG#" << nloop << " " << __func__ <<":" << (x)	\
-	   << " run_status=" << m_run_status			\
-	   << " nreads=" << m_runinfo.nreads			\
-	   << " nsaved=" << m_runinfo.nsaved			\
-	   << " wr_mode=" << m_wr_mode				\
-	   << " " << m_pipeline->sprint()			\
-	   << endl
+      alog("DBG#%lu %s:%s run_status=%d nreads=%lu nsaved=%lu wr_mode=%d %s", \
+	   nloop, __func__, (x), (int)m_run_status,		\
+	   m_runinfo.nreads, m_runinfo.nsaved, (int)m_wr_mode,	\
+	   m_pipeline->sprint().c_str() )
 #else
 #define DBG_RUN(x)
 #endif
@@ -321,6 +545,11 @@ void SupixDAQ::start_run()
    // after initialize() to ensure trig_cds_x and chip_addr having been set.
    set_trig_cds();
 
+   alog_register();
+   apply_sched(SHM_RD);
+   if (m_perf_stage)	m_perf_group[SHM_RD].open();	// counts this thread
+   if (m_trace[SHM_RD])	m_trace[SHM_RD]->set_tid();
+
    // open...
    new_outfiles();
    
@@ -332,6 +561,7 @@ void SupixDAQ::start_run()
       nloop++;
       DBG_RUN("loop-head");
 
+      m_timer_frame[SHM_RD] = m_runinfo.nreads;	// timers of this frame, all or none
       x_timers[Tstart_run]->start();
 
       rv = reader_run();
@@ -341,12 +571,15 @@ void SupixDAQ::start_run()
       
       // information
       if (nloop%1000 == 0)
-	 LOG << "#" << nloop << " " << sprint() << endl;
+	 ALOG("#%lu %s", nloop, sprint().c_str() );
+      if (nloop % m_shm_every == 0)
+	 publish(SHM_RD);
       x_timers[Tstart_run]->stop();	// for whole loop
       DBG_RUN("loop-tail");
    }
    while (! is_run_stop() );		//~main loop
    
+   publish(SHM_RD);
    LOG << sprint("RETURN") << endl;
 }
 
@@ -371,9 +604,13 @@ int SupixDAQ::reader_run()
       //    m_locate_last_pixel = false;
    }
 
+   if (m_trace[SHM_RD])	m_trace[SHM_RD]->set_frame(m_runinfo.nreads);
+
    // is pipeline full?
+   unsigned long long twait = 0;
    while(m_pipeline->is_full() ) {
       DBG_RUN("is_full");
+      if (! twait)	twait = timer_now_ns();
       x_counts[ISFULL]++;
       if (wait_timeout("ISFULL") ) {
 	 alt_run_status(RUN_STOP);
@@ -383,6 +620,11 @@ int SupixDAQ::reader_run()
 	 return E_ISFULL;
       }
    }
+   if (twait) {
+      unsigned long long dt = timer_now_ns() - twait;
+      m_isfull_ns += dt;
+      if (m_trace[SHM_RD])	m_trace[SHM_RD]->span("wait non-full", twait, dt);
+   }
    // if (is_run_stop() )	break;
 
    x_timers[Tread]->start();		// for saved frames
@@ -459,6 +701,8 @@ int SupixDAQ::writer_run()
       usleep(m_timewait);
    }
 
+   if (m_trace[SHM_WR])	m_trace[SHM_WR]->set_frame(m_frame);
+   unsigned long long tprocd = m_tune_sim ? timer_now_ns() : 0;	// retune(), even NOTIMERS
    x_timers[Tprocd]->start();		// for processed frames
 
    // is first? reset trig
@@ -486,6 +730,12 @@ int SupixDAQ::writer_run()
    m_frame++;
    m_runinfo.nprocs++;
    x_timers[Tprocd]->stop();		// for processed frames
+   if (m_tune_sim) {
+      m_tune_nprocd++;
+      m_tune_busy += (timer_now_ns() - tprocd) / 1e3;
+      if (m_frame % m_tune_every == 0)	// its simulation not in the cost
+	 retune();
+   }
 
    return E_OK;
 }
@@ -521,6 +771,8 @@ void SupixDAQ::noise_run()
 	 decode_frame();		// after checking frame_1st
 	 do_noise();
       }
+      if (nloop % m_shm_every == 0)
+	 publish(SHM_RD);
       
    }
    while (! is_run_stop() );		//~main loop
@@ -626,23 +878,32 @@ void SupixDAQ::child_run()
 {  TRACE;
    // static bool reset_frame_1st = false;
    
+   alog_register();
+   apply_sched(SHM_WR);
+   if (m_perf_stage)	m_perf_group[SHM_WR].open();	// counts this thread
+   if (m_trace[SHM_WR])	m_trace[SHM_WR]->set_tid();
+
    // write-out main loop
    unsigned long nloop = 0;
    int rv;
    while(1) {
       nloop++;
       DBG_RUN("loop-head");
+      m_timer_frame[SHM_WR] = m_frame;	// timers of this frame, all or none
       x_timers[Tchild_run]->start();
 
       rv = writer_run();
       if (rv == E_RUNSTOP) {
 	 break;
       }
+      if (nloop % m_shm_every == 0)
+	 publish(SHM_WR);
       
       x_timers[Tchild_run]->stop();
       DBG_RUN("loop-tail");
    }	//~ write-out main loop
 
+   publish(SHM_WR);
    LOG << sprint("RETURN") << endl;
 
 }
@@ -775,7 +1036,7 @@ trig_t SupixDAQ::triged()
    x_timers[Ttriged]->start();
    m_trig = 0;
 
-   if ( (m_frame+1) % m_runinfo.trig_period == 0) {
+   if ( (m_frame+1) % m_runinfo.trig_period == 0 && m_shed_level < SHED_PERIOD) {
       m_trig |= TRIG_PERIOD ;
       m_runinfo.ntrigs_period++;
    }
@@ -800,16 +1061,18 @@ int SupixDAQ::trig_cds()
 
    cds_t *	pcds = m_pixel_cds;
    double*	pthr = m_threshold;
-   ostringstream oss;
-   oss << " (row col cds thr):";
+   std::string	detail;		// V_DEBUG only
    for (int ir=0; ir < NROWS; ir++) {
       for (int ic=0; ic < NCOLS; ic++) {
 	 //if (*pcds > *pthr) {		// positive pulse
 	 if ( *pcds < *pthr ) {		// negative pulse
 	    m_pixid[npixs] = (ir << NBITS_COL) + ic;
 	    npixs++;
-	    if (m_verbosity >= V_DEBUG)
-	       oss << " " << npixs << "=(" << ir << " " << ic << " " << *pcds << " " << *pthr << ")";
+	    if (m_verbosity >= V_DEBUG) {
+	       char str[80];
+	       snprintf(str, sizeof(str), " %d=(%d %d %d %g)", npixs, ir, ic, *pcds, *pthr);
+	       detail += str;
+	    }
 	 }
 	 // next
 	 pcds++;
@@ -820,12 +1083,11 @@ int SupixDAQ::trig_cds()
    m_npixs = npixs;		// updated ONLY when having fired pixels for waveform analysis
    if (npixs) {
       // run information
-      if (m_runinfo.ntrigs % 1000 == 0) {
-	 LOG << "#triged=" << m_runinfo.ntrigs + 1	// .ntirgs updated later
-	     << " frame=" << m_frame
-	     << " npixs=" << npixs
-	     << ( m_verbosity >= V_DEBUG ?  oss.str() : "" )
-	     << endl;
+      if (! m_quiet && m_runinfo.ntrigs % 1000 == 0) {
+	 ALOG("#triged=%lu frame=%lu npixs=%d%s%s",
+	      m_runinfo.ntrigs + 1,	// .ntirgs updated later
+	      (unsigned long)m_frame, npixs,
+	      detail.size() ? " (row col cds thr):" : "", detail.c_str() );
       }
    }
    
@@ -838,9 +1100,15 @@ void SupixDAQ::do_trig()
 {  TRACE;
    // OUT_MODE_t mode = O_T0P0;	// pipeline_t out action
    int nframe_wr = 0;
+   if (m_shed)	shed_load();	// before any decision
    trig_t trig = triged();	// do it explicitly
    if (m_runinfo.daq_mode == M_CONTINUOUS || trig > 0) {	// new trigger
       x_timers[Twrite]->start();		// for recorded frames
+      // pixels of this trigger, kept in the pre/post frames under ZS
+      if (m_shed) {
+	 m_zs_npixs = m_npixs;
+	 memcpy(m_zs_pixid, m_pixid, sizeof(UShort_t) * m_npixs);
+      }
 
       // pre_trigs
       int pre_trigs = m_pipeline->get_pre();
@@ -882,12 +1150,18 @@ void SupixDAQ::do_trig()
    m_pipeline->next_out(m_wr_mode);		// after data processed
    x_timers[Tnext_out]->stop();		// for non-recorded frames
 
+   // sample load for the threshold controller
+   if (m_trig_ctrl && m_frame % m_ctrl_every == 0)
+      control_trig();
+
    // after pipeline updated
    // check filesize limits after a whole waveform write-out.
    if ((m_runinfo.daq_mode == M_CONTINUOUS || (m_wr_mode == O_T0P1 && ! m_pipeline->is_post() ) ) &&
        (m_filesize_raw > m_filesize_max || m_filesize_root > m_filesize_max)
        ) {
+      x_timers[Tnew_outfiles]->start();
       new_outfiles();
+      x_timers[Tnew_outfiles]->stop();
    }
 
    if (m_verbosity >= V_DEBUG)
@@ -910,10 +1184,10 @@ void SupixDAQ::write_out()
       x_timers[Twr_raw]->stop();
    }
 
-   // root files
-   if (m_write_root) {
+   // root files, dropped first under load if raw kept
+   if (m_write_root && ! (m_shed_level >= SHED_NOROOT && m_write_raw) ) {
       x_timers[Twr_root]->start();
-      m_filesize_root += m_tree->Fill();
+      m_filesize_root += fill_tree();
       x_timers[Twr_root]->stop();
    }
 
@@ -940,7 +1214,7 @@ void SupixDAQ::write_out(int nframes)
    }
 
    // root files
-   if (m_write_root) {
+   if (m_write_root && ! (m_shed_level >= SHED_NOROOT && m_write_raw) ) {
       // roll-back & restore:
       //   - m_trig
       //   - m_frame and m_fid will do it automatically
@@ -956,7 +1230,7 @@ void SupixDAQ::write_out(int nframes)
 	 m_pre_adc->bubble();
 	 m_pre_cds->bubble();
 	 x_timers[Twr_root]->start();
-	 m_filesize_root += m_tree->Fill();
+	 m_filesize_root += fill_tree();
 	 x_timers[Twr_root]->stop();
 	 m_pre_adc->pop();
 	 m_pre_cds->pop();
@@ -1074,10 +1348,8 @@ int SupixDAQ::check_integrity()
    // update for a good frame
    if (rv == 0)		fid_last = fid_now;
    else {
-      static char str[MAXLINE];
-      sprintf(str, "ERROR: read=%#8X (fid=%X row=%X col=%X adc=%4X) expected=(%X %X %X) "
-      	      , data, fid, row, col, adc, (fid_last+1)%fid_max, ir+1, ic);
-      CERR << str << sprint() << endl;
+      AERR_LIMIT(1.0, "ERROR: read=%#8X (fid=%X row=%X col=%X adc=%4X) expected=(%X %X %X) %s"
+		 , data, fid, row, col, adc, (fid_last+1)%fid_max, ir+1, ic, sprint().c_str() );
       
       fid_last = fid_max;		// reset last frame id
    }
@@ -1150,7 +1422,7 @@ int SupixDAQ::read_fifo(unsigned char *buf, int nbyte)
    //if (nbyte == 0) 	return 0;	// used for EOF
    if (nbyte == 0) 	nbyte = FRAMESIZE;
    x_timers[Trd_fifo]->start();
-   int rv = read_all(m_fd_fifo, buf, nbyte);
+   int rv = m_source ? m_source->read(buf, nbyte) : read_all(m_fd_fifo, buf, nbyte);
    x_timers[Trd_fifo]->stop();
    return rv;
 }
@@ -1210,6 +1482,7 @@ void SupixDAQ::new_outfiles()
 	 close_raw();
       }
       
+      m_filesize_sum += m_filesize_raw;
       fn_raw	= oss.str() + ".data";
       m_filename_raw	= fn_raw.c_str();
       m_fd_raw = open_fd(m_filename_raw);
@@ -1222,6 +1495,7 @@ void SupixDAQ::new_outfiles()
 	 close_root();
       }
 
+      m_filesize_sum += m_filesize_root;
       fn_root	= oss.str() + ".root";
       m_filename_root	= fn_root.c_str();
       m_tfile = new TFile(m_filename_root, "NEW");
@@ -1297,6 +1571,7 @@ int SupixDAQ::close_root()
    // m_tree->Print();
 
    // save all objects in the file
+   save_shed();
    m_tfile->Write();
    m_tree->Print();
    m_tree->GetUserInfo()->First()->Print();
@@ -1332,6 +1607,11 @@ int SupixDAQ::open_tree()
 {  TRACE;
    m_tree = new TTree("supix", "test chip");
 
+   // compression of the branches booked below
+   TFile *file = m_tree->GetCurrentFile();
+   if (file && m_root_compress >= 0)
+      file->SetCompressionSettings(m_root_compress);
+
    // if the file size reaches TTree::GetMaxTreeSize(), the current
    // file is closed and a new file is created as filename_N.root.
    // TTree::SetMaxTreeSize(m_filesize_max);
@@ -1372,6 +1652,9 @@ int SupixDAQ::open_tree()
    m_tree->Branch("trig", &m_trig, "trig/b" );			// trigger pattern
    m_tree->Branch("fid", &m_fid, "fid/B" );			// local frame id
 
+   if (m_root_basket > 0)	m_tree->SetBasketSize("*", m_root_basket);
+   if (m_root_autoflush)	m_tree->SetAutoFlush(m_root_autoflush);
+
    // LOG << "TTree::SetMaxTreeSize(" << m_filesize_max << ")"
    //     << " SetAutoSave(" << GB << ")"
    //     << endl;
@@ -1389,6 +1672,34 @@ int SupixDAQ::open_tree()
 }
 
 
+// fill the tree with the frame at the top of stacks.
+// - zero-suppressed under load: only pixels fired by the trigger of the
+//   window, saved by do_trig(), are kept in the triged frame and its
+//   pre/post frames; the stacks are restored after Fill().
+//______________________________________________________________________
+int SupixDAQ::fill_tree()
+{
+   if (m_shed_level < SHED_ZS)
+      return m_tree->Fill();
+
+   memcpy(m_zs_adc, m_pixel_adc, sizeof(adc_t) * NPIXS);
+   memcpy(m_zs_cds, m_pixel_cds, sizeof(cds_t) * NPIXS);
+   memset(m_pixel_adc, 0, sizeof(adc_t) * NPIXS);
+   memset(m_pixel_cds, 0, sizeof(cds_t) * NPIXS);
+   for (int i=0; i < m_zs_npixs; i++) {
+      int id = m_zs_pixid[i];	// = row * NCOLS + col
+      m_pixel_adc[id] = m_zs_adc[id];
+      m_pixel_cds[id] = m_zs_cds[id];
+   }
+
+   int rv = m_tree->Fill();
+
+   memcpy(m_pixel_adc, m_zs_adc, sizeof(adc_t) * NPIXS);
+   memcpy(m_pixel_cds, m_zs_cds, sizeof(cds_t) * NPIXS);
+   return rv;
+}
+
+
 ////////////////////////////////////////////////////////////////////////
 
 
@@ -1398,7 +1709,7 @@ bool SupixDAQ::wait_timeout(const char* msg)
    const  int maxtry = 10;
    static int ntry = 0;
    static int timeout = 0;		// accumulated wait time
-   static int timewait = m_timewait;	// time per wait
+   int timewait = m_timewait;		// time per wait, may be retuned
    usleep(timewait);
    if (m_run_status == RUN_STOP) {
       LOG << sprint() << " RUN_STOP " << endl;
@@ -1464,6 +1775,8 @@ std::string SupixDAQ::time_tag(bool count)
 int SupixDAQ::select_chip_addr()
 {  TRACE;
 
+   if (m_source)	return 0;	// no device
+
    // encode command to send
    unsigned char cmd = 0xF8 | (m_runinfo.chip_addr >>1);
    // 11111xxx 11111 is default, xxx chip selset from 000 to 100 --LongLI
@@ -1543,11 +1856,26 @@ void SupixDAQ::set_trig_cds()
 
    double cds_mean, cds_sigma;
    double adc_mean, adc_sigma;
-   double* pthrs	= m_threshold;
    double* pcds_mean	= (double*)(m_runinfo.cds_mean);
    double* pcds_sigma	= (double*)(m_runinfo.cds_sigma);
    double* padc_mean	= (double*)(m_runinfo.adc_mean);
    double* padc_sigma	= (double*)(m_runinfo.adc_sigma);
+   if (m_source) {
+      // replayed frames: noise of the bank, not of the synthetic ones
+      int n = m_source->get_noise(padc_mean, padc_sigma, pcds_mean, pcds_sigma);
+      if (n)
+	 LOG << "noise of " << n << " replayed frames" << endl;
+      else {			// known noise: CDS of 2 independent ADCs
+	 for (int i=0; i < NPIXS; i++) {
+	    pcds_mean[i]	= 0;
+	    pcds_sigma[i]	= m_source->get_sigma() * sqrt(2.);
+	    padc_mean[i]	= m_source->get_pedestal();
+	    padc_sigma[i]	= m_source->get_sigma();
+	 }
+      }
+      calc_threshold();
+      return;
+   }
    string fnoise	= noise_file();
    ifstream ifs(fnoise.c_str() );
    if (! ifs.is_open() ) {
@@ -1568,20 +1896,17 @@ void SupixDAQ::set_trig_cds()
 	 *pcds_sigma = cds_sigma;
 	 *padc_mean = adc_mean;
 	 *padc_sigma = adc_sigma;
-	 //*pthrs = cds_mean + cds_sigma * m_runinfo.trig_cds_x;	// positive pulse
-	 //*pthrs = (cds_t)(cds_mean - cds_sigma * m_runinfo.trig_cds_x -0.5);		// negative pulse
-	 *pthrs = cds_mean - cds_sigma * m_runinfo.trig_cds_x;		// negative pulse
 	 // next
 	 pcds_mean++;
 	 pcds_sigma++;
 	 padc_mean++;
 	 padc_sigma++;
-	 pthrs++;
 	 //cout << setw(6) << setprecision(1) << fixed << cds_mean << "/" << cds_sigma;
       }
       //cout << endl;
    }
    ifs.close();
+   calc_threshold();
    m_runinfo.Print_threshold();
    
    //[obsolete]
@@ -1625,8 +1950,427 @@ void SupixDAQ::set_trig_cds()
    // LOG << noise_file << endl;
 }
 
+// CDS threshold of each pixel from noise and trig_cds_x.
+//______________________________________________________________________
+void SupixDAQ::calc_threshold()
+{  TRACE;
+   double* pthrs	= m_threshold;
+   double* pcds_mean	= (double*)(m_runinfo.cds_mean);
+   double* pcds_sigma	= (double*)(m_runinfo.cds_sigma);
+   for (int i=0; i < NPIXS; i++) {
+      //*pthrs = cds_mean + cds_sigma * m_runinfo.trig_cds_x;	// positive pulse
+      //*pthrs = (cds_t)(cds_mean - cds_sigma * m_runinfo.trig_cds_x -0.5);		// negative pulse
+      *pthrs = *pcds_mean - *pcds_sigma * m_runinfo.trig_cds_x;		// negative pulse
+      // next
+      pcds_mean++;
+      pcds_sigma++;
+      pthrs++;
+   }
+}
+
+// adjust trig_cds_x to keep occupancy and bandwidth below targets.
+// - WR thread, the same as trig_cds()
+// - recorded in RunInfo, effective from the next frame
+//______________________________________________________________________
+void SupixDAQ::control_trig()
+{  TRACE;
+   double x = m_runinfo.trig_cds_x;
+   double nbytes = m_filesize_sum + m_filesize_raw + m_filesize_root;
+   if (! m_trig_ctrl->update(mono_sec(), m_runinfo.ntrigs, nbytes, m_pipeline->occupancy(), x) )
+      return;
+
+   m_runinfo.trig_cds_x = x;
+   calc_threshold();
+   m_runinfo.ctrl_frame.push_back(m_frame);
+   m_runinfo.ctrl_cds_x.push_back(x);
+
+   LOG << "frame=" << m_frame
+       << " trig_cds_x=" << x
+       << " occupancy=" << per_centage(m_trig_ctrl->get_occupancy()) << "%"
+       << " bandwidth=" << m_trig_ctrl->get_byte_rate() / MiB << "MiB/s"
+       << " trig_rate=" << m_trig_ctrl->get_trig_rate() << "Hz"
+       << endl;
+}
+
+// update load-shedding level per frame
+// - WR thread
+//______________________________________________________________________
+void SupixDAQ::shed_load()
+{  TRACE;
+   double occ = m_pipeline->occupancy();
+   int level = m_shed->update(occ, mono_sec());
+   if (level == m_shed_level)	return;
+
+   // shorten post-trigger window by half
+   // recorded for build_waveform()
+   if ( (level >= SHED_POST) != (m_shed_level >= SHED_POST) ) {
+      int post = level >= SHED_POST ? m_runinfo.post_trigs / 2 : m_runinfo.post_trigs;
+      m_pipeline->set_post_max(post);
+      m_runinfo.shed_post_frame.push_back(m_frame);
+      m_runinfo.shed_post_trigs.push_back(post);
+   }
+
+   LOG << "frame=" << m_frame
+       << " shed level " << m_shed_level << " -> " << level
+       << " occupancy=" << per_centage(occ) << "%"
+       << endl;
+   m_shed_level = level;
+}
+
+// load-shedding accounting into RunInfo
+//______________________________________________________________________
+void SupixDAQ::save_shed()
+{  TRACE;
+   if (! m_shed)	return;
+   for (int k=0; k < SHED_LEVELS; k++) {
+      m_runinfo.shed_entered[k] = m_shed->get_entered(k);
+      m_runinfo.shed_frames[k]	= m_shed->get_frames(k);
+      m_runinfo.shed_seconds[k] = m_shed->get_seconds(k);
+   }
+}
+
+// auto-tune: time read, decode + trigger and write of a few frames
+// from the FIFO (or its stand-in), then size the pipeline by pipesim_t.
+// - ROOT filling is not known yet, it is learned by retune().
+//______________________________________________________________________
+void SupixDAQ::calibrate()
+{  TRACE;
+   const int capacity_max = 256 * MiB / FRAMESIZE;	// memory limit
+
+   // timer_now_ns(), not Timer: no-ops under NOTIMERS
+   LatencyHist hread, hcomm, hwrite;		// nsec
+   double sread = 0, scomm = 0, swrite = 0;	// usec
+   unsigned long long t0, dt;
+   unsigned char *buf	= (unsigned char*)malloc(FRAMESIZE);
+   adc_t *	adc	= (adc_t*)calloc(NPIXS, sizeof(adc_t) );
+   cds_t *	cds	= (cds_t*)calloc(NPIXS, sizeof(cds_t) );
+   double *	thr	= (double*)malloc(NPIXS * sizeof(double) );
+   for (int i=0; i < NPIXS; i++)	thr[i] = -1e9;	// never fired
+   string fn = m_datadir + "/calibrate.tmp";
+   int fd = (m_write_raw || m_write_root) ? open_fd(fn.c_str() ) : -1;
+   select_chip_addr();		// frames of the chip start_run() will read
+
+   int nframes = 0, nfired = 0;
+   for (; nframes < m_tune_frames; nframes++) {
+      t0 = timer_now_ns();
+      int rv = m_source ? m_source->read(buf, FRAMESIZE) : read_all(m_fd_fifo, buf, FRAMESIZE);
+      if (rv <= 0)	break;
+      dt = timer_now_ns() - t0;
+      hread.add(dt);
+      sread += dt / 1e3;
+
+      t0 = timer_now_ns();	// as decode_frame() + trig_cds()
+      pixel_t *ptr = (pixel_t*)buf;
+      ushort fid, row, col, a;
+      int npixs = 0;
+      for (int i=0; i < NPIXS; i++) {
+	 fpga_decode(ptr[i], fid, row, col, a);
+	 cds[i] = a - adc[i];
+	 adc[i] = a;
+	 if (cds[i] < thr[i])	npixs++;
+      }
+      if (npixs)	nfired++;
+      dt = timer_now_ns() - t0;
+      hcomm.add(dt);
+      scomm += dt / 1e3;
+
+      if (fd >= 0) {
+	 t0 = timer_now_ns();
+	 write_all(fd, buf, FRAMESIZE);
+	 dt = timer_now_ns() - t0;
+	 hwrite.add(dt);
+	 swrite += dt / 1e3;
+      }
+   }
+   if (fd >= 0) {
+      close_fd(fd, fn.c_str() );
+      unlink(fn.c_str() );
+   }
+   struct stat st;		// a stand-in file rewound, a FIFO can't be
+   if (m_mode_debug && ! m_source && fstat(m_fd_fifo, &st) == 0 && S_ISREG(st.st_mode) )
+      lseek(m_fd_fifo, 0, SEEK_SET);
+   free(buf);
+   free(adc);
+   free(cds);
+   free(thr);
+   if (nframes < 10) {
+      CERR << "calibration: " << nframes << " frames read, not tuned" << endl;
+      return;
+   }
+
+   double t_read  = sread / nframes;		// usec per frame
+   double t_comm  = scomm / nframes;
+   double t_write = hwrite.get_n() ? swrite / hwrite.get_n() : 0;
+
+   // expected triggers
+   m_tune_sim = new pipesim_t;
+   m_tune_sim->set_dist(PSIM_READ, hread);
+   m_tune_sim->set_dist(PSIM_COMM, hcomm);
+   m_tune_sim->set_const(PSIM_SKIP, 0);
+   if (fd >= 0)	m_tune_sim->set_dist(PSIM_WRITE, hwrite);
+   else		m_tune_sim->set_const(PSIM_WRITE, 0);
+   m_tune_cfg.pre_trigs	 = m_runinfo.pre_trigs;
+   m_tune_cfg.post_trigs = m_runinfo.post_trigs;
+   m_tune_cfg.trig_ratio = m_tune_ratio;
+   if (m_tune_cfg.trig_ratio <= 0 && m_runinfo.trig_period > 0)
+      m_tune_cfg.trig_ratio = 1. / m_runinfo.trig_period;
+   if (m_runinfo.daq_mode == M_CONTINUOUS)
+      m_tune_cfg.trig_ratio = 1;
+   if (m_write_raw || m_write_root)
+      m_tune_cfg.rotate_frames = m_filesize_max / FRAMESIZE;
+
+   int L = m_tune_sim->recommend(m_tune_cfg, 1e-3, capacity_max);
+   if (L < 0) {
+      CERR << "calibration: overflow even with " << capacity_max << " frames" << endl;
+      L = capacity_max;
+   }
+   m_tune_cfg.pipeline_max = L;
+   pipesim_result_t r = m_tune_sim->run(m_tune_cfg, 1000000);
+   double eps = r.frames ? (double)r.recorded / r.frames : 0;
+
+   m_pipeline_max  = L;
+   m_tune_capacity = 4 * L < capacity_max ? 4 * L : capacity_max;	// room to retune
+   m_tune_pace	   = t_read;
+   m_tune_cost	   = t_comm + eps * t_write;
+   int timewait	   = (int)(m_tune_pace / 4);
+   if (timewait < 1)		timewait = 1;
+   if (timewait > 1000)		timewait = 1000;
+   m_timewait	   = timewait;		// before the reader starts
+   m_timeout	   = (int)(10 * L * m_tune_cost);	// to drain a full pipeline
+   if (m_timeout < 1000000)	m_timeout = 1000000;
+
+   m_runinfo.tune_t_read  = t_read;
+   m_runinfo.tune_t_comm  = t_comm;
+   m_runinfo.tune_t_write = t_write;
+   m_tune_t = -1;		// first retune() takes a snapshot
+
+   LOG << "calibration: " << nframes << " frames, usec read/comm/write = "
+       << t_read << "/" << t_comm << "/" << t_write
+       << ", trig_ratio=" << m_tune_cfg.trig_ratio
+       << endl << "\t" << m_tune_sim->sprint(r)
+       << endl << "\t" << "-> pipeline_max=" << m_pipeline_max
+       << " (capacity " << m_tune_capacity << ")"
+       << " timewait=" << timewait << " timeout=" << m_timeout
+       << endl;
+}
+
+// compare costs since the last check with the tuned ones, re-simulate
+// on drift. Costs ~0.1 sec of the writer, only when retuning: called
+// outside Tprocd, so that time is not taken for a cost drift.
+//______________________________________________________________________
+void SupixDAQ::retune()
+{  TRACE;
+   unsigned long n	= m_tune_nprocd;	// WR owned, timed even NOTIMERS
+   double sum		= m_tune_busy;
+   double t		= mono_sec();
+   unsigned long nreads = m_runinfo.nreads;	// RD counter, approximate
+   unsigned long ntrigs = m_runinfo.ntrigs;
+   if (m_tune_t < 0 || n <= m_tune_n || nreads <= m_tune_nreads) {
+      m_tune_t = t;
+      m_tune_n = n;
+      m_tune_sum = sum;
+      m_tune_nreads = nreads;
+      m_tune_ntrigs = ntrigs;
+      return;
+   }
+
+   double cost = (sum - m_tune_sum) / (n - m_tune_n);
+   double pace = (t - m_tune_t) * 1e6 / (nreads - m_tune_nreads);
+   double trig_ratio = (double)(ntrigs - m_tune_ntrigs) / m_tune_every;
+   m_tune_t = t;
+   m_tune_n = n;
+   m_tune_sum = sum;
+   m_tune_nreads = nreads;
+   m_tune_ntrigs = ntrigs;
+
+   double dcost = fabs(cost / m_tune_cost - 1);
+   double dpace = fabs(pace / m_tune_pace - 1);
+   double dtrig = m_tune_cfg.trig_ratio > 0 ? fabs(trig_ratio / m_tune_cfg.trig_ratio - 1) : 0;
+   if (dcost < m_tune_drift && dpace < m_tune_drift && dtrig < m_tune_drift)	return;
+
+   // scale distributions of the last tuning to the measured means
+   m_tune_sim->dist(PSIM_READ).scale(pace / m_tune_pace);
+   m_tune_sim->dist(PSIM_COMM).scale(cost / m_tune_cost);
+   m_tune_sim->dist(PSIM_WRITE).scale(cost / m_tune_cost);
+   if (x_timers[Tnew_outfiles]->get_n() )	// none under NOTIMERS: as calibrated
+      m_tune_sim->set_dist(PSIM_ROTATE, x_timers[Tnew_outfiles]->get_hist() );
+   if (trig_ratio > 0)
+      m_tune_cfg.trig_ratio = trig_ratio;
+   m_tune_cost = cost;
+   m_tune_pace = pace;
+
+   int L = m_tune_sim->recommend(m_tune_cfg, 1e-3, m_tune_capacity, 200000);
+   if (L < 0)	L = m_tune_capacity;
+   m_pipeline->set_limit(L);
+   m_tune_cfg.pipeline_max = L;
+   int timewait = (int)(pace / 4);
+   if (timewait < 1)		timewait = 1;
+   if (timewait > 1000)		timewait = 1000;
+   m_timewait = timewait;		// atomic: RD reads it in its waits
+
+   m_runinfo.tune_frame.push_back(m_frame);
+   m_runinfo.tune_pipeline.push_back(L);
+   ALOG("frame=%lu usec cost/pace=%.3f/%.3f trig_ratio=%g -> pipeline_max=%d timewait=%d",
+	(unsigned long)m_frame, cost, pace, trig_ratio, L, timewait);
+}
+
+// end-to-end benchmark: one TSV line per run with the synthetic source.
+// - elapsed time from the source timeline: frames produced / fps.
+// - sustained: no frame lost by the FIFO, run completed.
+//______________________________________________________________________
+std::string SupixDAQ::bench_header()
+{
+   std::string s = "fps\tsec\tfps_read\tlost\tlost_frac\tnonintegrity"
+      "\tisfull\tisfull_frac\tntrigs\tnrecords\tMBps"
+      "\traw\troot\tpre\tpost\tpipeline_max"
+      "\tcpus_rd\tcpus_wr\tprio_rd\tprio_wr\tmem\tlost_1s\tcompleted";
+   for (size_t i=0; i < sizeof(bench_timers)/sizeof(int); i++) {
+      s += "\tus_";
+      for (const char *c = timers_name[bench_timers[i]]; *c; c++)
+	 s += *c == ' ' ? '_' : *c == '@' ? '+' : *c;
+   }
+   s += "\tus_rd_fifo_p50\tus_rd_fifo_p99\tus_rd_fifo_p999\tus_rd_fifo_max";	// jitter
+   return s;
+}
+
+std::string SupixDAQ::bench_report()
+{  TRACE;
+   double fps	= m_source->get_fps();
+   double sec	= (m_source->get_produced() + 1) / fps;
+   double bytes	= m_filesize_sum + m_filesize_raw + m_filesize_root;
+   // all frames, no timeout or data error on the way
+   bool completed = m_maxframe > 0 && m_runinfo.nreads >= m_maxframe
+      && x_counts[TIMEOUT] == 0 && x_counts[NONINTEGRITY] == 0;
+   ostringstream oss;
+   oss << fps
+       << "\t" << sec
+       << "\t" << m_runinfo.nreads / sec
+       << "\t" << m_source->get_lost()
+       << "\t" << m_source->get_lost() / (double)(m_source->get_produced() + 1)
+       << "\t" << x_counts[NONINTEGRITY]
+       << "\t" << x_counts[ISFULL]
+       << "\t" << m_isfull_ns * 1e-9 / sec
+       << "\t" << m_runinfo.ntrigs
+       << "\t" << m_runinfo.nrecords
+       << "\t" << bytes / MiB / sec
+       << "\t" << m_write_raw
+       << "\t" << m_write_root
+       << "\t" << m_runinfo.pre_trigs
+       << "\t" << m_runinfo.post_trigs
+       << "\t" << m_pipeline_max
+       << "\t" << cpus_sprint(&m_cpus[SHM_RD])
+       << "\t" << cpus_sprint(&m_cpus[SHM_WR])
+       << "\t" << m_rt_prio[SHM_RD]
+       << "\t" << m_rt_prio[SHM_WR]
+       << "\t" << mem_flags_sprint(m_mem_flags)
+       << "\t" << m_source->get_lost_1s()
+       << "\t" << completed
+      ;
+   for (size_t i=0; i < sizeof(bench_timers)/sizeof(int); i++)
+      oss << "\t" << x_timers[bench_timers[i]]->get_mean();
+   LatencyHist &h = x_timers[Trd_fifo]->get_hist();
+   oss << "\t" << h.get_percentile(50) * 1e-3
+       << "\t" << h.get_percentile(99) * 1e-3
+       << "\t" << h.get_percentile(99.9) * 1e-3
+       << "\t" << h.get_max() * 1e-3;
+   return oss.str();
+}
+
+// simulation input from timer histograms, indexed by timers_t
+//______________________________________________________________________
+static bool pipesim_setup(pipesim_t &sim, LatencyHist *hists[NTIMERS])
+{
+   if (! hists[Tread] || ! hists[Tread]->get_n() )	return false;
+   sim.set_dist(PSIM_READ, *hists[Tread]);
+   const int comm[] = { Tdecode_frame, Tis_first, Ttriged, Tnext_out };
+   for (int i=0; i < 4; i++)
+      if (hists[comm[i]])	sim.add_comm(*hists[comm[i]]);
+   if (hists[Tskip])		sim.set_dist(PSIM_SKIP,  *hists[Tskip]);
+   if (hists[Twrite])		sim.set_dist(PSIM_WRITE, *hists[Twrite]);
+   if (hists[Tnew_outfiles] && hists[Tnew_outfiles]->get_n() )
+      sim.set_dist(PSIM_ROTATE, *hists[Tnew_outfiles]);
+   return true;
+}
+
+// simulate the pipeline with the configuration of this DAQ
+//______________________________________________________________________
+void SupixDAQ::simulate(LatencyHist *hists[NTIMERS], double trig_ratio)
+{  TRACE;
+   pipesim_t sim;
+   if (! pipesim_setup(sim, hists) ) {
+      LOG << "no timing to simulate" << endl;
+      return;
+   }
+   pipesim_config_t cfg;
+   cfg.pipeline_max	= m_pipeline_max;
+   cfg.pre_trigs	= m_runinfo.pre_trigs;
+   cfg.post_trigs	= m_runinfo.post_trigs;
+   cfg.trig_ratio	= trig_ratio;
+   if (m_write_raw || m_write_root)
+      cfg.rotate_frames = m_filesize_max / FRAMESIZE;
+
+   pipesim_result_t r = sim.run(cfg, 10000000);
+   int L = sim.recommend(cfg, 1e-3);
+   LOG << "simulated: pipeline_max=" << cfg.pipeline_max << " trig_ratio=" << trig_ratio
+       << " pre/post=" << cfg.pre_trigs << "/" << cfg.post_trigs
+       << endl << "\t" << sim.sprint(r)
+       << endl << "\t" << "recommended: -L " << L << " (P(overflow) < 1e-3 per sec)"
+       << endl;
+}
+
+// beside the log file: run-time output, not data
+std::string SupixDAQ::timing_fn()
+{
+   if (m_log_fn.empty() )	return "";
+   size_t slash = m_log_fn.rfind('/');
+   string dir = slash == string::npos ? "." : m_log_fn.substr(0, slash);
+   return dir + "/timing_last.txt";
+}
+
+// timing of this run for simulate() later
+//______________________________________________________________________
+void SupixDAQ::save_timing()
+{  TRACE;
+   string fn = timing_fn();
+   if (fn.empty() )	return;		// no -l
+   timing_file_t tf;
+   tf.add_param("trig_ratio", m_runinfo.nprocs ? (double)m_runinfo.ntrigs / m_runinfo.nprocs : 0);
+   tf.add_param("pre_trigs", m_runinfo.pre_trigs);
+   tf.add_param("post_trigs", m_runinfo.post_trigs);
+   tf.add_param("pipeline_max", m_pipeline_max);
+   tf.add_param("nsaved", m_runinfo.nsaved);
+   if (tf.save(fn.c_str(), x_timers, timers_name, NTIMERS) > 0)
+      LOG << "timing saved: " << fn << endl;
+}
+
+// recommend pipeline_max from the last run, daq.exe -K
+//______________________________________________________________________
+void SupixDAQ::recommend_last()
+{  TRACE;
+   timing_file_t tf;
+   string fn = timing_fn();
+   if (fn.empty() ) {
+      CERR << "no timing without a log, -l FILE of the last run" << endl;
+      return;
+   }
+   if (tf.load(fn.c_str() ) <= 0) {
+      CERR << "no timing in " << fn << endl;
+      return;
+   }
+   LatencyHist *hists[NTIMERS];
+   for (int i=0; i < NTIMERS; i++)
+      hists[i] = tf.get_hist(timers_name[i]);
+   LOG << "timing of " << fn << ": " << tf.get_param("nsaved") << " frames"
+       << ", pipeline_max=" << tf.get_param("pipeline_max") << endl;
+   simulate(hists, tf.get_param("trig_ratio") );
+}
+
 void SupixDAQ::recommend()		// recommend daq configuration
 {
+   if (x_timers[Tread]->get_n() == 0 || x_timers[Tprocd]->get_n() == 0) {
+      LOG << "no timing, no recommendation" << endl;	// -DNOTIMERS
+      return;
+   }
 
    // pipeline_max
    double t0	= x_timers[Tread]->get_mean();		// read-in
@@ -1720,6 +2464,85 @@ void SupixDAQ::recommend()		// recommend daq configuration
       << " alpha=Twrite/Tskip=" << alpha << "(" << sqrt(Valpha) << ")"
       << endl;
 
+   // discrete-event simulation on measured distributions
+   LatencyHist *hists[NTIMERS];
+   for (int i=0; i < NTIMERS; i++)
+      hists[i] = &x_timers[i]->get_hist();
+   simulate(hists, m_runinfo.nprocs ? (double)m_runinfo.ntrigs / m_runinfo.nprocs : 0);
+}
+
+
+// pin the calling thread and set its policy, effective ones logged;
+// a failure, e.g. EPERM of SCHED_FIFO without CAP_SYS_NICE, not fatal
+//______________________________________________________________________
+void SupixDAQ::apply_sched(int ith)
+{  TRACE;
+   const char *name = ith == SHM_RD ? "reader" : "writer";
+   int err;
+   if (CPU_COUNT(&m_cpus[ith]) && (err = cpus_pin(&m_cpus[ith]) ) )
+      CERR << name << ": pin to cpus " << cpus_sprint(&m_cpus[ith]) << ": " << strerror(err) << endl;
+   if (m_rt_prio[ith] > 0 && (err = sched_fifo(m_rt_prio[ith]) ) )
+      CERR << name << ": SCHED_FIFO/" << m_rt_prio[ith] << ": " << strerror(err) << endl;
+   LOG << name << ": " << sched_sprint() << endl;
+}
+
+// write spans of both threads, may be called while running
+//______________________________________________________________________
+void SupixDAQ::dump_trace()
+{  TRACE;
+   if (! m_trace[SHM_RD])	return;
+   std::ostringstream oss;
+   oss << m_datadir << "/trace_" << m_datatag << "_" << getpid() << "_" << m_trace_ndump++ << ".json";
+   int n = trace_dump(oss.str().c_str(), m_trace, 2);
+   if (n >= 0)
+      LOG << "trace: " << n << " spans -> " << oss.str() << endl;
+}
+
+// polls the signal flag: formatting 2 x 64k spans would stall the reader,
+// a busy alog flusher the dump
+void * SupixDAQ::trace_dumper(void *daq)
+{
+   SupixDAQ *p = (SupixDAQ*)daq;
+   while (p->m_trace_run.load() ) {
+      if (trace_requested() )
+	 p->dump_trace();
+      usleep(10000);
+   }
+   return NULL;
+}
+
+// update live statistics owned by a thread.
+// - lock-free, never blocks the DAQ threads
+//______________________________________________________________________
+void SupixDAQ::publish(int ith)
+{
+   if (! m_shm)	return;
+
+   shm_thread_t *p = &m_shm->thread[ith];
+   shmstats_begin(p);
+   if (ith == SHM_RD) {
+      shmstats_set(p->counts[SHM_READS],	m_runinfo.nreads);
+      shmstats_set(p->counts[SHM_SAVED],	m_runinfo.nsaved);
+      shmstats_set(p->counts[SHM_OCCUPANCY],	m_pipeline->occupancy() * 1e6);
+      shmstats_set(p->counts[SHM_ISFULL],	x_counts[ISFULL]);
+      shmstats_set(p->counts[SHM_WAITFIRST],	x_counts[WAITFIRST]);
+      shmstats_set(p->counts[SHM_NONINTEGRITY],	x_counts[NONINTEGRITY]);
+      shmstats_set(p->counts[SHM_TIMEOUT],	x_counts[TIMEOUT]);
+   }
+   else {
+      shmstats_set(p->counts[SHM_PROCS],	m_runinfo.nprocs);
+      shmstats_set(p->counts[SHM_RECORDS],	m_runinfo.nrecords);
+      shmstats_set(p->counts[SHM_TRIGS],	m_runinfo.ntrigs);
+      shmstats_set(p->counts[SHM_BYTES],	m_filesize_sum + m_filesize_raw + m_filesize_root);
+      shmstats_set(p->counts[SHM_WAITNEW],	x_counts[WAITNEW]);
+   }
+   for (int i=0; i < m_shm->ntimers; i++) {
+      if (timers_thread[i] != ith)	continue;
+      unsigned long n = x_timers[i]->get_calls();		// sampled or not
+      shmstats_set(p->timer_n[i],  n);
+      shmstats_set(p->timer_ns[i], x_timers[i]->get_mean() * n * 1000);	// usec -> nsec
+   }
+   shmstats_end(p);
 }
 
 
@@ -1738,6 +2561,13 @@ void SupixDAQ::print(const char *msg)
 	<< " maxframe=" << m_maxframe
 	<< " filesize_max=" << m_filesize_max << "bytes"
 	<< endl;
+   if (m_trig_ctrl)
+      COUT << "\t[control] trig_cds_x=" << m_runinfo.trig_cds_x
+	   << " in [" << m_ctrl_xmin << ", " << m_ctrl_xmax << "]"
+	   << " occupancy<" << m_ctrl_occ
+	   << " bandwidth<" << m_ctrl_bw / MiB << "MiB/s"
+	   << " adjusted=" << m_trig_ctrl->get_nadjust()
+	   << endl;
    m_pipeline->print();
    m_pre_adc->print("adc");
    m_pre_cds->print("cds");
@@ -1765,6 +2595,8 @@ SupixDAQ::sprint(const char* msg)
        << " 1st=" << m_frame_1st
        << " trig=" << (ushort)m_trig
       ;
+   if (m_shed)
+      oss << " shed=" << m_shed_level;
    
    // detail counters
    if (m_verbosity >= V_DEBUG || m_run_status == RUN_STOP) {
@@ -1783,3 +2615,159 @@ SupixDAQ::sprint(const char* msg)
 
    return oss.str();
 }
+
+
+////////////////////////////////////////////////////////////////////////
+
+// micro-benchmarks of the DAQ kernels on synthetic frames.
+// - no devices and no threads: the pipeline ring is filled once with
+//   consecutive frame ids, so check_integrity() always passes.
+// - ADC = pedestal + uniform noise in [0, 16), threshold -14 fires
+//   ~4 pixels per frame.
+// - files written in the data dir and removed.
+//______________________________________________________________________
+void SupixDAQ::bench(bench_t &b)
+{  TRACE;
+   const int nslots = 16;	// = frame id cycle
+   m_pipeline_max = nslots;
+   alloc_buffers();
+   m_frame_1st	= false;
+   m_quiet	= true;
+
+   unsigned int seed = 12345;
+   for (int k=0; k < nslots; k++) {
+      pixel_t *ptr = (pixel_t*)m_pipeline->get_in_ptr();
+      for (int ir=0; ir < NROWS; ir++) {
+	 for (int ic=0; ic < NCOLS; ic++) {
+	    seed = seed * 1103515245 + 12345;
+	    pixel_t adc = 8000 + ((seed >> 16) & 0xF);
+	    *ptr++ = ( ( ( (pixel_t)k << NBITS_ROW | (ir+1) ) << NBITS_COL | ic ) << NBITS_ADC ) | adc;
+	 }
+      }
+      m_pipeline->next_in(false);
+   }
+   for (int k=0; k < nslots; k++)
+      m_pipeline->next_out(O_NOISE);
+   for (int i=0; i < NPIXS; i++)	m_threshold[i] = -14;
+
+   pixel_t *words = (pixel_t*)m_pipeline->get_out_ptr();
+   int iw = 0;
+   b.run("fpga_decode", [&]() {
+	    ushort fid, row, col, adc;
+	    fpga_decode(words[iw], fid, row, col, adc);
+	    iw = (iw + 1) & (NPIXS - 1);
+	    bench_keep(fid + row + col + adc);
+	 }, 1. / NPIXS);
+
+   b.run("pipeline cycle", [&]() {	// is_full + next_in + next_out
+	    bench_keep(m_pipeline->is_full() );
+	    m_pipeline->next_in(false);
+	    m_pipeline->next_out(O_NOISE);
+	 }, 1);
+
+   b.run("check_integrity", [&]() {	// + pipeline cycle
+	    bench_keep(check_integrity() );
+	    m_pipeline->next_in(false);
+	    m_pipeline->next_out(O_NOISE);
+	 }, 1);
+
+   b.run("decode_frame", [&]() { decode_frame(); }, 1);
+   b.run("trig_cds", [&]() { bench_keep(trig_cds() ); }, 1);
+
+   b.run("ostack push", [&]() { bench_keep(m_pre_adc->push() ); }, 1);
+   b.run("ostack bubble", [&]() { bench_keep(m_pre_adc->bubble() ); }, 1);
+   b.run("ostack push+pop", [&]() {
+	    m_pre_adc->push();
+	    bench_keep(m_pre_adc->pop() );
+	 }, 1);
+
+   // the clock under every Timer; a Timer itself is a no-op under NOTIMERS
+   b.run("timer_now_ns", [&]() { bench_keep(timer_now_ns() ); });
+#ifndef NOTIMERS
+   Timer timer("bench");
+   b.run("Timer start+stop", [&]() { timer.start(); timer.stop(); });
+#endif
+
+   // page cache write, rewound every 64 MiB
+   string fn = m_datadir + "/bench.raw";
+   if (b.is_selected("write_all") ) {
+      int fd = open_fd(fn.c_str() );
+      unsigned long nw = 0;
+      b.run("write_all", [&]() {
+	       if (++nw % (64 * MiB / FRAMESIZE) == 0)	lseek(fd, 0, SEEK_SET);
+	       bench_keep(write_all(fd, (unsigned char*)words, FRAMESIZE) );
+	    }, 1);
+      close_fd(fd, fn.c_str() );
+      unlink(fn.c_str() );
+   }
+
+   // DAQ tree, compressed to a file as in a run
+   fn = m_datadir + "/bench.root";
+   if (b.is_selected("TTree::Fill") ) {
+      m_tfile = new TFile(fn.c_str(), "RECREATE");
+      open_tree();
+      m_npixs = trig_cds();
+      b.run("TTree::Fill", [&]() {
+	       m_frame++;
+	       bench_keep(m_tree->Fill() );
+	    }, 1);
+      m_tree->GetUserInfo()->Clear();	// m_runinfo not owned
+      m_tfile->Close();
+      delete m_tfile;
+      m_tfile = NULL;
+      m_tree  = NULL;
+      unlink(fn.c_str() );
+   }
+
+   free_buffers();
+}
+
+// fill the DAQ tree with frames of set_source() as in a continuous run,
+// decoded and CDS-triggered, under the ROOT write settings.
+//______________________________________________________________________
+void SupixDAQ::bench_tree(unsigned long nframes, const char *fn, tree_bench_t &r)
+{  TRACE;
+   m_pipeline_max = 16;
+   alloc_buffers();
+   set_trig_cds();		// by the source noise
+   m_frame_1st	= true;
+   m_quiet	= true;
+
+   // each point the same frames & pulses: whole passes of the bank from the start
+   unsigned long nbank = m_source->get_nbank();
+   nframes = (nframes + nbank - 1) / nbank * nbank;
+   m_source->rewind();
+
+   m_tfile = new TFile(fn, "RECREATE");
+   open_tree();
+   unsigned long long fill_ns = 0;	// timer_now_ns(), not Timer: NOTIMERS
+   for (m_frame = 0; m_frame < nframes; m_frame++) {
+      m_source->read(m_pipeline->get_in_ptr(), FRAMESIZE);
+      m_pipeline->next_in(false);
+      decode_frame();
+      m_frame_1st = false;
+      m_npixs	= trig_cds();
+      m_trig	= m_npixs ? TRIG_CDS : 0;
+      unsigned long long t0 = timer_now_ns();
+      m_tree->Fill();
+      fill_ns += timer_now_ns() - t0;
+      m_pipeline->next_out(O_NOISE);
+   }
+
+   unsigned long long t0 = timer_now_ns();
+   m_tfile->Write();
+   r.write_sec	= (timer_now_ns() - t0) * 1e-9;
+   r.fill_sec	= fill_ns * 1e-9;
+   r.entries	= m_tree->GetEntries();
+   r.tot_bytes	= m_tree->GetTotBytes();
+   r.zip_bytes	= m_tree->GetZipBytes();
+   m_tree->GetUserInfo()->Clear();	// m_runinfo not owned
+   m_tfile->Close();
+   delete m_tfile;
+   m_tfile = NULL;
+   m_tree  = NULL;
+
+   struct stat st;
+   r.file_bytes = stat(fn, &st) == 0 ? st.st_size : 0;
+   free_buffers();
+}
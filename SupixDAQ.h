@@ -15,12 +15,22 @@
 #include "pipeline.h"	// pipeline_t
 #include "util.h"
 #include "Timer.h"	// RecurStats, Timer
+#include "throttle.h"	// trig_control_t
+#include "shmstats.h"	// shm_stats_t
+#include "alog.h"	// ALOG
+#include "pipesim.h"	// pipesim_t
+#include "benchmark.h"	// bench_t
+#include "framegen.h"	// framegen_t
+#include "cpuaff.h"	// cpu_set_t
 #include "RunInfo.h"
 
 #include "TTree.h"
 
 #include <sys/types.h>	// ushort
 
+#include <atomic>
+#include <pthread.h>	// pthread_t
+
 // #include <string>
 // #include <fstream>
 // forward declaration
@@ -28,6 +38,19 @@ class TFile;
 
 enum run_status_t { RUN_FIRST, RUN_START, RUN_STOP };
 
+// result of SupixDAQ::bench_tree()
+typedef struct tree_bench_t
+{
+   unsigned long entries;
+   double	fill_sec;	// in TTree::Fill()
+   double	write_sec;	// final TFile::Write()
+   double	tot_bytes;	// uncompressed
+   double	zip_bytes;
+   double	file_bytes;
+}
+   tree_bench_t
+   ;
+
 //
 // class declaration
 //======================================================================
@@ -61,18 +84,54 @@ public:
    void set_write_raw(bool x)		{ m_write_raw = x; }
    void set_write_root(bool x)		{ m_write_root = x; }
    void set_filesize_max(long x)	{ m_filesize_max = x; }
+   // ROOT write settings: algorithm*100 + level, basket bytes, AutoFlush; -1/0 = ROOT default
+   void set_root_settings(int compress, int basket=0, long autoflush=0)
+   { m_root_compress = compress; m_root_basket = basket; m_root_autoflush = autoflush; }
    void set_timewait(int x)		{ m_timewait = x; }
    void set_timeout(int x)		{ m_timeout = x * 1e6 / m_timewait; }	// sec -> usec
    void set_verbosity(int x)		{ m_verbosity = x; }
+   // threshold controller, enabled by a target of occupancy or bandwidth
+   void set_ctrl_occupancy(double x)	{ m_ctrl_occ = x; }		// fraction of pipeline
+   void set_ctrl_bandwidth(double x)	{ m_ctrl_bw = x * MiB; }	// MiB/s -> bytes/s
+   void set_ctrl_bounds(double xmin, double xmax)
+   { m_ctrl_xmin = xmin; m_ctrl_xmax = xmax; }
+   // load-shedding between occupancy watermarks, low > 0 to enable
+   void set_shed(double low, double high)	{ m_shed_low = low; m_shed_high = high; }
+   void set_shm_name(const char *x)	{ m_shm_name = x; }	// live statistics, "" = disabled
+   void set_timer_sample(int n)		{ m_timer_sample = n; }	// time 1 in n frames
+   void set_perf(bool yes)		{ m_perf = yes; }	// hardware counters per stage
+   void set_log_file(const char *x)	{ m_log_fn = x; }	// ALOG output, "" = stdout
+   // tune pipeline_max, timewait & timeout for triggers per frame, 0 = periodic only
+   void set_autotune(double ratio)	{ m_tune = true; m_tune_ratio = ratio; }
+   // spans of 1 in <every> frames and all >= thresh usec
+   void set_trace(unsigned long every, double thresh)	{ m_trace_every = every; m_trace_thresh = thresh; }
+   // cores of a thread (shm_threads_t) as "2,4-5", the rest of the process kept off; return cpus, -1 on error
+   int set_cpus(int ith, const char *list)	{ return cpus_parse(list, &m_cpus[ith]); }
+   // SCHED_FIFO priority of a thread (shm_threads_t), 0 = SCHED_OTHER
+   void set_rt_prio(int ith, int prio)		{ m_rt_prio[ith] = prio; }
+   // pipeline & stacks on huge pages, locked, prefaulted; mem_flags_t, 0 = malloc
+   void set_mem_flags(int x)		{ m_mem_flags = x; }
    // void set_noise_run()			{ m_noise_run = true; }
 
    void set_mode_debug();	// fake fifo & mem
+   // synthetic frames at fps instead of the FIFO, CDS pulses in trig_ratio of frames
+   void set_source(double fps, double trig_ratio=0);
+   int load_source(const char *fn)	{ return m_source ? m_source->load(fn) : 0; }	// replay a raw file
    void set_filename(const char *dir, const char *tag);
 
    //
    // control & actions
    //-------------------------------------------------------------------
 
+   void recommend_last();	// pipeline_max from the last run's timing
+   void bench(bench_t &b);	// micro-benchmarks of kernels, no devices
+   // end-to-end benchmark with set_source(): a TSV line set by finalize()
+   static std::string bench_header();
+   const std::string & get_bench_line()	{ return m_bench_line; }
+   // fill nframes of set_source() into a file of the DAQ tree, rounded up to
+   // whole passes of its bank from the first frame: alike for each call
+   void bench_tree(unsigned long nframes, const char *fn, tree_bench_t &r);
+
    // exit for any error.
    void initialize();
    void finalize();
@@ -127,6 +186,10 @@ public:
    void do_trig();
    trig_t triged();
    int trig_cds();		// CDS trigger
+   void calc_threshold();	// m_threshold from noise and trig_cds_x
+   void control_trig();		// threshold controller
+   void shed_load();		// load-shedding level
+   void save_shed();		// load-shedding accounting -> RunInfo
 
    //
    // I/O
@@ -156,6 +219,7 @@ public:
    // int open_root();
    int close_root();
    int open_tree();
+   int fill_tree();		// zero-suppressed if shedding
 
    //
    // utilities
@@ -196,8 +260,21 @@ public:
    }
    
    void recommend();		// recommend daq configuration
+   void simulate(LatencyHist *hists[], double trig_ratio);	// pipesim_t, hists per timer
+   void save_timing();		// for recommend_last()
+   std::string timing_fn();	// beside the log, "" if none
+   void calibrate();		// auto-tune at run start, before the pipeline allocated
+   void retune();		// WR: auto-tune on drift of measured costs
+   void alloc_buffers();	// pipeline, stacks & buffers
+   std::string bench_report();	// before x_timers[] deleted
+   void free_buffers();
    
    
+   void publish(int ith);	// live statistics of a thread, shm_threads_t
+   void dump_trace();		// spans to Chrome trace JSON
+   static void * trace_dumper(void *daq);	// thread: dump_trace() on signal
+   void apply_sched(int ith);	// affinity & policy of the calling thread, shm_threads_t
+   
    std::string sprint(const char* msg="");		// run status
    void print(const char *msg="");		// + configuration
    
@@ -205,6 +282,7 @@ public:
 
 private:
    int		m_verbosity;	// verbosity for cout
+   bool		m_quiet;	// no ALOG of triggers, benchmarks
    int		m_pid;		// process id
    RunInfo	m_runinfo;	// attached to GetUserInfo()
    double*	m_threshold;	// fast access to runinfo.trig_cds[][]
@@ -229,6 +307,7 @@ private:
    long	m_filesize_max;		// max bytes/file
    long	m_filesize_raw;		// cumulative bytes in raw file
    long	m_filesize_root;	// cumulative bytes in root file
+   long	m_filesize_sum;		// bytes in closed files
    
    std::string		m_datadir;	// data dir
    std::string		m_datatag;	// data file name tag
@@ -263,7 +342,7 @@ private:
 
    // DAQ configuration
    bool		m_mode_debug;	// debug mode
-   int		m_timewait;		// usec
+   std::atomic<int> m_timewait;		// usec, retuned by WR, read by RD
    int		m_timeout;		// usec
    unsigned long m_maxframe;		// 0 = infinity
    
@@ -272,6 +351,80 @@ private:
    pipeline_t *	m_pipeline;
    int		m_pipeline_max;		// total frames
    OUT_MODE_t	m_wr_mode;			// pipeline write-out mode
+
+   // threshold controller
+   trig_control_t * m_trig_ctrl;
+   double	m_ctrl_occ;		// target occupancy, 0 = disabled
+   double	m_ctrl_bw;		// target bytes/s, 0 = disabled
+   double	m_ctrl_xmin;		// bounds of trig_cds_x
+   double	m_ctrl_xmax;
+   int		m_ctrl_every;		// frames per sample
+
+   // load-shedding
+   shed_t *	m_shed;
+   double	m_shed_low;		// watermarks of occupancy
+   double	m_shed_high;
+   int		m_shed_level;		// shed_levels_t
+   adc_t *	m_zs_adc;		// saved frame during zero-suppression
+   cds_t *	m_zs_cds;
+   UShort_t	m_zs_pixid[NPIXS];	// pixels kept over the window of a trigger
+   int		m_zs_npixs;
+
+   // live statistics in shared memory
+   shm_stats_t *	m_shm;
+   std::string		m_shm_name;
+   int			m_shm_every;	// frames per update
+   int			m_timer_sample;	// x_timers[] sampling, 1 in n
+   unsigned long	m_timer_frame[2];	// per thread, set once per loop: x_timers[] sampled alike
+
+   // hardware counters over x_timers[]
+   bool			m_perf;
+   perf_group_t		m_perf_group[2];	// per thread, shm_threads_t
+   perf_stage_t *	m_perf_stage;		// per timer
+
+   std::string		m_log_fn;		// ALOG output
+
+   // synthetic input
+   framegen_t *		m_source;		// NULL = FIFO
+   unsigned long long	m_isfull_ns;		// RD: waiting pipeline non-full
+   std::string		m_bench_line;
+
+   // affinity & scheduling per thread, shm_threads_t
+   cpu_set_t		m_cpus[2];		// empty = not pinned
+   int			m_rt_prio[2];		// SCHED_FIFO, 0 = SCHED_OTHER
+   int			m_mem_flags;		// pipeline & stacks, mem_flags_t
+
+   // ROOT write settings
+   int			m_root_compress;	// -1 = default
+   int			m_root_basket;		// 0 = default
+   long			m_root_autoflush;	// 0 = default
+
+   // automatic tuning
+   bool			m_tune;
+   double		m_tune_ratio;		// expected triggers per frame
+   int			m_tune_frames;		// calibration frames
+   int			m_tune_capacity;	// pipeline frames allocated
+   unsigned long	m_tune_every;		// frames per drift check
+   double		m_tune_drift;		// relative drift to retune
+   pipesim_t *		m_tune_sim;
+   pipesim_config_t	m_tune_cfg;
+   double		m_tune_cost;		// usec per frame processed, expected
+   double		m_tune_pace;		// usec per frame read, expected
+   double		m_tune_t;		// snapshot at last check
+   unsigned long	m_tune_nreads;
+   unsigned long	m_tune_ntrigs;
+   unsigned long	m_tune_n;
+   double		m_tune_sum;
+   unsigned long	m_tune_nprocd;		// frames processed, timed anyway
+   double		m_tune_busy;		// usec of them
+
+   // tracing of x_timers[] spans
+   unsigned long	m_trace_every;
+   double		m_trace_thresh;		// usec
+   trace_ring_t *	m_trace[2];		// per thread, shm_threads_t
+   int			m_trace_ndump;
+   pthread_t		m_trace_thr;		// dumper, off the DAQ threads
+   std::atomic<bool>	m_trace_run;
    
    //int		m_pipeline_sec;		// estimated max for 1 sec
 
@@ -321,6 +474,13 @@ inline void SupixDAQ::set_mode_debug()
    m_dev_fifo	= (char*)"./data/myfifo";
 }
 
+inline void SupixDAQ::set_source(double fps, double trig_ratio)
+{
+   if (m_source)	delete m_source;
+   m_source	= new framegen_t(fps);
+   m_source->set_pulse(trig_ratio);
+}
+
 // dir and filename tag for write-out
 inline void SupixDAQ::set_filename(const char *dir, const char *tag)
 {
@@ -0,0 +1,417 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * event index of a chain: per-frame summaries mapped to entry numbers.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "SupixIndex.h"
+#include "SupixAnly.h"		// g_cds_sum_x
+#include "RunInfo.h"
+#include "Timer.h"
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TChain.h>
+#include <TBranch.h>
+
+#include <pthread.h>
+#include <stdlib.h>	// abs()
+#include <string.h>	// strerror()
+#include <errno.h>
+#include <unistd.h>	// access()
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+#define IDX_TITLE	"supix index v1"
+
+// index of a data file, by local entries
+typedef struct idx_file_t
+{
+   string			name;
+   vector<idx_entry_t>		sum;
+   vector<ULong64_t>		frames;		// of all entries
+   bool				ok;
+}
+   idx_file_t
+   ;
+
+typedef struct idx_job_t
+{
+   vector<idx_file_t> *	files;
+   string		tree;
+   size_t		next;		// file to do
+   pthread_mutex_t	mutex;
+}
+   idx_job_t
+   ;
+
+//______________________________________________________________________
+SupixIndex::SupixIndex(TTree *chain)
+   : m_chain(chain)
+{
+}
+
+string SupixIndex::idx_name(const string &file)
+{
+   size_t n = file.rfind(".root");
+   string base	= n == string::npos ? file : file.substr(0, n);
+   size_t slash	= base.rfind('/');
+   string dir	= slash == string::npos ? string("idx") : base.substr(0, slash) + "/idx";
+   return dir + "/" + base.substr(slash + 1) + "-idx.root";
+}
+
+// index no older than the file
+static bool idx_fresh(const string &file, const string &idx)
+{
+   struct stat sf, si;
+   if (stat(file.c_str(), &sf) < 0 || stat(idx.c_str(), &si) < 0)
+      return false;
+   return si.st_mtime >= sf.st_mtime;
+}
+
+// summaries of a data file, as event_display() and special_display()
+// compute them, against the RunInfo of the file
+//______________________________________________________________________
+static bool idx_build(idx_file_t &f, const string &tree)
+{
+   TFile *file = TFile::Open(f.name.c_str(), "READ");
+   if (! file || file->IsZombie() ) {
+      LOG << f.name << ": can't open" << endl;
+      delete file;
+      return false;
+   }
+   TTree *t = 0;
+   file->GetObject(tree.c_str(), t);
+   RunInfo *ri = t ? (RunInfo*)t->GetUserInfo()->At(0) : 0;
+   if (! ri) {
+      LOG << f.name << ": no tree " << tree << " or RunInfo" << endl;
+      delete file;
+      return false;
+   }
+
+   cds_t	pixel_cds[NROWS][NCOLS];
+   UShort_t	pixid[NPIXS];
+   ULong64_t	frame;
+   UShort_t	npixs;
+   trig_t	trig;
+   TBranch *b_pixel_cds, *b_pixid, *b_frame, *b_npixs, *b_trig;
+   t->SetBranchStatus("*", 0);
+   t->SetBranchStatus("pixel_cds", 1);
+   t->SetBranchStatus("pixid", 1);
+   t->SetBranchStatus("frame", 1);
+   t->SetBranchStatus("npixs", 1);
+   t->SetBranchStatus("trig", 1);
+   t->SetBranchAddress("pixel_cds", pixel_cds, &b_pixel_cds);
+   t->SetBranchAddress("pixid", pixid, &b_pixid);
+   t->SetBranchAddress("frame", &frame, &b_frame);
+   t->SetBranchAddress("npixs", &npixs, &b_npixs);
+   t->SetBranchAddress("trig", &trig, &b_trig);
+
+   Long64_t nentries = t->GetEntries();
+   f.frames.resize(nentries);
+   for (Long64_t i=0; i < nentries; i++) {
+      b_frame->GetEntry(i);
+      b_npixs->GetEntry(i);
+      b_trig->GetEntry(i);
+      f.frames[i] = frame;
+      if (npixs == 0 && trig != 2)	continue;
+      b_pixel_cds->GetEntry(i);
+      if (npixs > NPIXS)	npixs = NPIXS;
+      if (npixs)	b_pixid->GetEntry(i);
+
+      idx_entry_t e;
+      e.entry	= i;
+      e.frame	= frame;
+      e.npixs	= npixs;
+      e.trig	= trig;
+
+      // all pixels
+      int ncuts = 0;
+      double cutmin = 999, chi2_cds = 0;
+      for (int r=0; r < NROWS; r++) {
+	 for (int c=0; c < NCOLS; c++) {
+	    double cds_cor = (pixel_cds[r][c] - ri->cds_mean[r][c]) / ri->cds_sigma[r][c];
+	    chi2_cds += cds_cor*cds_cor;
+	    if (cds_cor < -g_cds_sum_x) {
+	       ncuts++;
+	       if (cutmin > -cds_cor)	cutmin = -cds_cor;
+	    }
+	 }
+      }
+
+      // fired pixels: seeds start at (0,0) as in the displays
+      double cds_sum = 0;
+      int seed_row = 0, seed_col = 0;		// raw CDS
+      int nseed_row = 0, nseed_col = 0;		// normalized
+      double nseed = 0;
+      for (int k=0; k < npixs; k++) {
+	 int r = pixid[k] >> NBITS_COL;
+	 int c = pixid[k] &  MASK_COL;
+	 if (pixel_cds[r][c] < pixel_cds[seed_row][seed_col]) {
+	    seed_row = r;
+	    seed_col = c;
+	 }
+	 cds_sum += -pixel_cds[r][c];
+	 double cds_cor = (pixel_cds[r][c] - ri->cds_mean[r][c]) / ri->cds_sigma[r][c];
+	 if (cds_cor < nseed) {
+	    nseed = cds_cor;
+	    nseed_row = r;
+	    nseed_col = c;
+	 }
+      }
+      bool spread = npixs > 9;
+      for (int k=0; k < npixs && ! spread; k++) {
+	 int r = pixid[k] >> NBITS_COL;
+	 int c = pixid[k] &  MASK_COL;
+	 spread = abs(r - nseed_row) > 1 || abs(c - nseed_col) > 1;
+      }
+
+      e.cds_sum	= cds_sum;
+      e.chi2_cds	= chi2_cds;
+      e.cutmin	= cutmin;
+      e.ncuts	= ncuts;
+      e.seed_row	= seed_row;
+      e.seed_col	= seed_col;
+      e.spread	= spread;
+      f.sum.push_back(e);
+   }
+   delete file;
+   return true;
+}
+
+static bool idx_load(idx_file_t &f, const string &name)
+{
+   TFile *file = TFile::Open(name.c_str(), "READ");
+   if (! file || file->IsZombie() ) {
+      delete file;
+      return false;
+   }
+   TTree *ts = 0, *tf = 0;
+   file->GetObject("supix_idx", ts);
+   file->GetObject("supix_frames", tf);
+   if (! ts || ! tf || strcmp(ts->GetTitle(), IDX_TITLE) ) {
+      delete file;
+      return false;
+   }
+   idx_entry_t e;
+   ts->SetBranchAddress("entry",	&e.entry);
+   ts->SetBranchAddress("frame",	&e.frame);
+   ts->SetBranchAddress("cds_sum",	&e.cds_sum);
+   ts->SetBranchAddress("chi2_cds",	&e.chi2_cds);
+   ts->SetBranchAddress("cutmin",	&e.cutmin);
+   ts->SetBranchAddress("npixs",	&e.npixs);
+   ts->SetBranchAddress("ncuts",	&e.ncuts);
+   ts->SetBranchAddress("trig",	&e.trig);
+   ts->SetBranchAddress("seed_row",	&e.seed_row);
+   ts->SetBranchAddress("seed_col",	&e.seed_col);
+   ts->SetBranchAddress("spread",	&e.spread);
+   f.sum.resize(ts->GetEntries() );
+   for (Long64_t i=0; i < ts->GetEntries(); i++) {
+      ts->GetEntry(i);
+      f.sum[i] = e;
+   }
+   ULong64_t frame;
+   tf->SetBranchAddress("frame", &frame);
+   f.frames.resize(tf->GetEntries() );
+   for (Long64_t i=0; i < tf->GetEntries(); i++) {
+      tf->GetEntry(i);
+      f.frames[i] = frame;
+   }
+   delete file;
+   return true;
+}
+
+static bool idx_save(const idx_file_t &f, const string &name)
+{
+   string dir = name.substr(0, name.rfind('/') );	// idx/, made once
+   if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST)
+      return false;
+   if (access(dir.c_str(), W_OK) < 0)
+      return false;
+   TDirectory *cwd = gDirectory;
+   TFile *file = TFile::Open(name.c_str(), "RECREATE");
+   if (! file || file->IsZombie() ) {
+      delete file;
+      cwd->cd();
+      return false;
+   }
+   idx_entry_t e;
+   TTree *ts = new TTree("supix_idx", IDX_TITLE);
+   ts->Branch("entry",	&e.entry,	"entry/L");
+   ts->Branch("frame",	&e.frame,	"frame/l");
+   ts->Branch("cds_sum",	&e.cds_sum,	"cds_sum/F");
+   ts->Branch("chi2_cds",	&e.chi2_cds,	"chi2_cds/F");
+   ts->Branch("cutmin",	&e.cutmin,	"cutmin/F");
+   ts->Branch("npixs",	&e.npixs,	"npixs/s");
+   ts->Branch("ncuts",	&e.ncuts,	"ncuts/S");
+   ts->Branch("trig",	&e.trig,	"trig/b");
+   ts->Branch("seed_row",	&e.seed_row,	"seed_row/b");
+   ts->Branch("seed_col",	&e.seed_col,	"seed_col/b");
+   ts->Branch("spread",	&e.spread,	"spread/b");
+   for (size_t i=0; i < f.sum.size(); i++) {
+      e = f.sum[i];
+      ts->Fill();
+   }
+   ULong64_t frame;
+   TTree *tf = new TTree("supix_frames", IDX_TITLE);
+   tf->Branch("frame", &frame, "frame/l");
+   for (size_t i=0; i < f.frames.size(); i++) {
+      frame = f.frames[i];
+      tf->Fill();
+   }
+   file->Write();
+   delete file;		// trees too
+   cwd->cd();
+   return true;
+}
+
+static void * idx_worker(void *arg)
+{
+   idx_job_t *job = (idx_job_t*)arg;
+   while (1) {
+      pthread_mutex_lock(&job->mutex);
+      size_t i = job->next++;
+      pthread_mutex_unlock(&job->mutex);
+      if (i >= job->files->size() )	break;
+
+      idx_file_t &f = (*job->files)[i];
+      string idx = SupixIndex::idx_name(f.name);
+      if (idx_fresh(f.name, idx) && idx_load(f, idx) ) {
+	 f.ok = true;
+	 continue;
+      }
+      f.sum.clear();
+      f.frames.clear();
+      f.ok = idx_build(f, job->tree);
+      if (f.ok && ! idx_save(f, idx) )
+	 LOG << idx << ": not writable, index in memory only" << endl;
+   }
+   return NULL;
+}
+
+//______________________________________________________________________
+bool SupixIndex::Build(int nthreads)
+{
+   TRACE;
+   Timer timer(__func__);
+   timer.start();
+
+   vector<idx_file_t> files;
+   if (m_chain->InheritsFrom(TChain::Class() ) ) {
+      TObjArray *l = ( (TChain*)m_chain)->GetListOfFiles();
+      for (int i=0; l && i < l->GetEntriesFast(); i++) {
+	 files.push_back(idx_file_t() );
+	 files.back().name = l->At(i)->GetTitle();
+      }
+   }
+   else if (m_chain->GetCurrentFile() ) {
+      files.push_back(idx_file_t() );
+      files.back().name = m_chain->GetCurrentFile()->GetName();
+   }
+   for (size_t i=0; i < files.size(); i++)
+      files[i].ok = false;
+
+   idx_job_t job;
+   job.files	= &files;
+   job.tree	= m_chain->GetName();
+   job.next	= 0;
+   pthread_mutex_init(&job.mutex, NULL);
+   TDirectory *cwd = gDirectory;
+   int n = nthreads < 1 ? 1 : nthreads > (int)files.size() ? (int)files.size() : nthreads;
+   if (n > 1) {
+      ROOT::EnableThreadSafety();
+      vector<pthread_t> tid(n);
+      for (int k=0; k < n; k++) {
+	 int err = pthread_create(&tid[k], NULL, idx_worker, &job);
+	 if (err) {
+	    LOG << "pthread_create: " << strerror(err) << endl;
+	    exit(-1);
+	 }
+      }
+      for (int k=0; k < n; k++)
+	 pthread_join(tid[k], NULL);
+   }
+   else
+      idx_worker(&job);
+   pthread_mutex_destroy(&job.mutex);
+   cwd->cd();
+
+   // chain entries: files in order
+   m_idx.clear();
+   m_frames.clear();
+   m_offsets.clear();
+   Long64_t offset = 0;
+   bool ok = true;
+   for (size_t i=0; i < files.size(); i++) {
+      idx_file_t &f = files[i];
+      ok = ok && f.ok;
+      for (size_t k=0; k < f.sum.size(); k++) {
+	 m_idx.push_back(f.sum[k]);
+	 m_idx.back().entry += offset;
+      }
+      for (size_t k=0; k < f.frames.size(); k++)
+	 m_frames.push_back(make_pair(f.frames[k], offset + (Long64_t)k) );
+      m_offsets.push_back(offset);
+      offset += f.frames.size();
+   }
+   m_offsets.push_back(offset);
+   sort(m_frames.begin(), m_frames.end() );
+
+   cout << __PRETTY_FUNCTION__ << " END:"
+	<< " files=" << files.size()
+	<< " threads=" << n
+	<< " entries=" << m_frames.size()
+	<< " indexed=" << m_idx.size()
+	<< endl;
+   timer.stop();
+   timer.print(1);
+   return ok;
+}
+
+//______________________________________________________________________
+vector<Long64_t> SupixIndex::select(const idx_cut_t &cut) const
+{
+   vector<Long64_t> v;
+   for (size_t i=0; i < m_idx.size(); i++) {
+      const idx_entry_t &e = m_idx[i];
+      if (cut.trig >= 0 && e.trig != cut.trig)			continue;
+      if (cut.npixs_min >= 0 && e.npixs < cut.npixs_min)	continue;
+      if (cut.npixs_max >= 0 && e.npixs > cut.npixs_max)	continue;
+      if (cut.row_min >= 0 && e.seed_row < cut.row_min)		continue;
+      if (cut.row_max >= 0 && e.seed_row > cut.row_max)		continue;
+      if (cut.col_min >= 0 && e.seed_col < cut.col_min)		continue;
+      if (cut.col_max >= 0 && e.seed_col > cut.col_max)		continue;
+      if (cut.cds_sum_min >= 0 && e.cds_sum < cut.cds_sum_min)	continue;
+      if (cut.spread >= 0 && e.spread != cut.spread)		continue;
+      v.push_back(e.entry);
+   }
+   return v;
+}
+
+Long64_t SupixIndex::find_frame(ULong64_t frame, int tree) const
+{
+   vector<pair<ULong64_t, Long64_t> >::const_iterator it
+      = lower_bound(m_frames.begin(), m_frames.end(), make_pair(frame, (Long64_t)-1) );
+   vector<pair<ULong64_t, Long64_t> >::const_iterator end
+      = upper_bound(it, m_frames.end(), make_pair(frame, m_offsets.back() ) );
+   if (it == end)	return -1;
+   if (tree < 0) {		// entries of a file in a row: the first & last
+      int t0 = upper_bound(m_offsets.begin(), m_offsets.end(), it->second) - m_offsets.begin();
+      int t1 = upper_bound(m_offsets.begin(), m_offsets.end(), (end-1)->second) - m_offsets.begin();
+      if (t0 == t1)	return it->second;
+      LOG << "frame " << frame << " in files " << t0 - 1 << " and " << t1 - 1
+	  << " of the chain (runs), give the tree number" << endl;
+      return -1;
+   }
+   if (tree + 1 >= (int)m_offsets.size() )	return -1;
+   for (; it != end; ++it)
+      if (it->second >= m_offsets[tree] && it->second < m_offsets[tree + 1])
+	 return it->second;
+   return -1;
+}
@@ -0,0 +1,100 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * event index of a chain: per-frame summaries mapped to entry numbers.
+ *
+ * - one index per data file, "idx/<file>-idx.root" beside it (tree
+ *   supix_idx), out of the way of pattern*.root; built on first use,
+ *   rebuilt when older than the file; kept in memory only if the
+ *   directory is not writable.
+ * - frame ids restart with each run: find_frame() of a chain of runs
+ *   takes the file (tree number) of the frame, or finds it in one only.
+ * - files indexed on parallel threads, each with its own RunInfo.
+ * - summaries of frames with fired pixels or physics triged (trig == 2),
+ *   as event_display() and special_display() select them.
+ *
+ * usage:
+ *   SupixIndex idx(chain);
+ *   idx.Build(4);				// threads
+ *   idx_cut_t cut;
+ *   cut.trig = 2;   cut.npixs_min = 12;   cut.cds_sum_min = 300;
+ *   std::vector<Long64_t> v = idx.select(cut);	// entries of the chain
+ *   Long64_t jentry = idx.find_frame(123456);		// or (123456, tree)
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef SupixIndex_h
+#define SupixIndex_h
+
+#include "mydefs.h"
+#include <Rtypes.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+class TTree;
+
+// summary of a frame
+typedef struct idx_entry_t
+{
+   Long64_t	entry;		// in the chain
+   ULong64_t	frame;
+   Float_t	cds_sum;	// -sum of raw CDS of fired pixels
+   Float_t	chi2_cds;	// sum of normalized CDS^2 of all pixels
+   Float_t	cutmin;		// min -normalized CDS below -g_cds_sum_x, 999 if none
+   UShort_t	npixs;
+   Short_t	ncuts;		// pixels below -g_cds_sum_x sigma
+   UChar_t	trig;
+   UChar_t	seed_row;	// fired pixel of the most negative raw CDS
+   UChar_t	seed_col;
+   UChar_t	spread;		// > 9 pixels or a pixel off 3x3 of the normalized seed
+}
+   idx_entry_t
+   ;
+
+// selection of select(); negative = any
+typedef struct idx_cut_t
+{
+   int		trig;
+   int		npixs_min, npixs_max;
+   int		row_min, row_max;	// seed
+   int		col_min, col_max;
+   double	cds_sum_min;
+   int		spread;
+
+   idx_cut_t() : trig(-1), npixs_min(-1), npixs_max(-1), row_min(-1), row_max(-1)
+		 , col_min(-1), col_max(-1), cds_sum_min(-1), spread(-1) {}
+}
+   idx_cut_t
+   ;
+
+class SupixIndex
+{
+public:
+   SupixIndex(TTree *chain);
+   ~SupixIndex() {}
+
+   // load or build the index of each file on nthreads
+   bool Build(int nthreads=1);
+
+   Long64_t size() const		{ return m_idx.size(); }
+   const idx_entry_t & at(Long64_t i) const	{ return m_idx[i]; }
+   const std::vector<idx_entry_t> & entries() const	{ return m_idx; }
+
+   // entries of the chain passing cut, in order
+   std::vector<Long64_t> select(const idx_cut_t &cut) const;
+   // entry of a frame number in file tree of the chain, -1 if none;
+   // tree < 0: any file, -1 also if in more than one (runs)
+   Long64_t find_frame(ULong64_t frame, int tree=-1) const;
+
+   // index file of a data file
+   static std::string idx_name(const std::string &file);
+
+private:
+   TTree *	m_chain;
+   std::vector<idx_entry_t> m_idx;	// frames summarized, in entry order
+   std::vector<std::pair<ULong64_t, Long64_t> > m_frames;	// all frames, sorted
+   std::vector<Long64_t> m_offsets;	// first entry of each file, and the total
+};
+
+#endif //~ SupixIndex_h
@@ -49,14 +49,45 @@ void RecurStats::add(double xm, int mm)
 
 //======================================================================
 
-//
-// constructor(s)
-//______________________________________________________________________
-// Timer::Timer()
-// {
+void LatencyHist::reset()
+{
+   m_n = 0;
+   m_max = 0;
+   for (int i=0; i < NBUCKETS; i++)	m_counts[i] = 0;
+}
+
+unsigned long long LatencyHist::lower(int i)
+{
+   if (i < 2*SUB)	return i;
+   int octave = (i - 2*SUB) / SUB;	// msb - SUBBITS - 1
+   int sub    = (i - 2*SUB) % SUB + SUB;
+   return (unsigned long long)sub << (octave + 1);
+}
 
-// }
+unsigned long long LatencyHist::width(int i)
+{
+   if (i < 2*SUB)	return 1;
+   return 1ULL << ((i - 2*SUB) / SUB + 1);
+}
+
+// value at bucket middle, max for the top bucket
+//______________________________________________________________________
+double LatencyHist::get_percentile(double p)
+{
+   if (m_n == 0)	return 0;
+   double target = p / 100. * m_n;
+   unsigned long sum = 0;
+   for (int i=0; i < NBUCKETS; i++) {
+      sum += m_counts[i];
+      if (sum >= target && m_counts[i]) {
+	 double x = lower(i) + 0.5 * (width(i) - 1);
+	 return x < m_max ? x : m_max;
+      }
+   }
+   return m_max;
+}
 
+//======================================================================
 
 //
 // destructor
@@ -66,45 +97,63 @@ Timer::~Timer()
 
 }
 
+void Timer::reset()
+{
+   m_tick	= 0;
+   m_on		= false;
+   m_tstart	= 0;
+   m_tstop	= 0;
+   m_perf_ns	= 0;
+   m_calls	= 0;
+   m_sum	= 0;
+   m_mean	= 0;
+   m_m2		= 0;
+   m_hist.reset();
+}
+
+double Timer::get_mean()
+{
+   unsigned long n = get_n();
+   return n ? m_sum / 1000. / n : 0;
+}
+
+double Timer::get_variance()
+{
+   unsigned long n = get_n();
+   if (n < 2)	return 0;
+   return m_m2 / (n - 1) / 1e6;
+}
+
 void Timer::print(int unit)
 {
    char str[1000];
-   unsigned long nn;
-   double mean, sigma;
-   m_stats.get_results(nn, mean, sigma);
+   unsigned long nn = get_n();
+   double mean	= get_mean();
+   double sigma	= sqrt(get_variance() );
+   double p50	= get_percentile(50);
+   double p99	= get_percentile(99);
+   double p999	= get_percentile(99.9);
+   double pmax	= get_max();
    const char* sunit = "usec";
+   double scale = 1;
    if (unit == 1) {
-      mean  /= 1e6;
-      sigma /= 1e6;
-      sunit  = "sec";
+      scale = 1e6;
+      sunit = "sec";
    }
    else if (unit == 2) {
-      mean  /= 6e7;
-      sigma /= 6e7;
-      sunit  = "min";
+      scale = 6e7;
+      sunit = "min";
    }
    else if (unit == 3) {
-      mean  /= 3.6e9;
-      sigma /= 3.6e9;
-      sunit  = "hour";
+      scale = 3.6e9;
+      sunit = "hour";
    }
-   sprintf(str, "\t%16s : %10.3f +- %10.3f %s \tx %lu\n", name, mean, sigma, sunit, nn);
-   // std::ostringstream oss;
-   // oss << tag << std::setprecision(3)
-   //     << ": " << m_mean << " +- " << sqrt(m_variance) << " usec"
-   //     << std::endl
-   //    ;
-   // fputs(oss.str().c_str(), stdout);
+   sprintf(str, "\t%16s : %10.3f +- %10.3f %s \tx %lu"
+	   "\tp50 %.3f p99 %.3f p99.9 %.3f max %.3f",
+	   name, mean/scale, sigma/scale, sunit, nn,
+	   p50/scale, p99/scale, p999/scale, pmax/scale);
    fputs(str, stdout);
-   //fputc('\n', stdout);
+   if (m_calls != nn)
+      fprintf(stdout, "\t(1 in %u of %lu)", m_every, m_calls);
+   fputc('\n', stdout);
 }
-
-// const char * Timer::sprint(const char *tag)
-// {
-//    std::ostringstream oss;
-//    oss << tag << std::setprecision(3)
-//        << ": " << m_mean << " +- " << sqrt(m_variance) << " usec"
-//        << std::endl
-//       ;
-//    return oss.str().c_str();
-// }
@@ -12,7 +12,10 @@
 
 #include <cstdlib>	// linux: NULL
 #include <cmath>
-#include <sys/time.h>
+#include <time.h>	// clock_gettime()
+
+#include "perfcnt.h"	// perf_stage_t
+#include "trace.h"	// trace_ring_t
 
 
 //
@@ -29,6 +32,7 @@ public:
    }
    
    void add(double, int mm=1);		// add samples, mm: repeated number
+   unsigned long get_n()	{ return m_n; }
    double get_mean()		{ return m_mean; }
    double get_variance()	{ return m_variance; }
    void get_results(unsigned long &nn, double &mean, double &sigma)
@@ -45,7 +49,62 @@ private:
 
 
 //
-// time difference in usec.
+// latency histogram in log-linear buckets (HDR style), values in nsec.
+//   - exact below 2*SUB, then SUB linear sub-buckets per power of 2,
+//     i.e. relative error < 1/SUB.
+//   - add() is integer arithmetic only.
+//______________________________________________________________________
+class LatencyHist
+{
+public:
+   enum { SUBBITS = 5
+	  , SUB = 1 << SUBBITS				// sub-buckets per octave
+	  , NBUCKETS = 2*SUB + (64 - SUBBITS - 1) * SUB	// full 64-bit range
+   };
+
+   LatencyHist()	{ reset(); }
+   void reset();
+
+   static int index(unsigned long long v)
+   {
+      if (v < 2*SUB)	return (int)v;
+      int msb = 63 - __builtin_clzll(v);
+      return 2*SUB + (msb - SUBBITS - 1) * SUB + (int)(v >> (msb - SUBBITS)) - SUB;
+   }
+   static unsigned long long lower(int i);	// lowest value of bucket
+   static unsigned long long width(int i);	// bucket width
+
+   void add(unsigned long long v, unsigned long mm=1)
+   {
+      m_counts[index(v)] += mm;
+      m_n += mm;
+      if (v > m_max)	m_max = v;
+   }
+
+   unsigned long get_n()		{ return m_n; }
+   unsigned long get_count(int i)	{ return m_counts[i]; }
+   unsigned long long get_max()		{ return m_max; }
+   double get_percentile(double p);	// p in [0, 100], nsec
+
+private:
+   unsigned long	m_n;
+   unsigned long long	m_max;
+   unsigned long	m_counts[NBUCKETS];
+};
+
+
+
+//
+// stage timer of nsec resolution (CLOCK_MONOTONIC_RAW).
+// - mean and variance in usec, as RecurStats.
+// - percentiles from a LatencyHist.
+// - set_sample(N): time only 1 in N start/stop pairs; with a frame counter
+//   of the thread, 1 in N frames, the same frames for nested timers.
+// - variance by Welford's update, no cancellation of large sums.
+// - compile with -DNOTIMERS to remove instrumentation, but of timers
+//   set_always(), e.g. by an end-to-end benchmark.
+// - set_perf(): also count hardware events over the timed pairs.
+// - set_trace(): record all pairs as spans, sampled or not, see trace_ring_t.
 // usage:
 //   Timer timer("name");
 //   timer.start();
@@ -54,47 +113,119 @@ private:
 //   ...
 //   timer.print();
 //______________________________________________________________________
+inline unsigned long long timer_now_ns()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+   return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 class Timer
 {
 public:
    // constructor(s)
    Timer(const char *s="Timer")
-      : name(s)
-   {}
+      : name(s), m_every(1), m_frame(NULL), m_perf(NULL), m_trace(NULL), m_always(false)
+   { reset(); }
 
    // destructor
    virtual ~Timer();
 
-   void start()
-   {  gettimeofday(&m_tstart, NULL);  }
+   void reset();
+   // 1 in n; frame: set once per frame by the thread, NULL = 1 in n pairs
+   void set_sample(unsigned int n, const unsigned long *frame=NULL)
+   { m_every = n > 0 ? n : 1; m_frame = frame; }
+   void set_perf(perf_stage_t *p)	{ m_perf = p; }
+   void set_trace(trace_ring_t *p)	{ m_trace = p; }
 
-   void stop(int mm=1)		// mm: number of repeated samples
-   {
-      gettimeofday(&m_tstop, NULL);
-      double xm = (double)get_dusec() / mm;
-      m_stats.add(xm, mm);
-   }
+#ifdef NOTIMERS
+   void start()		{ if (m_always) start_(); }
+   void stop(int mm=1)	{ if (m_always) stop_(mm); }
+#else
+   void start()		{ start_(); }
+   void stop(int mm=1)	{ stop_(mm); }	// mm: number of repeated samples
+#endif
+   void set_always(bool x)	{ m_always = x; }	// timed even under NOTIMERS
 
-   double get_mean()		{ return m_stats.get_mean(); }
-   double get_variance()	{ return m_stats.get_variance(); }
+   unsigned long get_n()	{ return m_hist.get_n(); }	// timed samples
+   unsigned long get_calls()	{ return m_calls; }		// all samples
+   double get_mean();				// usec
+   double get_variance();			// usec^2
+   double get_percentile(double p)		// usec
+   { return m_hist.get_percentile(p) / 1000.; }
+   double get_max()				// usec
+   { return m_hist.get_max() / 1000.; }
+   LatencyHist & get_hist()	{ return m_hist; }
    
-   // time difference in usec
+   // time difference in usec, last timed or traced pair
    unsigned long get_dusec()
-   { return (m_tstop.tv_sec - m_tstart.tv_sec)*1000000 + m_tstop.tv_usec - m_tstart.tv_usec; }
+   { return (m_tstop - m_tstart) / 1000; }
 
    // unit = 0 usec
    //        1 sec
    //        2 min
    //        3 hour
-   void print(int unit=0);	// print mean and standard deviation
-   //void print(const char *tag);
-   //const char * sprint(const char *tag);
+   void print(int unit=0);	// print mean, standard deviation and percentiles
 
 private:
    const char *name;
-   struct timeval m_tstart, m_tstop;
-   RecurStats m_stats;
-   
+   unsigned int		m_every;	// sampling
+   unsigned int		m_tick;
+   const unsigned long *	m_frame;	// of the thread, NULL = m_tick
+   bool			m_on;		// timing this pair
+   unsigned long long	m_tstart, m_tstop;	// nsec
+   unsigned long	m_calls;
+   unsigned long long	m_sum;		// nsec
+   double		m_mean;		// nsec
+   double		m_m2;		// sum (x - mean)^2, nsec^2
+   LatencyHist		m_hist;
+   perf_stage_t *	m_perf;		// hardware counters, NULL = off
+   unsigned long long	m_perf_ns;	// perf reads of the thread at start
+   trace_ring_t *	m_trace;	// spans, NULL = off
+   bool			m_always;
+
+   void start_()
+   {
+      if (m_frame)
+	 m_on = *m_frame % m_every == 0;
+      else if ( (m_on = ++m_tick >= m_every) )
+	 m_tick = 0;
+      if (! m_on) {		// spans over a threshold still wanted
+	 if (m_trace)	m_tstart = timer_now_ns();
+	 return;
+      }
+      if (m_perf) {			// syscall outside the timed region
+	 m_perf->begin();
+	 m_perf_ns = m_perf->get_read_ns();
+      }
+      m_tstart = timer_now_ns();
+   }
+
+   void stop_(int mm)
+   {
+      m_calls += mm;
+      if (! m_on) {			// no stats, the ring decides
+	 if (m_trace) {
+	    m_tstop = timer_now_ns();
+	    m_trace->span(name, m_tstart, m_tstop - m_tstart);
+	 }
+	 return;
+      }
+      m_tstop = timer_now_ns();
+      unsigned long long dt = m_tstop - m_tstart;
+      if (m_perf)			// reads of the stages inside
+	 dt -= m_perf->get_read_ns() - m_perf_ns;
+      unsigned long long xm = dt / mm;
+      unsigned long n = m_hist.get_n();	// Welford, mm samples alike
+      double d = (double)xm - m_mean;
+      m_mean += d * mm / (n + mm);
+      m_m2   += d * d * mm * n / (n + mm);
+      m_sum  += dt;
+      m_hist.add(xm, mm);
+      m_on = false;
+      if (m_trace)	m_trace->span(name, m_tstart, dt);
+      if (m_perf)	m_perf->end(mm);
+   }
 };
 
 #endif //~ Timer_h
@@ -0,0 +1,261 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * asynchronous printf-style logger.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "alog.h"
+#include "error.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct alog_slot_t
+{
+   uint64_t	t_ns;
+   bool		err;		// to stderr
+   char		text[ALOG_LINELEN];
+}
+   alog_slot_t
+   ;
+
+// single producer (owner thread), single consumer (flusher)
+typedef struct alog_ring_t
+{
+   std::atomic<uint64_t>	head;	// next to write
+   std::atomic<uint64_t>	tail;	// next to flush
+   std::atomic<unsigned long>	dropped;
+   alog_slot_t			slots[ALOG_NSLOTS];
+}
+   alog_ring_t
+   ;
+
+static alog_ring_t *	g_rings[ALOG_MAXTHREADS];
+static std::atomic<int>	g_nrings(0);
+static pthread_mutex_t	g_mutex = PTHREAD_MUTEX_INITIALIZER;	// registration only
+static std::atomic<bool>	g_running(false);
+static std::atomic<unsigned long>	g_dropped(0);	// no ring available
+static pthread_t	g_flusher;
+static FILE *		g_fp = NULL;
+static std::atomic<int>	g_gen(0);	// rings freed by alog_stop()
+
+static thread_local alog_ring_t *tl_ring = NULL;
+static thread_local int		tl_gen  = -1;
+
+static uint64_t alog_now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+bool alog_limit_t::pass(unsigned long &nsuppressed)
+{
+   uint64_t t	  = alog_now();
+   uint64_t tnext = m_tnext.load(std::memory_order_relaxed);
+   if (t < tnext || ! m_tnext.compare_exchange_strong(tnext, t + m_dt) ) {
+      m_nsup++;
+      return false;
+   }
+   nsuppressed = m_nsup.exchange(0);
+   return true;
+}
+
+void alog_register()
+{
+   if (tl_ring && tl_gen == g_gen.load() )	return;
+   tl_ring = NULL;
+   tl_gen  = g_gen.load();
+   pthread_mutex_lock(&g_mutex);
+   int n = g_nrings.load();
+   if (n < ALOG_MAXTHREADS) {
+      alog_ring_t *r = new alog_ring_t;
+      r->head	 = 0;
+      r->tail	 = 0;
+      r->dropped = 0;
+      g_rings[n] = r;
+      g_nrings.store(n + 1, std::memory_order_release);
+      tl_ring = r;
+   }
+   pthread_mutex_unlock(&g_mutex);
+}
+
+unsigned long alog_dropped()
+{
+   unsigned long n = g_dropped.load();
+   int nrings = g_nrings.load();
+   for (int i=0; i < nrings; i++)
+      n += g_rings[i]->dropped.load();
+   return n;
+}
+
+// a line as is, error lines also kept in the log file
+static void alog_write(FILE *fp, bool err, const char *line)
+{
+   if (err) {
+      fprintf(stderr, "%s\n", line);
+      if (fp == stdout)		return;
+   }
+   fprintf(fp, "%s\n", line);
+}
+
+// a line too long for a slot, or no flusher: formatted & written here
+static void alog_direct(bool err, const char *fmt, va_list ap)
+{
+   va_list aq;
+   va_copy(aq, ap);
+   int n = vsnprintf(NULL, 0, fmt, aq);
+   va_end(aq);
+   if (n < 0)	return;
+   char *line = new char[n + 1];
+   vsnprintf(line, n + 1, fmt, ap);
+   alog_write(g_fp ? g_fp : stdout, err, line);
+   delete[] line;
+}
+
+//______________________________________________________________________
+static void valog(bool err, const char *fmt, va_list ap)
+{
+   if (! g_running.load(std::memory_order_relaxed) ) {	// direct
+      alog_direct(err, fmt, ap);
+      return;
+   }
+
+   if (! tl_ring || tl_gen != g_gen.load(std::memory_order_relaxed) )
+      alog_register();
+   alog_ring_t *r = tl_ring;
+   if (! r) {
+      g_dropped++;
+      return;
+   }
+
+   uint64_t h = r->head.load(std::memory_order_relaxed);
+   if (h - r->tail.load(std::memory_order_acquire) >= ALOG_NSLOTS) {
+      r->dropped++;			// full, never wait
+      return;
+   }
+   alog_slot_t &s = r->slots[h % ALOG_NSLOTS];
+   va_list aq;
+   va_copy(aq, ap);
+   int n = vsnprintf(s.text, ALOG_LINELEN, fmt, aq);
+   va_end(aq);
+   if (n >= ALOG_LINELEN) {		// rare, e.g. V_DEBUG: out of order
+      alog_direct(err, fmt, ap);
+      return;
+   }
+   s.t_ns = alog_now();
+   s.err  = err;
+   r->head.store(h + 1, std::memory_order_release);
+}
+
+void alog(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   valog(false, fmt, ap);
+   va_end(ap);
+}
+
+void alog_err(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   valog(true, fmt, ap);
+   va_end(ap);
+}
+
+// write pending lines of all rings in time order, return lines written
+//______________________________________________________________________
+static int alog_flush(FILE *fp)
+{
+   int nlines = 0;
+   int nrings = g_nrings.load(std::memory_order_acquire);
+   while (1) {
+      alog_ring_t *rmin = NULL;
+      uint64_t tmin = 0;
+      for (int i=0; i < nrings; i++) {
+	 alog_ring_t *r = g_rings[i];
+	 uint64_t t = r->tail.load(std::memory_order_relaxed);
+	 if (t == r->head.load(std::memory_order_acquire) )	continue;
+	 uint64_t ts = r->slots[t % ALOG_NSLOTS].t_ns;
+	 if (! rmin || ts < tmin) {
+	    rmin = r;
+	    tmin = ts;
+	 }
+      }
+      if (! rmin)	break;
+
+      uint64_t t = rmin->tail.load(std::memory_order_relaxed);
+      const alog_slot_t &s = rmin->slots[t % ALOG_NSLOTS];
+      alog_write(fp, s.err, s.text);
+      rmin->tail.store(t + 1, std::memory_order_release);
+      nlines++;
+   }
+   if (nlines)	fflush(fp);
+   return nlines;
+}
+
+static void * alog_flusher(void *)
+{
+   while (g_running.load() ) {
+      if (alog_flush(g_fp) == 0)
+	 usleep(1000);
+   }
+   alog_flush(g_fp);		// the rest
+   return NULL;
+}
+
+//______________________________________________________________________
+int alog_start(const char *fn)
+{
+   if (g_running.load() )	return 0;
+   g_fp = stdout;
+   if (fn && *fn) {
+      g_fp = fopen(fn, "a");
+      if (! g_fp) {
+	 err_ret("alog_start: fopen(\"%s\")", fn);
+	 g_fp = stdout;
+      }
+   }
+   g_running = true;
+   int err = pthread_create(&g_flusher, NULL, alog_flusher, NULL);
+   if (err) {
+      g_running = false;
+      err_msg("alog_start: pthread_create: %s", strerror(err) );
+      return -1;
+   }
+   return 0;
+}
+
+void alog_stop()
+{
+   if (! g_running.load() )	return;
+   g_running = false;
+   pthread_join(g_flusher, NULL);
+   unsigned long n = alog_dropped();
+   if (n)	fprintf(g_fp, "alog: %lu lines dropped\n", n);
+   fflush(g_fp);
+
+   // threads re-register on the next alog_start()
+   pthread_mutex_lock(&g_mutex);
+   int nrings = g_nrings.load();
+   g_nrings = 0;
+   for (int i=0; i < nrings; i++) {
+      delete g_rings[i];
+      g_rings[i] = NULL;
+   }
+   g_gen++;
+   g_dropped = 0;
+   pthread_mutex_unlock(&g_mutex);
+
+   if (g_fp != stdout) {	// later lines written directly to stdout
+      fclose(g_fp);
+      g_fp = NULL;
+   }
+}
@@ -0,0 +1,78 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * asynchronous printf-style logger for the DAQ hot paths.
+ *
+ * - each thread formats into its own preallocated ring of lines
+ *   (single producer), a background thread writes them out in time
+ *   order to stdout or a file.
+ * - never blocks: a full ring drops the line and counts it.
+ * - ALOG_LIMIT() rate-limits a call site, reporting the number of
+ *   suppressed lines; AERR_LIMIT() the same to stderr, e.g. integrity errors.
+ * - lines longer than ALOG_LINELEN are written directly, not truncated.
+ * - before alog_start() / after alog_stop() lines are written directly.
+ *
+ * usage:
+ *   alog_start();			// or alog_start("daq.log")
+ *   alog_register();			// optional, at thread start
+ *   ALOG("frame=%lu npixs=%d", frame, npixs);
+ *   ALOG_LIMIT(1.0, "%s", msg);		// at most 1 line per sec
+ *   AERR_LIMIT(1.0, "ERROR: %s", msg);	// to stderr
+ *   alog_stop();
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef alog_h
+#define alog_h
+
+#include <stdint.h>
+
+#include <atomic>
+
+#define ALOG_LINELEN	1024	// bytes per slot, longer lines written directly
+#define ALOG_NSLOTS	1024	// lines per thread
+#define ALOG_MAXTHREADS	8
+
+int alog_start(const char *fn = 0);	// NULL: stdout
+void alog_stop();			// drain, join the flusher, free the rings
+void alog_register();			// preallocate ring of this thread
+unsigned long alog_dropped();		// lines lost on full rings
+
+void alog(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void alog_err(const char *fmt, ...) __attribute__((format(printf, 1, 2)));	// stderr
+
+//
+// rate limit of a call site
+//______________________________________________________________________
+typedef struct alog_limit_t
+{
+   alog_limit_t(double sec) : m_dt(sec * 1e9), m_tnext(0), m_nsup(0) {}
+
+   bool pass(unsigned long &nsuppressed);	// thread safe
+
+private:
+   uint64_t			m_dt;	// nsec
+   std::atomic<uint64_t>	m_tnext;
+   std::atomic<unsigned long>	m_nsup;
+}
+   alog_limit_t
+   ;
+
+#define ALOG(fmt, ...)	alog("%s --- " fmt, __PRETTY_FUNCTION__, ##__VA_ARGS__)
+#define AERR(fmt, ...)	alog_err("%s --- " fmt, __PRETTY_FUNCTION__, ##__VA_ARGS__)
+
+// arguments evaluated only for lines passed
+#define ALOG_LIMIT_TO(out, sec, fmt, ...)				\
+   do {									\
+      static alog_limit_t _alog_limit(sec);				\
+      unsigned long _alog_nsup;						\
+      if (_alog_limit.pass(_alog_nsup) ) {				\
+	 if (_alog_nsup)						\
+	    out("(%lu similar lines suppressed)", _alog_nsup);		\
+	 out(fmt, ##__VA_ARGS__);					\
+      }									\
+   } while (0)
+#define ALOG_LIMIT(sec, fmt, ...)	ALOG_LIMIT_TO(ALOG, sec, fmt, ##__VA_ARGS__)
+#define AERR_LIMIT(sec, fmt, ...)	ALOG_LIMIT_TO(AERR, sec, fmt, ##__VA_ARGS__)
+
+#endif //~ alog_h
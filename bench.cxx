@@ -0,0 +1,78 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * micro-benchmarks of DAQ kernels, results appended to a TSV file.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "SupixDAQ.h"
+#include "benchmark.h"
+
+#include <unistd.h>     // for getopt()
+#include <iostream>
+using namespace std;
+
+//______________________________________________________________________
+void usage(char **argv) {
+   cout << "Usage: " << argv[0] << " [options]" << endl
+	<< "\t\t -h		# print this" << endl
+	<< "\t\t -c STRING	# [unknown] commit id in results" << endl
+	<< "\t\t -k STRING	# run benchmarks with names containing STRING only" << endl
+	<< "\t\t -n INT		# [10] repeats per benchmark" << endl
+	<< "\t\t -o FILE	# [bench.tsv] results appended" << endl
+	<< "\t\t -r PATHNAME	# [/tmp] dir for temporary files" << endl
+	<< "\t\t -t FLOAT	# [0.1] min. sec per repeat" << endl
+      ;
+   exit(0);
+}
+
+//======================================================================
+int main(int argc, char **argv)
+{
+   string commit = "unknown";
+   string filter;
+   string outfn = "bench.tsv";
+   string dir = "/tmp";
+   int nrep = 10;
+   double tmin = 0.1;
+
+   int copt;
+   while ( (copt = getopt(argc, argv, "hc:k:n:o:r:t:")) != -1) {
+      switch (copt) {
+      case 'c':
+	 commit = optarg;
+	 break;
+      case 'k':
+	 filter = optarg;
+	 break;
+      case 'n':
+         sscanf(optarg, "%d", &nrep);
+         break;
+      case 'o':
+	 outfn = optarg;
+	 break;
+      case 'r':
+	 dir = optarg;
+	 break;
+      case 't':
+         sscanf(optarg, "%lf", &tmin);
+         break;
+      case 'h':
+      default:
+	 usage(argv);
+      }
+   }
+
+   bench_t b(nrep, tmin);
+   b.set_filter(filter.c_str() );
+
+   SupixDAQ *supix = new SupixDAQ;
+   supix->set_filename(dir.c_str(), "bench");
+   supix->bench(b);
+   delete supix;
+
+   int n = b.save(outfn.c_str(), commit.c_str() );
+   cout << n << " results of " << commit << " appended to " << outfn << endl;
+   return n < 0;
+}
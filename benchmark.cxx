@@ -0,0 +1,76 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * micro-benchmarks of DAQ kernels.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "benchmark.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <unistd.h>	// access()
+
+#include <algorithm>
+
+volatile unsigned long bench_sink = 0;
+
+//______________________________________________________________________
+void bench_t::add(const char *name, unsigned long nops, std::vector<double> &ns, double frames)
+{
+   bench_result_t r;
+   r.name	= name;
+   r.nops	= nops;
+   r.nrep	= ns.size();
+   r.frames	= frames;
+
+   std::sort(ns.begin(), ns.end() );
+   r.ns_min	= ns[0];
+   r.ns_med	= ns[ns.size()/2];
+   std::vector<double> dev(ns.size() );
+   for (size_t k=0; k < ns.size(); k++)
+      dev[k] = ns[k] > r.ns_med ? ns[k] - r.ns_med : r.ns_med - ns[k];
+   std::sort(dev.begin(), dev.end() );
+   r.ns_mad	= dev[dev.size()/2];
+   results.push_back(r);
+   print();
+}
+
+// the last result
+//______________________________________________________________________
+void bench_t::print()
+{
+   if (results.empty() )	return;
+   const bench_result_t &r = results.back();
+   printf("%-24s %12.2f ns/op (min %.2f, mad %.2f) x %lu x %d"
+	  , r.name.c_str(), r.ns_med, r.ns_min, r.ns_mad, r.nops, r.nrep);
+   if (r.frames > 0)	printf(" %12.0f frames/s", r.get_fps() );
+   printf("\n");
+   fflush(stdout);
+}
+
+//______________________________________________________________________
+int bench_t::save(const char *fn, const char *commit)
+{
+   bool header = access(fn, F_OK) != 0;
+   FILE *fp = fopen(fn, "a");
+   if (! fp) {
+      err_ret("fopen(\"%s\")", fn);
+      return -1;
+   }
+   if (header)
+      fprintf(fp, "commit\ttime\tname\tns_med\tns_min\tns_mad\tnops\tnrep\tframes_per_sec\n");
+
+   time_t now = time(NULL);
+   char ts[32];
+   strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", localtime(&now) );
+   for (size_t i=0; i < results.size(); i++) {
+      const bench_result_t &r = results[i];
+      fprintf(fp, "%s\t%s\t%s\t%.3f\t%.3f\t%.3f\t%lu\t%d\t%.0f\n"
+	      , commit, ts, r.name.c_str(), r.ns_med, r.ns_min, r.ns_mad
+	      , r.nops, r.nrep, r.get_fps() );
+   }
+   fclose(fp);
+   return results.size();
+}
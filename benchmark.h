@@ -0,0 +1,107 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * micro-benchmarks of DAQ kernels.
+ *
+ * - each benchmark is a callable doing one operation.
+ * - the number of operations per repeat is scaled until a repeat
+ *   takes >= tmin sec, then nrep repeats are timed.
+ * - ns/op reported as median, min and spread of the repeats;
+ *   frames/s from the frames handled per operation.
+ * - results appended to a TSV file, one line per benchmark, with the
+ *   commit id, for comparison across commits.
+ *
+ * usage:
+ *   bench_t b(10, 0.1);
+ *   b.run("pipeline cycle", [&]() { ... }, 1);	// 1 frame per op
+ *   b.print();
+ *   b.save("bench.tsv", "a1b2c3d");
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef benchmark_h
+#define benchmark_h
+
+#include <string>
+#include <vector>
+
+#include "Timer.h"	// timer_now_ns()
+
+// keep a result alive against the optimizer
+extern volatile unsigned long bench_sink;
+template<class T> inline void bench_keep(const T &x)
+{  bench_sink += (unsigned long)x;  }
+
+//______________________________________________________________________
+typedef struct bench_result_t
+{
+   std::string	name;
+   unsigned long nops;		// operations per repeat
+   int		nrep;
+   double	ns_med;		// ns/op
+   double	ns_min;
+   double	ns_mad;		// median absolute deviation
+   double	frames;		// frames per op, 0 = n/a
+   double get_fps() const	{ return frames > 0 && ns_med > 0 ? frames * 1e9 / ns_med : 0; }
+}
+   bench_result_t
+   ;
+
+//______________________________________________________________________
+typedef struct bench_t
+{
+   bench_t(int nrep=10, double tmin=0.1)
+      : _nrep(nrep < 1 ? 1 : nrep), _tmin(tmin), _filter("")
+   {}
+
+   // run benchmarks with names containing x only, "" = all
+   void set_filter(const char *x)	{ _filter = x; }
+   bool is_selected(const char *name)
+   { return _filter.empty() || std::string(name).find(_filter) != std::string::npos; }
+
+   template<class F>
+   void run(const char *name, F op, double frames=0);
+
+   void print();
+   // append results as TSV, header if a new file
+   int save(const char *fn, const char *commit);
+
+   std::vector<bench_result_t> results;
+
+private:
+   int		_nrep;
+   double	_tmin;		// sec per repeat
+   std::string	_filter;
+
+   void add(const char *name, unsigned long nops, std::vector<double> &ns, double frames);
+}
+   bench_t
+   ;
+
+//----------------------------------------------------------------------
+
+template<class F>
+void bench_t::run(const char *name, F op, double frames)
+{
+   if (! is_selected(name) )	return;
+
+   // warm up and scale
+   unsigned long nops = 1;
+   while (true) {
+      unsigned long long t0 = timer_now_ns();
+      for (unsigned long i=0; i < nops; i++)	op();
+      double dt = (timer_now_ns() - t0) * 1e-9;
+      if (dt >= _tmin || nops >= (1UL << 40) )	break;
+      nops = dt > 0 && _tmin / dt < 100 ? (unsigned long)(nops * _tmin / dt * 1.2) + 1 : nops * 100;
+   }
+
+   std::vector<double> ns(_nrep);
+   for (int k=0; k < _nrep; k++) {
+      unsigned long long t0 = timer_now_ns();
+      for (unsigned long i=0; i < nops; i++)	op();
+      ns[k] = (double)(timer_now_ns() - t0) / nops;
+   }
+   add(name, nops, ns, frames);
+}
+
+#endif //~ benchmark_h
@@ -9,12 +9,17 @@
  ***********************************************************************/
 #include "SupixAnly.h"
 
+#include <TEnv.h>
+
 // C headers
+#include <stdio.h>	// sscanf()
 #include <unistd.h>     // for getopt()
 
 // C++ headers
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <vector>
 using namespace std;
 
 
@@ -24,11 +29,21 @@ usage(char **argv)
    cout << "Usage: " << argv[0] << " [options] /path/to/pattern*.root" << endl
 	<< "\t\t -a		# fill all" << endl
 	<< "\t\t -b		# fill control plots" << endl
+	<< "\t\t -D		# derived quantities into derived/<file>-derived.root friend trees, on -j threads" << endl
+	<< "\t\t -d		# fill the seed & 5x5 plots of -b from the friend trees of -D" << endl
+	<< "\t\t -j NUM		# [1] threads to fill control plots, a histogram set each" << endl
+	<< "\t\t -S LIST	# scaling of -b on threads, e.g. 1,2,4,8,16; no output file" << endl
 	<< "\t\t -r NUM		# pixel row" << endl
 	<< "\t\t -c NUM		# pixel col" << endl
 	<< "\t\t -n NUM		# nentries" << endl
 	<< "\t\t -w NUM		# max number of waveforms" << endl
 	<< "\t\t -o pathname	# output histogram file" << endl
+	<< "\t\t -C MB		# TTreeCache size, 0 = ROOT default, -1 = none" << endl
+	<< "\t\t -L NUM		# [0] cache learning entries, 0 = branches of each stage" << endl
+	<< "\t\t -P		# asynchronous prefetching of the cache" << endl
+	<< "\t\t -O NUM		# [0] next files of the chain opened in the background" << endl
+	<< "\t\t -F MIN:STEP:N	# [0:0.1:200] threshold grid of the fake-hit scans, sigma" << endl
+	<< "\t\t -K		# clusters of -b as full 7x7 components, not the 3-hop growth" << endl
 	<< endl;
    exit(0);
 }
@@ -41,6 +56,18 @@ main(int argc, char **argv)
    int nentries = 0;
    int row = -1, col = -1;
    int nwaves_max = 10;
+   int nthreads = 1;
+   vector<int> scaling;		// threads
+   double cache_mb = 0;		// ROOT default
+   int cache_learn = 0;
+   int open_ahead = 0;
+   bool prefetch = false;
+   double fake_min = 0, fake_step = 0.1;	// fake-hit scans
+   int fake_nbins = 200;
+   bool cluster_sweep = false;		// 3-hop growth of earlier productions
+   bool derive = false		// friend trees
+      , use_derived = false
+      ;
    bool fill_ctrl = false	// control plots
       , fill_wave = false	// waveforms
       ;
@@ -52,7 +79,7 @@ main(int argc, char **argv)
    int copt;
    // int xint;
    // unsigned long xulong;
-   while ((copt = getopt(argc, argv, "abc:n:o:r:w:")) != -1) {
+   while ((copt = getopt(argc, argv, "abc:dj:n:o:r:w:C:DF:KL:O:PS:")) != -1) {
       switch (copt) {
       case 'a':		// number of entries
 	 fill_ctrl = true;
@@ -61,6 +88,22 @@ main(int argc, char **argv)
       case 'b':		// number of entries
 	 fill_ctrl = true;
          break;
+      case 'D':		// derive friend trees
+	 derive = true;
+         break;
+      case 'd':		// fill from friend trees
+	 use_derived = true;
+         break;
+      case 'j':		// threads
+	 nthreads = atoi(optarg);
+         break;
+      case 'S': {	// scaling report
+	 istringstream iss(optarg);
+	 string tok;
+	 while (getline(iss, tok, ',') )
+	    scaling.push_back(atoi(tok.c_str() ) );
+         break;
+      }
       case 'n':		// number of entries
 	 nentries = atoi(optarg);
          break;
@@ -79,6 +122,26 @@ main(int argc, char **argv)
 	 nwaves_max = atoi(optarg);
 	 fill_wave = true;
          break;
+      case 'C':		// cache size
+	 cache_mb = atof(optarg);
+         break;
+      case 'L':		// cache learning entries
+	 cache_learn = atoi(optarg);
+         break;
+      case 'O':		// files opened ahead
+	 open_ahead = atoi(optarg);
+         break;
+      case 'P':		// async prefetching
+	 prefetch = true;
+         break;
+      case 'F':		// fake-hit grid
+	 if (sscanf(optarg, "%lf:%lf:%d", &fake_min, &fake_step, &fake_nbins) != 3
+	     || fake_step <= 0 || fake_nbins < 1)
+	    usage(argv);
+         break;
+      case 'K':		// cluster sweep
+	 cluster_sweep = true;
+         break;
       default:
          usage(argv);
       }
@@ -92,6 +155,10 @@ main(int argc, char **argv)
        << " optind=" << optind
        << endl;
 
+   // before any file opened
+   if (prefetch)
+      gEnv->SetValue("TFile.AsyncPrefetching", 1);
+
    // tree
    TChain* chain = new TChain("supix");
    
@@ -109,6 +176,19 @@ main(int argc, char **argv)
    //chain->Print();
 
    SupixAnly* anly = new SupixAnly(chain);
+   anly->set_cache(cache_mb < 0 ? -1 : (Long64_t)(cache_mb * 1048576), cache_learn);
+   anly->set_open_ahead(open_ahead);
+   anly->set_fake_grid(fake_min, fake_step, fake_nbins);
+   anly->set_cluster_sweep(cluster_sweep);
+   if (scaling.size() ) {
+      anly->Scaling(nentries, scaling);
+      return 0;
+   }
+   anly->set_nthreads(nthreads);
+   if (derive) {
+      anly->Derive();
+      return 0;
+   }
    //anly->get_RunInfo()->Print();
    gDirectory->pwd();
 
@@ -119,7 +199,11 @@ main(int argc, char **argv)
 
    // book and fill histograms
    anly->Book();
-   if (fill_ctrl) {
+   if (fill_ctrl && use_derived) {
+      anly->LoopDerived(nentries);
+      anly->Write();
+   }
+   else if (fill_ctrl) {
       anly->Loop(nentries);
       anly->Write();
    }
@@ -129,6 +213,7 @@ main(int argc, char **argv)
       anly->build_waveform(nentries, row, col);
       anly->write_waveform();
    }
+   anly->print_io();	// bytes read by stage
    
    //tfile->Write();
    // if (fill_wave)
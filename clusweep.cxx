@@ -0,0 +1,161 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * clusters of a frame for a sweep of thresholds, in one pass.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "clusweep.h"
+
+#include <algorithm>
+using namespace std;
+
+//______________________________________________________________________
+ClusterSweep::ClusterSweep(int nrows, int ncols)
+   : m_nrows(nrows), m_ncols(ncols)
+{
+   int n = nrows * ncols;
+   m_sorted.reserve(n);
+   m_rank.assign(n, -1);
+   m_parent.resize(n);
+   m_next.resize(n);
+   m_tail.resize(n);
+   m_stats.resize(n);
+   m_wrow.resize(n);
+   m_wcol.resize(n);
+}
+
+//______________________________________________________________________
+void ClusterSweep::set_thresholds(const vector<double> &thr)
+{
+   m_thr = thr;
+   m_order.resize(thr.size() );
+   for (size_t k=0; k < thr.size(); k++)
+      m_order[k] = k;
+   sort(m_order.begin(), m_order.end(), [this](int a, int b) { return m_thr[a] > m_thr[b]; });
+   m_clusters.resize(thr.size() );
+   m_first.resize(thr.size() );
+   m_members.reserve(thr.size() * 64);
+}
+
+// root of rank r, path halving
+//______________________________________________________________________
+int ClusterSweep::find(int r)
+{
+   while (m_parent[r] != r) {
+      m_parent[r] = m_parent[m_parent[r] ];
+      r = m_parent[r];
+   }
+   return r;
+}
+
+// smaller cluster into the larger, stats and member lists merged
+//______________________________________________________________________
+bool ClusterSweep::join(int a, int b)
+{
+   a = find(a);
+   b = find(b);
+   if (a == b)	return false;
+   if (m_stats[a].size < m_stats[b].size)	swap(a, b);
+   m_parent[b] = a;
+
+   sweep_cluster_t &s = m_stats[a], &t = m_stats[b];
+   s.size	+= t.size;
+   s.sum	+= t.sum;
+   s.noise2	+= t.noise2;
+   s.row_min	= min(s.row_min, t.row_min);
+   s.row_max	= max(s.row_max, t.row_max);
+   s.col_min	= min(s.col_min, t.col_min);
+   s.col_max	= max(s.col_max, t.col_max);
+   m_wrow[a]	+= m_wrow[b];
+   m_wcol[a]	+= m_wcol[b];
+   m_next[m_tail[a] ] = b;
+   m_tail[a]	= m_tail[b];
+   return true;
+}
+
+//______________________________________________________________________
+void ClusterSweep::run(const double *snr, const double *charge, const double *noise, int seed)
+{
+   // ranks of the last frame
+   for (size_t r=0; r < m_sorted.size(); r++)
+      m_rank[m_sorted[r] ] = -1;
+   m_sorted.clear();
+   m_members.clear();
+   if (m_thr.empty() )	return;
+
+   // candidates by SNR, once
+   int n = m_nrows * m_ncols;
+   double tmin = m_thr[m_order.back() ];
+   for (int p=0; p < n; p++)
+      if (snr[p] > tmin)	m_sorted.push_back(p);
+   sort(m_sorted.begin(), m_sorted.end(), [snr](int a, int b)
+	{ return snr[a] > snr[b] || (snr[a] == snr[b] && a < b); });
+
+   // thresholds high to low, each adds its pixels
+   int nadded = 0, nclusters = 0;
+   int nsorted = m_sorted.size();
+   for (size_t o=0; o < m_order.size(); o++) {
+      int k = m_order[o];
+      double t = m_thr[k];
+      for (; nadded < nsorted && snr[m_sorted[nadded] ] > t; nadded++) {
+	 int r = nadded, p = m_sorted[r];
+	 int row = p / m_ncols, col = p % m_ncols;
+	 m_rank[p]	= r;
+	 m_parent[r]	= r;
+	 m_next[r]	= -1;
+	 m_tail[r]	= r;
+	 sweep_cluster_t &s = m_stats[r];
+	 s.size		= 1;
+	 s.sum		= charge[p];
+	 s.noise2	= noise[p] * noise[p];
+	 s.row_min = s.row_max = row;
+	 s.col_min = s.col_max = col;
+	 m_wrow[r]	= charge[p] * row;
+	 m_wcol[r]	= charge[p] * col;
+	 nclusters++;
+	 for (int i=row-1; i <= row+1; i++) {
+	    if (i < 0 || i >= m_nrows)	continue;
+	    for (int j=col-1; j <= col+1; j++) {
+	       if (j < 0 || j >= m_ncols)	continue;
+	       int q = m_rank[i*m_ncols + j];
+	       if (q >= 0 && q != r && join(r, q) )	nclusters--;
+	    }
+	 }
+      }
+
+      // cluster of the seed, members by rank = by SNR
+      sweep_cluster_t &c = m_clusters[k];
+      int root = seed >= 0 && seed < n && m_rank[seed] >= 0 ? find(m_rank[seed]) : -1;
+      m_first[k] = m_members.size();
+      if (root >= 0) {
+	 c = m_stats[root];
+	 c.row = c.sum ? m_wrow[root] / c.sum : 0.5 * (c.row_min + c.row_max);
+	 c.col = c.sum ? m_wcol[root] / c.sum : 0.5 * (c.col_min + c.col_max);
+	 for (int r = root; r >= 0; r = m_next[r])
+	    m_members.push_back(r);
+	 sort(m_members.begin() + m_first[k], m_members.end() );
+	 for (size_t i = m_first[k]; i < m_members.size(); i++)
+	    m_members[i] = m_sorted[m_members[i] ];
+      }
+      else {
+	 c.size = 0;
+	 c.sum = c.noise2 = 0;
+	 c.row = c.col = -1;
+	 c.row_min = c.row_max = c.col_min = c.col_max = -1;
+      }
+      c.threshold	= t;
+      c.npixs		= nadded;
+      c.nclusters	= nclusters;
+   }
+}
+
+//______________________________________________________________________
+int ClusterSweep::get_members(int k, int *pix, int nmax) const
+{
+   int n = min(m_clusters[k].size, nmax);
+   for (int i=0; i < n; i++)
+      pix[i] = m_members[m_first[k] + i];
+   return n;
+}
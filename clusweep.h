@@ -0,0 +1,87 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * clusters of a frame for a sweep of thresholds, in one pass.
+ *
+ * - pixels over the lowest threshold sorted once by SNR, added from the
+ *   highest down; 8-connected neighbours joined by union-find, so each
+ *   threshold only adds its new pixels to the clusters of the one above.
+ * - per threshold, the cluster of a seed pixel: size, charge sum, noise,
+ *   charge weighted centroid, bounding box and its members by SNR; and
+ *   the pixels over it and their number of clusters.
+ * - a pixel is over a threshold if snr > threshold; pixels to be left
+ *   out get an snr below all thresholds, e.g. -1e30.
+ * - no ROOT, no allocation per frame: the DAQ can use it as is.
+ *
+ * usage:
+ *   ClusterSweep sweep(NROWS, NCOLS);
+ *   sweep.set_thresholds(thr);			// e.g. 1, 1.2, ..., 4.8
+ *   sweep.run(snr, charge, noise, seed);	// [NPIXS] each, seed pixel
+ *   const sweep_cluster_t &c = sweep.get_cluster(k);	// of thr[k]
+ *   int n = sweep.get_members(k, pix, 49);	// pixels, highest SNR first
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef clusweep_h
+#define clusweep_h
+
+#include <vector>
+
+// cluster of the seed at a threshold; size 0 if the seed is not over it
+typedef struct sweep_cluster_t
+{
+   double	threshold;
+   int		size;
+   double	sum;		// of charge
+   double	noise2;		// sum of noise^2, snr = sum/sqrt(noise2)
+   double	row, col;	// centroid, charge weighted
+   int		row_min, row_max;	// bounding box
+   int		col_min, col_max;
+   int		npixs;		// pixels over the threshold, all clusters
+   int		nclusters;
+}
+   sweep_cluster_t
+   ;
+
+class ClusterSweep
+{
+public:
+   ClusterSweep(int nrows, int ncols);
+   ~ClusterSweep() {}
+
+   // any order; results by the index in thr
+   void set_thresholds(const std::vector<double> &thr);
+   int get_nthresholds() const		{ return m_thr.size(); }
+
+   // a frame: snr, charge & noise [nrows*ncols], seed pixel row*ncols+col
+   void run(const double *snr, const double *charge, const double *noise, int seed);
+
+   const sweep_cluster_t & get_cluster(int k) const	{ return m_clusters[k]; }
+   // members of the cluster of thr[k], highest SNR first; return number copied
+   int get_members(int k, int *pix, int nmax) const;
+
+private:
+   int find(int r);
+   bool join(int a, int b);		// false if one cluster already
+
+   int		m_nrows, m_ncols;
+   std::vector<double> m_thr;		// as given
+   std::vector<int> m_order;		// of m_thr, high to low
+
+   // pixels over the lowest threshold, by SNR: rank -> pixel
+   std::vector<int> m_sorted;
+   std::vector<int> m_rank;		// pixel -> rank, -1 if not added yet
+
+   // union-find of ranks, stats valid at roots
+   std::vector<int> m_parent;
+   std::vector<int> m_next;		// members of a root, linked
+   std::vector<int> m_tail;
+   std::vector<sweep_cluster_t> m_stats;
+   std::vector<double> m_wrow, m_wcol;	// charge weighted sums
+
+   std::vector<sweep_cluster_t> m_clusters;	// by threshold as given
+   std::vector<int> m_members;			// of all thresholds
+   std::vector<int> m_first;			// in m_members, by threshold as given
+};
+
+#endif //~ clusweep_h
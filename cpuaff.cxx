@@ -0,0 +1,129 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * CPU affinity and real-time scheduling of threads.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "cpuaff.h"
+
+#include <pthread.h>
+#include <dirent.h>	// /proc/self/task
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>	// SYS_gettid
+
+static pid_t thread_id()
+{
+   return (pid_t)syscall(SYS_gettid);
+}
+
+//______________________________________________________________________
+int cpus_parse(const char *s, cpu_set_t *set)
+{
+   CPU_ZERO(set);
+   if (! s)	return 0;
+   while (*s) {
+      char *end;
+      long lo = strtol(s, &end, 10);
+      if (end == s || lo < 0)	return -1;
+      long hi = lo;
+      s = end;
+      if (*s == '-') {
+	 hi = strtol(++s, &end, 10);
+	 if (end == s || hi < lo)	return -1;
+	 s = end;
+      }
+      if (hi >= CPU_SETSIZE)	return -1;
+      for (long c = lo; c <= hi; c++)
+	 CPU_SET(c, set);
+      if (*s == ',')	s++;
+      else if (*s)	return -1;
+   }
+   return CPU_COUNT(set);
+}
+
+std::string cpus_sprint(const cpu_set_t *set)
+{
+   std::string s;
+   char buf[32];
+   for (int c=0; c < CPU_SETSIZE; c++) {
+      if (! CPU_ISSET(c, set) )	continue;
+      int hi = c;
+      while (hi + 1 < CPU_SETSIZE && CPU_ISSET(hi + 1, set) )
+	 hi++;
+      if (hi == c)	snprintf(buf, sizeof(buf), "%d", c);
+      else		snprintf(buf, sizeof(buf), "%d-%d", c, hi);
+      if (s.size() )	s += ',';
+      s += buf;
+      c = hi;
+   }
+   return s.size() ? s : "-";
+}
+
+//______________________________________________________________________
+int cpus_pin(const cpu_set_t *set)
+{
+   return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), set);
+}
+
+// allowed cpus of each thread less set; a thread allowed on set only is left
+//______________________________________________________________________
+int cpus_exclude(const cpu_set_t *set)
+{
+   DIR *dir = opendir("/proc/self/task");
+   if (! dir)	return -1;
+   int n = 0;
+   struct dirent *ent;
+   while ( (ent = readdir(dir)) ) {
+      pid_t tid = atoi(ent->d_name);
+      if (tid <= 0)	continue;
+      cpu_set_t cur, rest;
+      if (sched_getaffinity(tid, sizeof(cur), &cur) < 0)	continue;
+      CPU_XOR(&rest, &cur, set);
+      CPU_AND(&rest, &rest, &cur);	// cur & ~set
+      if (CPU_COUNT(&rest) == 0 || CPU_EQUAL(&rest, &cur) )	continue;
+      if (sched_setaffinity(tid, sizeof(rest), &rest) == 0)
+	 n++;
+   }
+   closedir(dir);
+   return n;
+}
+
+//______________________________________________________________________
+int sched_fifo(int prio)
+{
+   struct sched_param sp;
+   int policy = SCHED_OTHER;
+   sp.sched_priority = 0;
+   if (prio > 0) {
+      policy = SCHED_FIFO;
+      int pmin = sched_get_priority_min(SCHED_FIFO);
+      int pmax = sched_get_priority_max(SCHED_FIFO);
+      sp.sched_priority = prio < pmin ? pmin : prio > pmax ? pmax : prio;
+   }
+   return pthread_setschedparam(pthread_self(), policy, &sp);
+}
+
+std::string sched_sprint()
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+   int policy = SCHED_OTHER;
+   struct sched_param sp;
+   sp.sched_priority = 0;
+   pthread_getschedparam(pthread_self(), &policy, &sp);
+   const char *name = policy == SCHED_FIFO ? "SCHED_FIFO"
+      : policy == SCHED_RR ? "SCHED_RR"
+      : policy == SCHED_BATCH ? "SCHED_BATCH"
+      : policy == SCHED_IDLE ? "SCHED_IDLE" : "SCHED_OTHER";
+   char buf[64];
+   snprintf(buf, sizeof(buf), "tid=%d cpus=", (int)thread_id() );
+   std::string s = buf;
+   s += cpus_sprint(&set);
+   snprintf(buf, sizeof(buf), " %s/%d", name, sp.sched_priority);
+   return s + buf;
+}
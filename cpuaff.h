@@ -0,0 +1,44 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * CPU affinity and real-time scheduling of threads.
+ *
+ * - cpu lists as taskset(1) -c: "2", "2,3", "4-7,9".
+ * - cpus_pin() and sched_fifo() act on the calling thread; a thread
+ *   created later inherits both.
+ * - cpus_exclude() moves every thread of the process off a set, for
+ *   cores reserved to the DAQ threads.
+ *
+ * usage:
+ *   cpu_set_t set;
+ *   cpus_parse("2", &set);
+ *   cpus_pin(&set);
+ *   sched_fifo(50);
+ *   LOG << sched_sprint() << endl;
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef cpuaff_h
+#define cpuaff_h
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>	// cpu_set_t
+
+#include <string>
+
+// cpus of list s into set, return number of cpus, -1 on syntax error
+int cpus_parse(const char *s, cpu_set_t *set);
+// list of a set, "-" if empty
+std::string cpus_sprint(const cpu_set_t *set);
+// pin the calling thread to set, return 0 or errno
+int cpus_pin(const cpu_set_t *set);
+// move all threads of the process off set, return threads moved or -1
+int cpus_exclude(const cpu_set_t *set);
+// SCHED_FIFO at prio for the calling thread, prio <= 0 = SCHED_OTHER; return 0 or errno
+int sched_fifo(int prio);
+// effective affinity & policy of the calling thread, e.g. "tid=123 cpus=2 SCHED_FIFO/50"
+std::string sched_sprint();
+
+#endif //~ cpuaff_h
@@ -12,6 +12,8 @@
 //#define LOG std::cout <<__PRETTY_FUNCTION__<<" --- "
 
 #include <unistd.h>     // for getopt()
+#include <fcntl.h>	// open()
+#include <sys/wait.h>	// waitpid()
 #include <iostream>
 using namespace std;
 
@@ -19,6 +21,8 @@ SupixDAQ *g_supix = NULL;
 
 // create a new thread
 void * new_thread(void *arg);
+// end-to-end benchmark with synthetic frames
+int bench_e2e(double fps, double sec, double ratio, const string &dir);
 
 enum UNIT_TESTS { NOTEST, START_RUN, STOP_RUN, LOCK_RUN, TEST_FIFO };
 
@@ -26,14 +30,29 @@ enum UNIT_TESTS { NOTEST, START_RUN, STOP_RUN, LOCK_RUN, TEST_FIFO };
 void usage(char **argv) {
    cout << "Usage: " << argv[0] << " [options]" << endl
 	<< "\t\t -h		# print this" << endl
+	<< "\t\t -A FLOAT	# auto-tune -L, -w and -z for triggers per frame, 0 = by -o" << endl
+	<< "\t\t -B FPS[:SEC[:RATIO]]	# benchmark, synthetic frames from FPS up, [5] sec per rate, RATIO of frames pulsed" << endl
 	<< "\t\t -C		# continuous DAQ mode" << endl
+	<< "\t\t -F RD[:WR]	# SCHED_FIFO priority of reader [and writer], 0 = SCHED_OTHER" << endl
+	<< "\t\t -H		# hardware performance counters per stage" << endl
+	<< "\t\t -K		# recommend -L from the last run's timing (beside -l FILE) and options, no DAQ" << endl
 	<< "\t\t -L INT		# max frames in pipeline" << endl
+	<< "\t\t -M NAME	# [" SHMSTATS_NAME "] shared memory of live statistics, - = none" << endl
 	<< "\t\t -N		# noise DAQ mode" << endl
+	<< "\t\t -O FLOAT	# [0.5] threshold controller: max pipeline occupancy" << endl
+	<< "\t\t -P N		# [1] time 1 in N frames" << endl
 	<< "\t\t -R		# write ROOT files" << endl
+	<< "\t\t -S LOW:HIGH	# load-shedding between occupancy watermarks, e.g. 0.5:0.9" << endl
 	<< "\t\t -T		# test mode" << endl
 	<< "\t\t -W		# write raw data files" << endl
+	<< "\t\t -X N:USEC	# trace 1 in N frames and spans >= USEC, Chrome JSON" << endl
+	<< "\t\t -Z C[:B[:F]]	# ROOT compression = algorithm*100 + level, basket bytes, AutoFlush" << endl
 	<< "\t\t -a INT		# [0, 7], chip addr. to read" << endl
+	<< "\t\t -b FLOAT	# threshold controller: max output in MiB/s" << endl
+	<< "\t\t -c RD[:WR]	# cpu lists, e.g. 2:3-4, to pin reader [and writer]; the rest kept off" << endl
 	<< "\t\t -f INT		# max file size in MiB" << endl
+	<< "\t\t -l FILE	# [stdout] log of run-time messages" << endl
+	<< "\t\t -m FLAGS	# pipeline & stacks memory: h = huge pages, l = mlock, p = prefault" << endl
 	<< "\t\t -n INT		# N frames to read. 0 = infinite" << endl
 	<< "\t\t -o INT		# trigger per N frames" << endl
 	<< "\t\t -p INT		# N frames to record pre-trigger" << endl
@@ -49,6 +68,7 @@ void usage(char **argv) {
 	<< endl
 	<< "\t\t -v INT		# [0] verbosity" << endl
 	<< "\t\t -w INT		# [10] timewait in usec" << endl
+	<< "\t\t -x MIN:MAX	# [t:2t] threshold controller: bounds of -t" << endl
 	<< "\t\t -z INT		# [1]  timeout in sec" << endl
       ;
 
@@ -64,6 +84,8 @@ int main(int argc, char **argv)
    string rawtag = "raw";
    int unit_test = NOTEST;
    bool debug = false;		// mode_debug
+   bool recommend = false;
+   double bench_fps = 0, bench_sec = 5, bench_ratio = 0;
    bool noise_run = false;	// noise run
    
    //cout << "supix=" << g_supix << endl;
@@ -77,37 +99,106 @@ int main(int argc, char **argv)
    int xint;
    double xdouble;
    unsigned long xulong;
-   while ( (copt = getopt(argc, argv, "hCL:NTRWa:f:n:o:p:q:r:s:t:u:v:w:z:")) != -1) {
+   while ( (copt = getopt(argc, argv, "hA:B:CF:HKL:M:NO:P:TRS:WX:a:b:c:f:l:m:n:o:p:q:r:s:t:u:v:w:x:z:Z:")) != -1) {
       switch (copt) {
+      case 'A':
+         sscanf(optarg, "%lf", &xdouble);
+	 g_supix->set_autotune(xdouble);
+         break;
+      case 'B':
+	 sscanf(optarg, "%lf:%lf:%lf", &bench_fps, &bench_sec, &bench_ratio);
+	 break;
       case 'C':
 	 g_supix->set_daq_mode(M_CONTINUOUS);
 	 break;
+      case 'F': {
+	 int prio[2] = { 0, 0 };
+	 sscanf(optarg, "%d:%d", &prio[SHM_RD], &prio[SHM_WR]);
+	 g_supix->set_rt_prio(SHM_RD, prio[SHM_RD]);
+	 g_supix->set_rt_prio(SHM_WR, prio[SHM_WR]);
+	 break;
+      }
+      case 'H':
+	 g_supix->set_perf(true);
+	 break;
+      case 'K':
+	 recommend = true;
+	 break;
       case 'L':
          sscanf(optarg, "%d", &xint);
 	 g_supix->set_pipeline_max(xint);
          break;
+      case 'M':
+	 g_supix->set_shm_name(strcmp(optarg, "-") ? optarg : "");
+	 break;
       case 'N':
 	 noise_run = true;
 	 g_supix->set_daq_mode(M_NOISE);
 	 // g_supix->set_noise_run();
 	 break;
+      case 'O':
+         sscanf(optarg, "%lf", &xdouble);
+	 g_supix->set_ctrl_occupancy(xdouble);
+         break;
+      case 'P':
+         sscanf(optarg, "%d", &xint);
+	 g_supix->set_timer_sample(xint);
+         break;
       case 'R':
 	 g_supix->set_write_root(true);
 	 break;
+      case 'S':
+	 {
+	    double low = 0.5, high = 0.9;
+	    sscanf(optarg, "%lf:%lf", &low, &high);
+	    g_supix->set_shed(low, high);
+	 }
+	 break;
       case 'T':
 	 debug = true;
 	 break;
       case 'W':
 	 g_supix->set_write_raw(true);
 	 break;
+      case 'X':
+	 {
+	    unsigned long every = 0;
+	    double thresh = 0;
+	    sscanf(optarg, "%lu:%lf", &every, &thresh);
+	    g_supix->set_trace(every, thresh);
+	 }
+	 break;
       case 'a':
          sscanf(optarg, "%d", &xint);
 	 g_supix->set_chip_addr(xint);
          break;
+      case 'b':
+         sscanf(optarg, "%lf", &xdouble);
+	 g_supix->set_ctrl_bandwidth(xdouble);
+         break;
+      case 'c': {
+	 string rd = optarg, wr;
+	 size_t k = rd.find(':');
+	 if (k != string::npos) {
+	    wr = rd.substr(k+1);
+	    rd.erase(k);
+	 }
+	 if (g_supix->set_cpus(SHM_RD, rd.c_str() ) < 0 || g_supix->set_cpus(SHM_WR, wr.c_str() ) < 0)
+	    usage(argv);
+	 break;
+      }
       case 'f':
          sscanf(optarg, "%d", &xint);
 	 g_supix->set_filesize_max(xint * MiB);
          break;
+      case 'l':
+	 g_supix->set_log_file(optarg);
+	 break;
+      case 'm':
+	 xint = mem_parse(optarg);
+	 if (xint < 0)	usage(argv);
+	 g_supix->set_mem_flags(xint);
+	 break;
       case 'n':
          sscanf(optarg, "%lu", &xulong);
 	 g_supix->set_maxframe(xulong);
@@ -146,10 +237,25 @@ int main(int argc, char **argv)
          sscanf(optarg, "%d", &xint);
 	 g_supix->set_timewait(xint);
          break;
+      case 'x':
+	 {
+	    double xmin = -1, xmax = -1;
+	    sscanf(optarg, "%lf:%lf", &xmin, &xmax);
+	    g_supix->set_ctrl_bounds(xmin, xmax);
+	 }
+         break;
       case 'z':
          sscanf(optarg, "%d", &xint);
 	 g_supix->set_timeout(xint);
          break;
+      case 'Z':
+	 {
+	    int compress = -1, basket = 0;
+	    long autoflush = 0;
+	    sscanf(optarg, "%d:%d:%ld", &compress, &basket, &autoflush);
+	    g_supix->set_root_settings(compress, basket, autoflush);
+	 }
+	 break;
       case 'h':
       default:
          usage(argv);
@@ -167,6 +273,16 @@ int main(int argc, char **argv)
       rawtag = "test";
    }
    g_supix->set_filename(rawdir.c_str(), rawtag.c_str());
+   if (recommend) {
+      g_supix->recommend_last();
+      delete g_supix;
+      return 0;
+   }
+   if (bench_fps > 0) {
+      int rv = bench_e2e(bench_fps, bench_sec, bench_ratio, rawdir);
+      delete g_supix;
+      return rv;
+   }
    printids("[main] initialize:");
    g_supix->initialize();
    
@@ -233,3 +349,123 @@ void *new_thread(void *arg)
    printids("[child] return:");
    return ((void*)0);
 }
+
+
+// a DAQ run at fps in a child process, output to <dir>/bench_e2e.log
+// return: TSV line of SupixDAQ::bench_header(), "" on failure
+//______________________________________________________________________
+string bench_step(double fps, double sec, double ratio, const string &dir)
+{
+   int fd[2];
+   if (pipe(fd) < 0)	err_sys("pipe");
+   pid_t pid = fork();
+   if (pid < 0)		err_sys("fork");
+
+   if (pid == 0) {		// child
+      close(fd[0]);
+      string fn = dir + "/bench_e2e.log";
+      int fdlog = open(fn.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if (fdlog >= 0) {
+	 dup2(fdlog, STDOUT_FILENO);
+	 dup2(fdlog, STDERR_FILENO);
+	 close(fdlog);
+      }
+      g_supix->set_source(fps, ratio);
+      g_supix->set_maxframe((unsigned long)(fps * sec) );
+      g_supix->initialize();
+      pthread_t ntid;
+      int err = pthread_create(&ntid, NULL, new_thread, g_supix);
+      if (err != 0)	err_sys("pthread_create");
+      g_supix->start_run();
+      g_supix->stop_run();
+      g_supix->finalize();
+      const string &line = g_supix->get_bench_line();
+      if (write(fd[1], line.c_str(), line.size() ) < 0)
+	 err_ret("write");
+      close(fd[1]);
+      _exit(0);
+   }
+
+   close(fd[1]);
+   string line;
+   char buf[1024];
+   ssize_t n;
+   while ( (n = read(fd[0], buf, sizeof(buf)) ) > 0)
+      line.append(buf, n);
+   close(fd[0]);
+   int status = 0;
+   waitpid(pid, &status, 0);
+   if (! WIFEXITED(status) || WEXITSTATUS(status) )
+      line = "";
+   return line;
+}
+
+// column of SupixDAQ::bench_header() in a line, "" if none
+//______________________________________________________________________
+static string tsv_field(const string &line, const char *name)
+{
+   string header = SupixDAQ::bench_header();
+   size_t h = 0, l = 0;
+   while (1) {
+      size_t he = header.find('\t', h);
+      size_t le = line.find('\t', l);
+      if (header.compare(h, he == string::npos ? string::npos : he - h, name) == 0)
+	 return line.substr(l, le == string::npos ? string::npos : le - l);
+      if (he == string::npos || le == string::npos)	return "";
+      h = he + 1;
+      l = le + 1;
+   }
+}
+
+// find the max sustained rate, i.e. no frame lost by the FIFO and the
+// run completed, no timeout or data error:
+// the rate doubled until frames lost, then bisected.
+// - each rate appended to <dir>/bench_e2e.tsv with host and time.
+//______________________________________________________________________
+int bench_e2e(double fps, double sec, double ratio, const string &dir)
+{
+   const int nbisect = 5;
+   char host[64] = "";
+   gethostname(host, sizeof(host) - 1);
+   string fn = dir + "/bench_e2e.tsv";
+   bool header = access(fn.c_str(), F_OK) != 0;
+   FILE *fp = fopen(fn.c_str(), "a");
+   if (! fp)	err_sys("fopen(\"%s\")", fn.c_str() );
+   if (header)
+      fprintf(fp, "host\ttime\t%s\tsustained\n", SupixDAQ::bench_header().c_str() );
+
+   double good = 0, bad = 0;
+   for (int n = 0; n < nbisect && fps >= 1; ) {
+      string line = bench_step(fps, sec, ratio, dir);
+      if (line.empty() ) {
+	 CERR << "run at " << fps << " fps failed, see " << dir << "/bench_e2e.log" << endl;
+	 break;
+      }
+      unsigned long lost = 1;
+      double fps_read = 0, mbps = 0, isfull = 0;
+      sscanf(line.c_str(), "%*f\t%*f\t%lf\t%lu\t%*f\t%*u\t%*u\t%lf\t%*u\t%*u\t%lf"
+	     , &fps_read, &lost, &isfull, &mbps);
+      bool ok = lost == 0 && tsv_field(line, "completed") == "1";
+
+      time_t now = time(NULL);
+      char ts[32];
+      strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", localtime(&now) );
+      fprintf(fp, "%s\t%s\t%s\t%d\n", host, ts, line.c_str(), ok);
+      fflush(fp);
+      LOG << fps << " fps: read " << fps_read << " fps, lost " << lost
+	  << ", ISFULL " << isfull * 100 << "%, " << mbps << " MiB/s"
+	  << (ok ? "" : " -- NOT sustained") << endl;
+
+      if (ok)	good = fps;
+      else	bad = fps;
+      if (bad == 0)		fps *= 2;
+      else if (good == 0)	fps /= 2;
+      else {
+	 fps = (good + bad) / 2;
+	 n++;
+      }
+   }
+   fclose(fp);
+   LOG << "max sustained " << good << " fps, results in " << fn << endl;
+   return good > 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * dense set of 1D histograms, e.g. one per pixel, filled a frame at a time.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "densehist.h"
+#include "error.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>	// sysconf()
+
+//______________________________________________________________________
+DenseHist::DenseHist(int n, int xmin, int nbins, long lo, long hi)
+   : m_n(n), m_xmin(xmin), m_nbins(nbins)
+{
+   m_blo = 0;
+   m_bhi = nbins + 1;
+   m_blo = bin(lo);
+   m_bhi = bin(hi);
+   m_stride = m_bhi - m_blo + 1;
+
+   size_t page = sysconf(_SC_PAGESIZE);
+   m_bytes = ( (size_t)n * m_stride * sizeof(unsigned int) + page - 1) / page * page;
+   void *p = mmap(NULL, m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED)
+      err_sys("DenseHist: mmap %lu bytes", (unsigned long)m_bytes);
+   m_counts	= (unsigned int*)p;
+   m_sumx	= new long long[n];
+   m_sumx2	= new long long[n];
+   m_idx	= new int[n];
+   memset(m_sumx,  0, n * sizeof(long long) );
+   memset(m_sumx2, 0, n * sizeof(long long) );
+   m_entries	= 0;
+}
+
+DenseHist::~DenseHist()
+{
+   munmap(m_counts, m_bytes);
+   delete [] m_sumx;
+   delete [] m_sumx2;
+   delete [] m_idx;
+}
+
+// bin of x clamped to those stored
+//______________________________________________________________________
+int DenseHist::bin(long x) const
+{
+   int b = x < m_xmin ? 0 : x >= (long)m_xmin + m_nbins ? m_nbins + 1 : x - m_xmin + 1;
+   return b < m_blo ? m_blo : b > m_bhi ? m_bhi : b;
+}
+
+//______________________________________________________________________
+template<class T> void DenseHist::fill_batch(const T *x)
+{
+   // values clamped to those of the stored bins first: no overflow of int
+   const int n = m_n, nbins = m_nbins, off = 1 - m_xmin;
+   const int xlo = m_xmin + m_blo - 1, xhi = m_xmin + m_bhi - 1;
+   int *idx = m_idx;
+   long long *sx  = m_sumx;
+   long long *sx2 = m_sumx2;
+
+   // bins: branch free, vectorized
+   for (int k=0; k < n; k++) {
+      int v = x[k] < xlo ? xlo : x[k] > xhi ? xhi : (int)x[k];
+      idx[k] = v + off;
+   }
+   // sums of in-range values, i.e. bins 1..nbins
+   for (int k=0; k < n; k++) {
+      long long v = (unsigned)(idx[k] - 1) < (unsigned)nbins ? (long long)x[k] : 0;
+      sx[k]  += v;
+      sx2[k] += v * v;
+   }
+   // counts: an increment in each row
+   unsigned int *c = m_counts - m_blo;
+   for (int k=0; k < n; k++, c += m_stride)
+      c[idx[k]]++;
+   m_entries++;
+}
+
+void DenseHist::fill(const int *x)
+{
+   fill_batch(x);
+}
+
+void DenseHist::fill(const unsigned short *x)
+{
+   fill_batch(x);
+}
+
+//______________________________________________________________________
+void DenseHist::add(const DenseHist &o)
+{
+   size_t nc = (size_t)m_n * m_stride;
+   for (size_t i=0; i < nc; i++)
+      if (o.m_counts[i])	m_counts[i] += o.m_counts[i];	// untouched pages stay so
+   for (int k=0; k < m_n; k++) {
+      m_sumx[k]  += o.m_sumx[k];
+      m_sumx2[k] += o.m_sumx2[k];
+   }
+   m_entries += o.m_entries;
+}
+
+void DenseHist::reset()
+{
+   madvise(m_counts, m_bytes, MADV_DONTNEED);	// zero pages again
+   memset(m_sumx,  0, m_n * sizeof(long long) );
+   memset(m_sumx2, 0, m_n * sizeof(long long) );
+   m_entries = 0;
+}
+
+// whole pages inside the row of k
+//______________________________________________________________________
+void DenseHist::release(int k)
+{
+   size_t page = sysconf(_SC_PAGESIZE);
+   size_t a = (size_t)k * m_stride * sizeof(unsigned int);
+   size_t b = a + m_stride * sizeof(unsigned int);
+   a = (a + page - 1) / page * page;
+   b = b / page * page;
+   if (b > a)
+      madvise( (char*)m_counts + a, b - a, MADV_DONTNEED);
+}
+
+//______________________________________________________________________
+void DenseHist::get_stats(int k, double *stats) const
+{
+   unsigned long nin = m_entries - get_bin(k, 0) - get_bin(k, m_nbins + 1);
+   stats[0] = nin;		// sumw
+   stats[1] = nin;		// sumw2
+   stats[2] = m_sumx[k];
+   stats[3] = m_sumx2[k];
+}
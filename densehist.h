@@ -0,0 +1,77 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * dense set of 1D histograms, e.g. one per pixel, filled a frame at a time.
+ *
+ * - n histograms of nbins unit bins from an integer xmin; the counts of a
+ *   histogram are contiguous, histograms one after another.  Bin numbers
+ *   as TH1: 0 underflow, 1..nbins, nbins+1 overflow.
+ * - only bins of values in [lo, hi] are stored, e.g. [0, 65535] of an
+ *   unsigned short; values out of it go to the nearest stored bin.
+ * - counts on anonymous pages: pages never filled take no memory, and
+ *   release() gives back those of a histogram already converted.
+ * - fill(): the bins of the whole batch first, a loop the compiler
+ *   vectorizes, then the counts; no virtual call nor bin search per value.
+ * - sums of in-range values exact (integers), in TH1::PutStats() order.
+ *
+ * usage:
+ *   DenseHist h(NPIXS, -30, 330);		// [-30, 300) each
+ *   h.fill( (const int*)pixel_cds );		// a value per histogram
+ *   for (int b=0; b <= h.get_nbins() + 1; b++)
+ *      h1d->SetBinContent(b, h.get_bin(k, b) );
+ *   h1d->SetEntries(h.get_entries() );
+ *   h.get_stats(k, stats);   h1d->PutStats(stats);
+ *   h.release(k);				// last, its counts are gone
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef densehist_h
+#define densehist_h
+
+#include <stddef.h>	// size_t
+#include <limits.h>	// LONG_MIN
+
+class DenseHist
+{
+public:
+   DenseHist(int n, int xmin, int nbins, long lo=LONG_MIN, long hi=LONG_MAX);
+   ~DenseHist();
+
+   // a value per histogram
+   void fill(const int *x);
+   void fill(const unsigned short *x);
+   // counts and sums of another set booked alike
+   void add(const DenseHist &o);
+   void reset();
+   // counts of histogram k no longer needed: its whole pages given back
+   void release(int k);
+
+   int get_n() const			{ return m_n; }
+   int get_nbins() const		{ return m_nbins; }
+   unsigned long get_entries() const	{ return m_entries; }	// each histogram
+   size_t get_bytes() const		{ return m_bytes; }	// mapped
+   unsigned long get_bin(int k, int b) const
+   { return b < m_blo || b > m_bhi ? 0 : m_counts[(size_t)k * m_stride + b - m_blo]; }
+   // sumw, sumw2, sumwx, sumwx2 of in-range values, unit weights
+   void get_stats(int k, double *stats) const;
+
+private:
+   DenseHist(const DenseHist &);		// not copyable
+   DenseHist & operator=(const DenseHist &);
+
+   template<class T> void fill_batch(const T *x);
+   int bin(long x) const;
+
+   int		m_n;
+   int		m_xmin, m_nbins;
+   int		m_blo, m_bhi;		// bins stored
+   size_t	m_stride;		// counts per histogram
+   size_t	m_bytes;
+   unsigned int * m_counts;		// [n][stride]
+   long long *	m_sumx;			// [n], in range
+   long long *	m_sumx2;
+   int *	m_idx;			// [n], bins of a batch
+   unsigned long m_entries;
+};
+
+#endif //~ densehist_h
@@ -0,0 +1,78 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * fake-hit rate of noise frames vs. threshold, for any threshold grid.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "fakescan.h"
+
+#include <math.h>
+
+//______________________________________________________________________
+FakeScan::FakeScan(double xmin, double step, int nbins)
+   : m_xmin(xmin), m_step(step), m_nbins(nbins)
+{
+   m_max.assign(nbins + 2, 0);
+   m_pix.assign(nbins + 2, 0);
+   m_frames	= 0;
+   m_pixels	= 0;
+   m_summed	= (unsigned long)-1;
+}
+
+// bin of x, 0 below xmin, nbins+1 from xmin + nbins*step
+//______________________________________________________________________
+int FakeScan::bin(double x) const
+{
+   double b = floor( (x - m_xmin) / m_step);
+   if (b < 0)		return 0;
+   if (b >= m_nbins)	return m_nbins + 1;
+   return (int)b + 1;
+}
+
+//______________________________________________________________________
+double FakeScan::fill(const double *snr, int n)
+{
+   double max = -HUGE_VAL;
+   for (int k=0; k < n; k++) {
+      max = snr[k] > max ? snr[k] : max;
+      m_pix[bin(snr[k])]++;
+   }
+   if (n > 0)	m_max[bin(max)]++;
+   m_frames++;
+   m_pixels += n;
+   return max;
+}
+
+//______________________________________________________________________
+void FakeScan::add(const FakeScan &o)
+{
+   for (int b=0; b < m_nbins + 2; b++) {
+      m_max[b] += o.m_max[b];
+      m_pix[b] += o.m_pix[b];
+   }
+   m_frames += o.m_frames;
+   m_pixels += o.m_pixels;
+}
+
+// reverse cumulative sums, again only after new frames
+//______________________________________________________________________
+unsigned long FakeScan::over(const std::vector<unsigned long> &h, std::vector<unsigned long> &cum, double t)
+{
+   if (m_summed != m_frames || cum.size() != h.size() ) {
+      m_max_cum.resize(m_nbins + 2);
+      m_pix_cum.resize(m_nbins + 2);
+      unsigned long smax = 0, spix = 0;
+      for (int b = m_nbins + 1; b >= 0; b--) {
+	 m_max_cum[b] = smax += m_max[b];
+	 m_pix_cum[b] = spix += m_pix[b];
+      }
+      m_summed = m_frames;
+   }
+   // grid point i is the low edge of bin i+1
+   double i = floor( (t - m_xmin) / m_step + 0.5);
+   if (i < 0)		return cum[0];
+   if (i > m_nbins)	return 0;
+   return cum[(int)i + 1];
+}
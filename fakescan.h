@@ -0,0 +1,62 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * fake-hit rate of noise frames vs. threshold, for any threshold grid.
+ *
+ * - per frame the max SNR of its pixels once, binned on a fine grid, and
+ *   every pixel SNR on the same grid; no threshold loop per pixel.
+ * - frames with a pixel >= t (fake triggers) and pixels >= t (fake hits)
+ *   by reverse cumulative sums: O(1) per threshold, t to the grid step.
+ * - one scan per thread, add() to merge: frames in any order.
+ *
+ * usage:
+ *   FakeScan scan(0, 0.1, 200);		// 0.1 sigma steps over 0-20
+ *   double max = scan.fill(snr, n);		// a frame of n pixels
+ *   scan.frames_over(4.5) / (double)scan.get_frames()	// fake-trigger rate
+ *   scan.pixels_over(4.5) / (double)scan.get_pixels()	// fake-hit rate
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef fakescan_h
+#define fakescan_h
+
+#include <vector>
+
+class FakeScan
+{
+public:
+   FakeScan(double xmin=0, double step=0.1, int nbins=200);
+   ~FakeScan() {}
+
+   // a frame of n pixels; return its max SNR
+   double fill(const double *snr, int n);
+   // frames of another scan of the same grid
+   void add(const FakeScan &o);
+
+   unsigned long get_frames() const	{ return m_frames; }
+   unsigned long get_pixels() const	{ return m_pixels; }
+   double get_xmin() const		{ return m_xmin; }
+   double get_step() const		{ return m_step; }
+   int get_nbins() const		{ return m_nbins; }
+   // threshold of grid point i = 0..nbins
+   double get_threshold(int i) const	{ return m_xmin + i * m_step; }
+
+   // frames with a pixel >= t, pixels >= t; t to the nearest grid point
+   unsigned long frames_over(double t)	{ return over(m_max, m_max_cum, t); }
+   unsigned long pixels_over(double t)	{ return over(m_pix, m_pix_cum, t); }
+
+private:
+   int bin(double x) const;
+   unsigned long over(const std::vector<unsigned long> &h, std::vector<unsigned long> &cum, double t);
+
+   double	m_xmin, m_step;
+   int		m_nbins;
+   std::vector<unsigned long> m_max;	// [nbins+2], under/overflow as TH1
+   std::vector<unsigned long> m_pix;
+   std::vector<unsigned long> m_max_cum;	// sums of bins >= i, by over()
+   std::vector<unsigned long> m_pix_cum;
+   unsigned long m_frames, m_pixels;
+   unsigned long m_summed;		// frames when the sums were taken
+};
+
+#endif //~ fakescan_h
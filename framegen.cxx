@@ -0,0 +1,202 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * synthetic frame source standing in for the Xillybus FIFO.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "framegen.h"
+#include "Timer.h"	// timer_now_ns()
+#include "error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>	// nanosleep()
+
+//______________________________________________________________________
+framegen_t::framegen_t(double fps, double pedestal, double sigma)
+   : _fps(fps), _pedestal(pedestal), _sigma(sigma)
+   , _depth(32)			// 128 KiB
+   , _trig_ratio(0), _amp(200), _npixs(4)
+   , _cur(NULL), _frame(0), _pos(0), _t0(0)
+   , _lost(0), _lost_1s(0), _pulses(0), _wait_ns(0)
+   , _rng(0x9E3779B97F4A7C15ULL)
+{
+   _nbank	= NBANK;
+   _loaded	= false;
+   _bank	= (pixel_t*)malloc(NBANK * FRAMESIZE);
+   _frame_buf	= (pixel_t*)malloc(FRAMESIZE);
+   pixel_t *ptr = _bank;
+   for (int k=0; k < NBANK; k++) {
+      pixel_t fid = k & MASK_FID;
+      for (int ir=0; ir < NROWS; ir++) {
+	 for (int ic=0; ic < NCOLS; ic++) {
+	    double a = _pedestal + _sigma * gaus() + 0.5;
+	    pixel_t adc = a < 0 ? 0 : a > MASK_ADC ? MASK_ADC : (pixel_t)a;
+	    *ptr++ = ( ( (fid << NBITS_ROW | (ir+1) ) << NBITS_COL | ic ) << NBITS_ADC ) | adc;
+	 }
+      }
+   }
+   _rng0	= _rng;
+}
+
+framegen_t::~framegen_t()
+{
+   free(_bank);
+   free(_frame_buf);
+}
+
+// xorshift64*
+inline uint64_t framegen_t::rand64()
+{
+   _rng ^= _rng >> 12;
+   _rng ^= _rng << 25;
+   _rng ^= _rng >> 27;
+   return _rng * 0x2545F4914F6CDD1DULL;
+}
+
+// Box-Muller, one of the pair
+double framegen_t::gaus()
+{
+   double u1 = ( (rand64() >> 11) + 1.) / 9007199254740993.;	// (0, 1]
+   double u2 = (rand64() >> 11) / 9007199254740992.;
+   return sqrt(-2 * log(u1) ) * cos(2 * M_PI * u2);
+}
+
+// whole frames, a multiple of the frame id cycle to loop seamlessly
+//______________________________________________________________________
+int framegen_t::load(const char *fn, int nmax)
+{
+   FILE *fp = fopen(fn, "rb");		// stdio: no util.h, its LOG
+   if (! fp)	err_sys("fopen(\"%s\")", fn);
+   pixel_t *bank = (pixel_t*)malloc((size_t)nmax * FRAMESIZE);
+   int n = 0;
+   while (n < nmax && fread(bank + (size_t)n * NPIXS, FRAMESIZE, 1, fp) == 1)
+      n++;
+   fclose(fp);
+   n -= n % (MASK_FID + 1);
+   if (n <= 0) {
+      err_msg("%s: less than %d frames", fn, MASK_FID + 1);
+      free(bank);
+      return 0;
+   }
+   free(_bank);
+   _bank	= bank;
+   _nbank	= n;
+   _loaded	= true;
+   _cur		= NULL;
+   return n;
+}
+
+// pixels in stream order, as decode_frame()
+//______________________________________________________________________
+int framegen_t::get_noise(double *adc_mean, double *adc_sigma, double *cds_mean, double *cds_sigma)
+{
+   if (! _loaded || _nbank < 2)	return 0;
+   for (int i=0; i < NPIXS; i++) {
+      double sa = 0, saa = 0, sc = 0, scc = 0;
+      double last = _bank[i] & MASK_ADC;
+      sa  = last;
+      saa = last * last;
+      for (int k=1; k < _nbank; k++) {
+	 double a = _bank[(size_t)k * NPIXS + i] & MASK_ADC;
+	 double c = a - last;
+	 sa  += a;
+	 saa += a * a;
+	 sc  += c;
+	 scc += c * c;
+	 last = a;
+      }
+      adc_mean[i]  = sa / _nbank;
+      adc_sigma[i] = sqrt(fmax(saa / _nbank - adc_mean[i] * adc_mean[i], 0.) );
+      cds_mean[i]  = sc / (_nbank - 1);
+      cds_sigma[i] = sqrt(fmax(scc / (_nbank - 1) - cds_mean[i] * cds_mean[i], 0.) );
+   }
+   return _nbank;
+}
+
+void framegen_t::rewind()
+{
+   _cur		= NULL;
+   _frame	= 0;
+   _pos		= 0;
+   _t0		= 0;
+   _lost	= 0;
+   _lost_1s	= 0;
+   _pulses	= 0;
+   _wait_ns	= 0;
+   _rng		= _rng0;
+}
+
+double framegen_t::get_elapsed()
+{
+   if (! _t0)	return 0;
+   return (timer_now_ns() - _t0) * 1e-9;
+}
+
+// wait for frame _frame, drop frames overflowing the FIFO
+//______________________________________________________________________
+void framegen_t::next_frame(bool first)
+{
+   uint64_t now = timer_now_ns();
+   if (first)	_t0 = now;
+   else		_frame++;
+
+   if (_fps > 0) {
+      // frames produced by now
+      uint64_t produced = (uint64_t)( (now - _t0) * 1e-9 * _fps);
+      if (produced > _frame + _depth) {
+	 _lost  += produced - _depth - _frame;
+	 if (now - _t0 < 1000000000ULL)
+	    _lost_1s += produced - _depth - _frame;
+	 _frame  = produced - _depth;
+      }
+
+      // wait: sleep if long, spin the last 50 usec
+      uint64_t tready = _t0 + (uint64_t)(_frame * 1e9 / _fps);
+      if (now < tready) {
+	 _wait_ns += tready - now;
+	 if (tready - now > 100000) {
+	    uint64_t ns = tready - now - 50000;
+	    struct timespec ts = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+	    nanosleep(&ts, NULL);
+	 }
+	 while (timer_now_ns() < tready)
+	    ;
+      }
+   }
+
+   const pixel_t *src = _bank + (_frame % _nbank) * NPIXS;
+   _cur = (const unsigned char*)src;
+   if (_trig_ratio > 0 && (rand64() >> 11) < _trig_ratio * 9007199254740992.) {
+      memcpy(_frame_buf, src, FRAMESIZE);
+      for (int i=0; i < _npixs; i++) {
+	 pixel_t *p = _frame_buf + rand64() % NPIXS;
+	 pixel_t adc = *p & MASK_ADC;
+	 adc = adc > (pixel_t)_amp ? adc - _amp : 0;		// negative pulse
+	 *p = (*p & ~(pixel_t)MASK_ADC) | adc;
+      }
+      _cur = (const unsigned char*)_frame_buf;
+      _pulses++;
+   }
+   _pos = 0;
+}
+
+// as read_all() on the FIFO, never EOF
+//______________________________________________________________________
+ssize_t framegen_t::read(unsigned char *buf, size_t nbyte)
+{
+   size_t n = 0;
+   while (n < nbyte) {
+      if (! _cur || _pos == FRAMESIZE)
+	 next_frame(_cur == NULL);
+      size_t k = FRAMESIZE - _pos;
+      if (k > nbyte - n)	k = nbyte - n;
+      memcpy(buf + n, _cur + _pos, k);
+      _pos += k;
+      n += k;
+   }
+   return n;
+}
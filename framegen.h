@@ -0,0 +1,97 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * synthetic frame source standing in for the Xillybus FIFO.
+ *
+ * - frames as read from the FPGA: consecutive frame ids, rows 1..64,
+ *   ADC = pedestal + gaussian noise, taken from a pre-generated bank.
+ * - a pulse of <amp> ADC counts (negative) in <npixs> pixels of a
+ *   frame with probability <trig_ratio>, for CDS triggers.
+ * - paced at <fps>: frame i is produced at t0 + i/fps. A read waits
+ *   for the frame; a reader behind by more than <depth> frames loses
+ *   the overflowing frames as the hardware FIFO does.
+ * - a byte stream: read() of any size, as read_all() on the FIFO.
+ * - recorded frames (raw data file) replayed in a loop by load(); their
+ *   per-pixel noise by get_noise().
+ * - rewind(): the same frames and pulses again, e.g. per benchmark point.
+ * - fps <= 0: not paced, as fast as read.
+ *
+ * usage:
+ *   framegen_t src(fps);
+ *   src.read(buf, FRAMESIZE);
+ *   ...
+ *   src.get_lost();
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef framegen_h
+#define framegen_h
+
+#include "mydefs.h"	// NPIXS, FRAMESIZE, pixel_t
+
+#include <stdint.h>
+
+//______________________________________________________________________
+typedef struct framegen_t
+{
+   enum { NBANK = 256 };	// frames pre-generated, multiple of fid cycle
+
+   framegen_t(double fps=10000, double pedestal=8000, double sigma=5);
+   ~framegen_t();
+
+   void set_depth(int n)		{ _depth = n; }		// FIFO frames
+   // replace the bank by up to nmax frames of a raw data file, return frames loaded
+   int load(const char *fn, int nmax=4096);
+   // per pixel [NPIXS] of the loaded frames, CDS of consecutive ones; return frames, 0 if none
+   int get_noise(double *adc_mean, double *adc_sigma, double *cds_mean, double *cds_sigma);
+   // back to the first frame, RNG as after construction
+   void rewind();
+   // pulses of amp ADC counts in npixs pixels, trig_ratio per frame
+   void set_pulse(double trig_ratio, int amp=200, int npixs=4)
+   { _trig_ratio = trig_ratio; _amp = amp; _npixs = npixs; }
+
+   ssize_t read(unsigned char *buf, size_t nbyte);
+
+   double get_pedestal()	{ return _pedestal; }
+   double get_sigma()		{ return _sigma; }		// ADC noise, synthetic
+   int get_nbank()		{ return _nbank; }		// frames replayed in a loop
+   double get_fps()		{ return _fps; }
+   uint64_t get_produced()	{ return _frame; }	// frames passed to reader, incl. lost
+   uint64_t get_lost()		{ return _lost; }
+   uint64_t get_lost_1s()	{ return _lost_1s; }	// in the first second
+   uint64_t get_pulses()	{ return _pulses; }
+   double get_elapsed();	// sec since the first read
+   double get_wait()		{ return _wait_ns * 1e-9; }	// sec waiting for frames
+
+private:
+   double	_fps;
+   double	_pedestal;
+   double	_sigma;
+   int		_depth;
+   double	_trig_ratio;
+   int		_amp;
+   int		_npixs;
+
+   pixel_t *	_bank;
+   int		_nbank;		// frames in bank
+   bool		_loaded;	// bank of load()
+   pixel_t *	_frame_buf;	// current frame with a pulse
+   const unsigned char * _cur;	// current frame
+   uint64_t	_frame;		// current frame index
+   size_t	_pos;		// bytes of current frame read
+   uint64_t	_t0;		// nsec, first read
+   uint64_t	_lost;
+   uint64_t	_lost_1s;
+   uint64_t	_pulses;
+   uint64_t	_wait_ns;
+   uint64_t	_rng;
+   uint64_t	_rng0;		// after the bank generated
+
+   uint64_t rand64();
+   double gaus();
+   void next_frame(bool first);
+}
+   framegen_t
+   ;
+
+#endif //~ framegen_h
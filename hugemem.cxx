@@ -0,0 +1,179 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * large buffers on huge pages, locked and prefaulted.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "hugemem.h"
+#include "error.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <vector>
+
+#define HUGE_SIZE	(2UL << 20)
+#define PAGE_SIZE_	4096UL
+
+enum mem_how_t { HOW_MALLOC, HOW_PAGES, HOW_THP, HOW_HUGETLB };
+static const char *how_name[] = { "malloc", "4k", "thp", "hugetlb" };
+
+typedef struct mem_block_t
+{
+   mem_block_t() : ptr(NULL), size(0), how(HOW_MALLOC), locked(false), prefaulted(false) {}
+
+   void *	ptr;
+   size_t	size;		// mapped
+   int		how;		// mem_how_t
+   bool		locked;
+   bool		prefaulted;
+}
+   mem_block_t
+   ;
+
+// blocks of mem_alloc() with flags, a few per run
+static std::vector<mem_block_t>	g_blocks;
+static pthread_mutex_t		g_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t round_up(size_t n, size_t a)
+{
+   return (n + a - 1) / a * a;
+}
+
+//______________________________________________________________________
+int mem_parse(const char *s)
+{
+   int flags = 0;
+   for (; s && *s; s++) {
+      switch (*s) {
+      case 'h':	flags |= MEM_HUGE;	break;
+      case 'l':	flags |= MEM_LOCK;	break;
+      case 'p':	flags |= MEM_PREFAULT;	break;
+      default:	return -1;
+      }
+   }
+   return flags;
+}
+
+std::string mem_flags_sprint(int flags)
+{
+   std::string s;
+   if (flags & MEM_HUGE)	s += 'h';
+   if (flags & MEM_LOCK)	s += 'l';
+   if (flags & MEM_PREFAULT)	s += 'p';
+   return s.size() ? s : "-";
+}
+
+// anonymous mapping of n bytes aligned to a huge page, for THP
+static void * map_aligned(size_t n)
+{
+   size_t len = n + HUGE_SIZE;
+   void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED)	return NULL;
+   uintptr_t a = (uintptr_t)p;
+   uintptr_t b = round_up(a, HUGE_SIZE);
+   if (b > a)			munmap(p, b - a);
+   if (b + n < a + len)		munmap( (void*)(b + n), a + len - b - n);
+   return (void*)b;
+}
+
+//______________________________________________________________________
+void * mem_alloc(size_t n, int flags)
+{
+   if (! flags)	return malloc(n);
+
+   mem_block_t m;
+
+   if (flags & MEM_HUGE) {
+      m.size = round_up(n, HUGE_SIZE);
+      m.ptr  = mmap(NULL, m.size, PROT_READ | PROT_WRITE
+		    , MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (m.ptr != MAP_FAILED)
+	 m.how = HOW_HUGETLB;
+      else if ( (m.ptr = map_aligned(m.size)) ) {
+	 m.how = HOW_PAGES;
+#ifdef MADV_HUGEPAGE
+	 if (madvise(m.ptr, m.size, MADV_HUGEPAGE) == 0)
+	    m.how = HOW_THP;
+#endif
+	 if (m.how != HOW_THP)
+	    err_msg("mem_alloc: %lu MiB: no huge pages, 4k pages", (unsigned long)(m.size >> 20) );
+      }
+   }
+   if (! m.ptr) {
+      m.size = round_up(n, PAGE_SIZE_);
+      m.ptr  = mmap(NULL, m.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (m.ptr == MAP_FAILED)	m.ptr = NULL;
+      else			m.how = HOW_PAGES;
+   }
+   if (! m.ptr) {
+      m.ptr  = malloc(n);
+      m.size = n;
+      m.how  = HOW_MALLOC;
+      if (! m.ptr)	return NULL;
+   }
+
+   if (flags & MEM_LOCK) {
+      if (mlock(m.ptr, m.size) == 0)
+	 m.locked = true;
+      else
+	 err_ret("mem_alloc: mlock %lu MiB, not locked (ulimit -l?)", (unsigned long)(m.size >> 20) );
+   }
+   // locked pages are resident already
+   if (flags & MEM_PREFAULT && ! m.locked) {
+      volatile unsigned char *p = (volatile unsigned char*)m.ptr;
+      for (size_t i=0; i < m.size; i += PAGE_SIZE_)
+	 p[i] = 0;
+   }
+   m.prefaulted = (flags & MEM_PREFAULT) || m.locked;
+
+   pthread_mutex_lock(&g_mutex);
+   g_blocks.push_back(m);
+   pthread_mutex_unlock(&g_mutex);
+   return m.ptr;
+}
+
+//______________________________________________________________________
+void mem_free(void *p)
+{
+   if (! p)	return;
+   mem_block_t m;
+   pthread_mutex_lock(&g_mutex);
+   for (size_t i=0; i < g_blocks.size(); i++) {
+      if (g_blocks[i].ptr == p) {
+	 m = g_blocks[i];
+	 g_blocks.erase(g_blocks.begin() + i);
+	 break;
+      }
+   }
+   pthread_mutex_unlock(&g_mutex);
+
+   if (! m.ptr || m.how == HOW_MALLOC) {
+      if (m.locked)	munlock(p, m.size);
+      free(p);
+   }
+   else
+      munmap(p, m.size);	// unlocked too
+}
+
+//______________________________________________________________________
+std::string mem_sprint(const void *p)
+{
+   mem_block_t m;
+   pthread_mutex_lock(&g_mutex);
+   for (size_t i=0; i < g_blocks.size(); i++)
+      if (g_blocks[i].ptr == p)	m = g_blocks[i];
+   pthread_mutex_unlock(&g_mutex);
+
+   if (! m.ptr)	return "malloc";
+   char buf[128];
+   snprintf(buf, sizeof(buf), "%.1f MiB %s%s%s", m.size / 1048576., how_name[m.how]
+	    , m.locked ? " locked" : "", m.prefaulted ? " prefaulted" : "");
+   return buf;
+}
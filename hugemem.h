@@ -0,0 +1,40 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * large buffers on huge pages, locked and prefaulted.
+ *
+ * - MEM_HUGE: 2 MiB pages of hugetlbfs (MAP_HUGETLB) if reserved, e.g.
+ *     echo 64 > /proc/sys/vm/nr_hugepages
+ *   else 2 MiB aligned and madvise(MADV_HUGEPAGE) for THP.
+ * - MEM_LOCK: mlock(), needs RLIMIT_MEMLOCK (ulimit -l) or CAP_IPC_LOCK.
+ * - MEM_PREFAULT: every page touched, no fault when the run starts.
+ * - each step falls back with a warning; no flags = malloc().
+ *
+ * usage:
+ *   void *p = mem_alloc(n, MEM_HUGE | MEM_LOCK | MEM_PREFAULT);
+ *   LOG << mem_sprint(p) << endl;
+ *   mem_free(p);
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef hugemem_h
+#define hugemem_h
+
+#include <stddef.h>	// size_t
+
+#include <string>
+
+enum mem_flags_t { MEM_HUGE = 1, MEM_LOCK = 2, MEM_PREFAULT = 4 };
+
+// letters of flags, e.g. "hlp" = huge, lock, prefault; return flags, -1 on error
+int mem_parse(const char *s);
+// letters of flags, "-" if none
+std::string mem_flags_sprint(int flags);
+// n bytes by flags, NULL on failure
+void * mem_alloc(size_t n, int flags);
+// p of mem_alloc()
+void mem_free(void *p);
+// how p was allocated, e.g. "40 MiB hugetlb locked prefaulted"
+std::string mem_sprint(const void *p);
+
+#endif //~ hugemem_h
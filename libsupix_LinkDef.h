@@ -20,4 +20,7 @@
 #pragma link C++ class RunInfo+;
 #pragma link C++ class SupixTree;
 #pragma link C++ class SupixAnly;
+#pragma link C++ class SupixIndex;
+#pragma link C++ struct idx_entry_t;
+#pragma link C++ struct idx_cut_t;
 #endif
@@ -72,6 +72,17 @@ enum trig_types_t
     TRIG_TYPES	= 2		// real trigger Ntypes
    };
 
+// load-shedding levels, cumulative
+enum shed_levels_t
+   {
+    SHED_NONE	= 0,
+    SHED_PERIOD,		// drop periodic triggers
+    SHED_ZS,			// zero-suppressed ROOT output
+    SHED_POST,			// shortened post-trigger window
+    SHED_NOROOT,		// skip ROOT output if raw written
+    SHED_LEVELS
+   };
+
 
 //======================================================================
 //
@@ -0,0 +1,161 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * hardware performance counters of the calling thread.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "perfcnt.h"
+#include "error.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>	// clock_gettime()
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+static int perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd, unsigned long flags)
+{
+   return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+#endif
+
+int perf_paranoid()
+{
+   int x = -99;
+   FILE *fp = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+   if (fp) {
+      if (fscanf(fp, "%d", &x) != 1)	x = -99;
+      fclose(fp);
+   }
+   return x;
+}
+
+//______________________________________________________________________
+perf_group_t::perf_group_t()
+   : m_fd_leader(-1), m_nopen(0), m_read_ns(0)
+{
+   for (int k=0; k < PERF_NCOUNTERS; k++) {
+      m_fd[k]  = -1;
+      m_idx[k] = -1;
+   }
+}
+
+// open the group for the calling thread on any cpu.
+// - the first counter opened is the leader
+//______________________________________________________________________
+int perf_group_t::open()
+{
+#ifdef __linux__
+   static const struct { uint32_t type; uint64_t config; const char *name; } events[PERF_NCOUNTERS] =
+      {
+       { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,		"cycles" }
+       , { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,	"instructions" }
+       , { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,	"LLC-misses" }
+       , { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,	"branch-misses" }
+       , { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES,	"context-switches" }
+      };
+
+   close();
+   int err = 0;
+   for (int k=0; k < PERF_NCOUNTERS; k++) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr) );
+      attr.size		  = sizeof(attr);
+      attr.type		  = events[k].type;
+      attr.config	  = events[k].config;
+      attr.disabled	  = m_fd_leader < 0;	// leader starts the group
+      // context switches happen in the kernel: counted with it, which
+      // needs paranoid <= 1; the hardware ones user space only (<= 2)
+      attr.exclude_kernel = events[k].type != PERF_TYPE_SOFTWARE;
+      attr.exclude_hv	  = 1;
+      attr.read_format	  = PERF_FORMAT_GROUP;
+      int fd = perf_event_open(&attr, 0, -1, m_fd_leader, 0);
+      if (fd < 0) {
+	 err = errno;
+	 err_msg("perf_event_open(%s): %s", events[k].name, strerror(err) );
+	 continue;
+      }
+      if (m_fd_leader < 0)	m_fd_leader = fd;
+      m_fd[k]  = fd;
+      m_idx[k] = m_nopen++;
+   }
+
+   if (m_fd_leader < 0) {
+      err_msg("no performance counters, perf_event_paranoid = %d%s", perf_paranoid(),
+	      err == EACCES || err == EPERM ? " (try <= 2 or CAP_PERFMON)" : "");
+      return 0;
+   }
+   ioctl(m_fd_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+   ioctl(m_fd_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+   return m_nopen;
+#else
+   err_msg("performance counters not supported on this platform");
+   return 0;
+#endif
+}
+
+void perf_group_t::close()
+{
+   for (int k=0; k < PERF_NCOUNTERS; k++) {
+      if (m_fd[k] >= 0)	::close(m_fd[k]);
+      m_fd[k]  = -1;
+      m_idx[k] = -1;
+   }
+   m_fd_leader = -1;
+   m_nopen = 0;
+}
+
+bool perf_group_t::read(uint64_t v[PERF_NCOUNTERS])
+{
+   if (m_fd_leader < 0)	return false;
+
+   uint64_t buf[1 + PERF_NCOUNTERS];	// nr, values...
+   struct timespec t0, t1;		// as timer_now_ns()
+   clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+   ssize_t nb = ::read(m_fd_leader, buf, sizeof(buf) );
+   clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+   m_read_ns += (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec);
+   if (nb < (ssize_t)sizeof(uint64_t) * (1 + m_nopen) )	return false;
+   for (int k=0; k < PERF_NCOUNTERS; k++)
+      v[k] = m_idx[k] >= 0 ? buf[1 + m_idx[k]] : 0;
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void perf_stage_t::reset()
+{
+   m_on = false;
+   m_n	= 0;
+   for (int k=0; k < PERF_NCOUNTERS; k++) {
+      m_v0[k]  = 0;
+      m_sum[k] = 0;
+   }
+}
+
+void perf_stage_t::print(const char *name)
+{
+   if (! group || m_n == 0)	return;
+   char str[1000];
+   int nc = sprintf(str, "\t%16s : ", name);
+   if (group->has(PERF_CYCLES) && group->has(PERF_INSTRUCTIONS) )
+      nc += sprintf(str+nc, "IPC %5.2f ", get_ipc() );
+   else
+      nc += sprintf(str+nc, "IPC     - ");
+   nc += sprintf(str+nc, "cycles %10.0f ", get_per_n(PERF_CYCLES) );
+   nc += sprintf(str+nc, "LLC-miss %8.2f ", get_per_n(PERF_LLC_MISSES) );
+   nc += sprintf(str+nc, "br-miss %8.2f ", get_per_n(PERF_BRANCH_MISSES) );
+   if (group->has(PERF_CSWITCHES) )
+      nc += sprintf(str+nc, "cs %8.4f ", get_per_n(PERF_CSWITCHES) );
+   else
+      nc += sprintf(str+nc, "cs        - ");
+   sprintf(str+nc, "per frame \tx %lu\n", m_n);
+   fputs(str, stdout);
+}
@@ -0,0 +1,106 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * hardware performance counters of the calling thread (perf_event_open).
+ *
+ * - one group per thread: cycles, instructions, LLC misses, branch
+ *   misses and context switches, read with one read(2).
+ * - hardware counters user space only (exclude_kernel), unprivileged up
+ *   to perf_event_paranoid = 2; context switches are kernel events and
+ *   need <= 1.  Counters that cannot be opened are skipped, printed "-";
+ *   an empty group reads nothing.
+ * - time spent in read() is kept per group: a Timer with a stage takes
+ *   the reads of the stages nested in it out of its own time.
+ *
+ * usage:
+ *   perf_group_t group;			// per thread
+ *   perf_stage_t stage(&group);		// per code region
+ *   group.open();				// in the counted thread
+ *   stage.begin(); ... stage.end();
+ *   stage.print("name");
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef perfcnt_h
+#define perfcnt_h
+
+#include <stdint.h>
+
+enum perf_counters_t
+   {
+    PERF_CYCLES, PERF_INSTRUCTIONS, PERF_LLC_MISSES, PERF_BRANCH_MISSES
+    , PERF_CSWITCHES
+    , PERF_NCOUNTERS
+   };
+
+//
+// counters of the calling thread
+//______________________________________________________________________
+class perf_group_t
+{
+public:
+   perf_group_t();
+   ~perf_group_t()	{ close(); }
+
+   int open();			// in the counted thread, return counters opened
+   void close();
+   bool is_open()		{ return m_fd_leader >= 0; }
+   bool has(int k)		{ return m_idx[k] >= 0; }
+
+   // current values, missing counters = 0
+   bool read(uint64_t v[PERF_NCOUNTERS]);
+   // nsec spent in read() so far, taken out of enclosing timers
+   uint64_t get_read_ns()	{ return m_read_ns; }
+
+private:
+   int	m_fd_leader;
+   int	m_fd[PERF_NCOUNTERS];
+   int	m_idx[PERF_NCOUNTERS];	// position in group read, -1 = missing
+   int	m_nopen;
+   uint64_t	m_read_ns;
+};
+
+//
+// counter deltas accumulated over a code region
+//______________________________________________________________________
+typedef struct perf_stage_t
+{
+   perf_stage_t(perf_group_t *g=0)	{ group = g; reset(); }
+
+   void reset();
+   void begin()
+   {
+      if (group)	m_on = group->read(m_v0);
+   }
+   void end(int mm=1)		// mm: number of repeated samples
+   {
+      uint64_t v[PERF_NCOUNTERS];
+      if (! m_on || ! group->read(v) )	return;
+      for (int k=0; k < PERF_NCOUNTERS; k++)
+	 m_sum[k] += v[k] - m_v0[k];
+      m_n += mm;
+      m_on = false;
+   }
+
+   unsigned long get_n()	{ return m_n; }
+   uint64_t get_sum(int k)	{ return m_sum[k]; }
+   double get_ipc()
+   { return m_sum[PERF_CYCLES] ? (double)m_sum[PERF_INSTRUCTIONS] / m_sum[PERF_CYCLES] : 0; }
+   double get_per_n(int k)	{ return m_n ? (double)m_sum[k] / m_n : 0; }
+   uint64_t get_read_ns()	{ return group ? group->get_read_ns() : 0; }
+
+   void print(const char *name);	// IPC and counts per sample
+
+   perf_group_t *	group;		// of the owner thread
+private:
+   bool		m_on;
+   unsigned long	m_n;
+   uint64_t	m_v0[PERF_NCOUNTERS];
+   uint64_t	m_sum[PERF_NCOUNTERS];
+}
+   perf_stage_t
+   ;
+
+int perf_paranoid();		// /proc/sys/kernel/perf_event_paranoid, -99 = unknown
+
+#endif //~ perfcnt_h
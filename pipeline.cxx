@@ -10,6 +10,7 @@
  ***********************************************************************/
 #include "pipeline.h"
 
+#include <errno.h>	// ENOMEM
 #include <limits.h>
 #include <math.h>
 #include <sys/time.h>
@@ -31,12 +32,16 @@ void pipeline_t::initialize()
       exit(err);
    }
    // buffer
-   buffer = (unsigned char*)malloc(_max_ * _framesize);
+   buffer = (unsigned char*)mem_alloc( (size_t)_max_ * _framesize, _memfl);
+   if (! buffer) {
+      std::cout << "pipeline_t: no memory of " << _max_ << " frames" << std::endl;
+      exit(ENOMEM);
+   }
 }
 
 void pipeline_t::finalize()
 {
-   if (buffer != NULL)		free(buffer);
+   if (buffer != NULL)		mem_free(buffer);
 
    int err = pthread_rwlock_destroy(&rwlock);
    if (err != 0) {
@@ -63,8 +68,10 @@ void pipeline_t::print(const char *msg)
    std::ostringstream oss;
    oss << "\t" << sprint(msg)
        << " max=" << _max_
+       << " limit=" << _limit
        << " framesize=" << _framesize
        << " buffer=" << (void*)buffer
+       << " mem=" << mem_sprint(buffer)
        << std::endl;
    fputs(oss.str().c_str(), stdout);
 }
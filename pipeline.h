@@ -10,6 +10,7 @@
 #ifndef pipeline_h
 #define pipeline_h
 #include "error.h"
+#include "hugemem.h"	// mem_alloc()
 
 #include <stdio.h>
 #include <stdlib.h>	// malloc(), free()
@@ -28,11 +29,12 @@ enum OUT_MODE_t { O_T0P0, O_T1P0, O_T0P1, O_T1P1, O_NOISE };
 //______________________________________________________________________
 typedef struct pipeline_t
 {
-   pipeline_t(int fs=4096, int mx=1000, int prmx=0, int pomx=0)
+   pipeline_t(int fs=4096, int mx=1000, int prmx=0, int pomx=0, int memfl=0)
       : _framesize(fs)
-      , _max_(mx), _pre_max(prmx), _post_max(pomx)
+      , _max_(mx), _pre_max(prmx), _post_max(pomx), _memfl(memfl)
    {
       if  (_max_ <= _pre_max)	_max_ = 1 + _pre_max;
+      _limit = _max_;
       _in = _out = _saved = _pre = _post = 0;
       _first = -1;
       initialize();
@@ -42,6 +44,7 @@ typedef struct pipeline_t
    {  finalize();  }
 
    bool is_full();		// RD: is pipeline full?
+   double occupancy();		// RD/WR: fraction of frames in use
    bool next_in(bool);		// RD: update for next in frame
    
    bool is_new();		// WR: is new data available?
@@ -52,6 +55,10 @@ typedef struct pipeline_t
    int get_pre()		// WR: return number of pre-frames
    { return _pre; }
    void next_out(OUT_MODE_t x=O_NOISE);	// WR: update next out according to mode
+   void set_post_max(int n);		// WR: post-frames of following triggers
+   void set_limit(int n);		// RD/WR: frames in use <= n <= capacity
+   int get_limit()		{ return _limit; }
+   int get_capacity()		{ return _max_; }
 
    unsigned char * get_in_ptr();	// RD: get pointer to in-index
    unsigned char * get_out_ptr();	// WR: get pointer to out-index
@@ -71,9 +78,11 @@ private:
    int	_post;
    int	_first;		// -1 = non-first, non-negative = first-frame
    int	_framesize;	// bytes per frame
-   int	_max_;
+   int	_max_;		// capacity, allocated
+   int	_limit;		// max frames in use
    int	_pre_max;
    int	_post_max;
+   int	_memfl;		// mem_flags_t of buffer
    pthread_rwlock_t rwlock;	// for threads communcation
    unsigned char* buffer;	// head of pipeline
    
@@ -90,7 +99,7 @@ inline bool pipeline_t::is_full()
 {
    //#ifdef LOCKALL
    pthread_rwlock_rdlock(&rwlock);
-   bool yes = _saved + _pre == _max_;
+   bool yes = _saved + _pre >= _limit;
    pthread_rwlock_unlock(&rwlock);
    return yes;
 // #else
@@ -98,6 +107,15 @@ inline bool pipeline_t::is_full()
 // #endif
 }
 
+// frames held (saved + pre) over the current limit, set_limit() not capacity
+inline double pipeline_t::occupancy()
+{
+   pthread_rwlock_rdlock(&rwlock);
+   double x = (double)(_saved + _pre) / _limit;
+   pthread_rwlock_unlock(&rwlock);
+   return x;
+}
+
 // NO need to lock
 //   WR: true to write, false to wait
 //   RD: true -> true, false -> true
@@ -198,6 +216,24 @@ inline void pipeline_t::next_out(OUT_MODE_t mode)
    pthread_rwlock_unlock(&rwlock);
 }
 
+// takes effect from the next trigger
+inline void pipeline_t::set_post_max(int n)
+{
+   pthread_rwlock_wrlock(&rwlock);
+   _post_max = n;
+   pthread_rwlock_unlock(&rwlock);
+}
+
+// a lower limit takes effect when frames in use drop below it
+inline void pipeline_t::set_limit(int n)
+{
+   if (n > _max_)		n = _max_;
+   if (n <= _pre_max)		n = 1 + _pre_max;
+   pthread_rwlock_wrlock(&rwlock);
+   _limit = n;
+   pthread_rwlock_unlock(&rwlock);
+}
+
 //----------------------------------------------------------------------
 
 inline unsigned char * pipeline_t::get_in_ptr()	// pointer to next position
@@ -235,23 +271,23 @@ inline unsigned char * pipeline_t::get_pre_ptr(int n)
 ////////////////////////////////////////////////////////////////////////
 
 // a stack-like buffer for saving objects.
-//   ostack_t(osize, depth_max)
+//   ostack_t(osize, depth_max[, mem_flags_t])
 //______________________________________________________________________
 typedef struct ostack_t {
    // constructor
-   ostack_t(int os, int n)
+   ostack_t(int os, int n, int memfl=0)
       : osize(os)	// object size in byte
       , depth_max(n)	// max number of objects
    {
       depth	= 0;	// #objects saved in buffer
-      top = (unsigned char*)malloc(depth_max * osize);
+      top = (unsigned char*)mem_alloc(depth_max * osize, memfl);
       tmp = (unsigned char*)malloc(osize);
    }
 
    // destructor
    ~ostack_t()
    {
-      free(top);
+      mem_free(top);
       free(tmp);
    }
 
@@ -0,0 +1,307 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * discrete-event simulation of the DAQ pipeline.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "pipesim.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+
+void psim_dist_t::set_const(double usec)
+{
+   clear();
+   add_bucket(usec, 1);
+}
+
+void psim_dist_t::set_hist(LatencyHist &h)
+{
+   clear();
+   for (int i=0; i < LatencyHist::NBUCKETS; i++) {
+      uint64_t n = h.get_count(i);
+      if (n == 0)	continue;
+      double x = LatencyHist::lower(i) + 0.5 * (LatencyHist::width(i) - 1);
+      add_bucket(x / 1000., n);		// nsec -> usec
+   }
+}
+
+void psim_dist_t::scale(double f)
+{
+   for (size_t i=0; i < m_x.size(); i++)
+      m_x[i] *= f;
+   m_mean *= f;
+}
+
+void psim_dist_t::add_bucket(double usec, uint64_t count)
+{
+   if (count == 0)	return;
+   uint64_t sum = m_cum.empty() ? 0 : m_cum.back();
+   m_mean = (m_mean * sum + usec * count) / (sum + count);
+   m_x.push_back(usec);
+   m_cum.push_back(sum + count);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// times in usec
+//______________________________________________________________________
+pipesim_result_t pipesim_t::run(const pipesim_config_t &cfg, unsigned long nframes, uint64_t seed)
+{
+   unsigned long long tcpu = timer_now_ns();
+   pipesim_result_t r;
+   memset(&r, 0, sizeof(r) );
+
+   psim_rng_t rng(seed);
+   int pre  = cfg.pre_trigs;
+   int post = cfg.post_trigs;
+   int cap  = cfg.pipeline_max - pre;		// frames waiting for the writer
+   if (cap < 1)	cap = 1;
+
+   // finish times of frames in pipeline, FIFO order
+   std::vector<double> fin(cap);
+   int qhead = 0, qn = 0;
+
+   // bursts: 2-state Markov chain, mean trig_ratio kept
+   bool burst = false;
+   double p_in	= 0, p_out = 0;
+   double p_base = cfg.trig_ratio;
+   if (cfg.burst_frac > 0 && cfg.burst_frac < 1 && cfg.burst_factor != 1) {
+      p_out  = 1. / cfg.burst_len;
+      p_in   = cfg.burst_frac / (1 - cfg.burst_frac) / cfg.burst_len;
+      p_base = cfg.trig_ratio / (1 - cfg.burst_frac + cfg.burst_frac * cfg.burst_factor);
+   }
+
+   unsigned long window = cfg.window;
+   if (window == 0) {		// 1 sec of frames
+      double t = m_dist[PSIM_READ].get_mean();
+      window = t > 0 ? 1e6 / t : 1;
+   }
+   if (window == 0)	window = 1;
+
+   double t_arr	 = 0;		// arrival of this frame
+   double t_free = 0;		// writer free
+   int post_left = 0;
+   unsigned long nrotate = 0;
+   bool win_lost = false;
+   double occ_sum = 0;
+   for (unsigned long i=0; i < nframes; i++) {
+      t_arr += m_dist[PSIM_READ].sample(rng);
+      r.frames++;
+
+      // frames written out meanwhile
+      while (qn && fin[qhead] <= t_arr) {
+	 qhead = (qhead + 1) % cap;
+	 qn--;
+      }
+      double occ = (double)(qn + pre) / cfg.pipeline_max;
+      occ_sum += occ;
+      if (occ > r.occ_max)	r.occ_max = occ;
+
+      if (qn >= cap) {		// full
+	 r.lost++;
+	 win_lost = true;
+      }
+      else {
+	 // trigger
+	 if (p_in > 0) {
+	    if (burst) { if (rng.uniform() < p_out)	burst = false; }
+	    else       { if (rng.uniform() < p_in)	burst = true;  }
+	 }
+	 double p = burst ? p_base * cfg.burst_factor : p_base;
+	 bool trig = (cfg.trig_period > 0 && r.frames % cfg.trig_period == 0)
+	    || (p > 0 && rng.uniform() < p);
+
+	 // writer cost
+	 double cost = m_dist[PSIM_COMM].sample(rng);
+	 for (size_t k=0; k < m_comm.size(); k++)
+	    cost += m_comm[k].sample(rng);
+	 int nwrite = 0;
+	 if (post_left > 0) {		// as pipeline_t::next_out()
+	    nwrite = 1;
+	    if (trig)	r.triggers++;	// O_T1P1: window held, not restarted
+	    else	post_left--;	// O_T0P1
+	 }
+	 else if (trig) {
+	    nwrite = pre + 1;
+	    post_left = post;
+	    r.triggers++;
+	 }
+	 if (nwrite) {
+	    for (int k=0; k < nwrite; k++)
+	       cost += m_dist[PSIM_WRITE].sample(rng);
+	    r.recorded += nwrite;
+	    nrotate += nwrite;
+	    if (cfg.rotate_frames && nrotate >= cfg.rotate_frames) {
+	       cost += m_dist[PSIM_ROTATE].sample(rng);
+	       nrotate = 0;
+	    }
+	 }
+	 else
+	    cost += m_dist[PSIM_SKIP].sample(rng);
+
+	 double start = t_arr > t_free ? t_arr : t_free;
+	 t_free = start + cost;
+	 fin[(qhead + qn) % cap] = t_free;
+	 qn++;
+      }
+
+      if (r.frames % window == 0) {
+	 r.windows++;
+	 if (win_lost)	r.windows_lost++;
+	 win_lost = false;
+      }
+   }
+
+   if (r.frames) {
+      r.deadtime = (double)r.lost / r.frames;
+      r.occ_mean = occ_sum / r.frames;
+   }
+   if (r.windows)
+      r.p_overflow = (double)r.windows_lost / r.windows;
+   else				// shorter than a window
+      r.p_overflow = r.lost ? 1 : 0;
+   r.sim_sec = t_arr / 1e6;
+   r.cpu_sec = (timer_now_ns() - tcpu) / 1e9;
+   return r;
+}
+
+// exponential search, then bisection; the same seed for all lengths
+//______________________________________________________________________
+int pipesim_t::recommend(pipesim_config_t cfg, double p_max, int Lmax, unsigned long nframes)
+{
+   if (m_dist[PSIM_READ].empty() )	return -1;
+   if (nframes == 0) {			// 100 windows
+      double t = m_dist[PSIM_READ].get_mean();
+      nframes = (t > 0 ? 1e8 / t : 1000000);
+      if (cfg.window)	nframes = cfg.window * 100;
+   }
+
+   int lo = cfg.pre_trigs + cfg.post_trigs + 2;
+   cfg.pipeline_max = lo;
+   if (run(cfg, nframes).p_overflow <= p_max)	return lo;
+
+   int hi = lo;
+   while (1) {
+      lo = hi;
+      hi *= 2;
+      if (hi > Lmax)	hi = Lmax;
+      cfg.pipeline_max = hi;
+      if (run(cfg, nframes).p_overflow <= p_max)	break;
+      if (hi == Lmax)	return -1;
+   }
+   while (hi - lo > 1) {	// lo fails, hi passes
+      int mid = (lo + hi) / 2;
+      cfg.pipeline_max = mid;
+      if (run(cfg, nframes).p_overflow <= p_max)	hi = mid;
+      else						lo = mid;
+   }
+   return hi;
+}
+
+std::string pipesim_t::sprint(const pipesim_result_t &r)
+{
+   std::ostringstream oss;
+   oss << "frames=" << r.frames
+       << " lost=" << r.lost
+       << " recorded=" << r.recorded
+       << " trigs=" << r.triggers
+       << " deadtime=" << r.deadtime
+       << " P(overflow)=" << r.p_overflow << " (" << r.windows_lost << "/" << r.windows << " windows)"
+       << " occupancy=" << r.occ_mean << "/" << r.occ_max << " (mean/max)"
+       << " simulated " << r.sim_sec << " sec in " << r.cpu_sec << " sec"
+      ;
+   return oss.str();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+timing_file_t::~timing_file_t()
+{
+   for (size_t i=0; i < hists.size(); i++)
+      delete hists[i];
+}
+
+double timing_file_t::get_param(const char *key, double def)
+{
+   for (size_t i=0; i < keys.size(); i++)
+      if (keys[i] == key)	return values[i];
+   return def;
+}
+
+LatencyHist * timing_file_t::get_hist(const char *name)
+{
+   std::string s = name;
+   for (size_t i=0; i < s.size(); i++)
+      if (s[i] == ' ')	s[i] = '_';
+   for (size_t i=0; i < names.size(); i++)
+      if (names[i] == s)	return hists[i];
+   return NULL;
+}
+
+// format:
+//   param KEY VALUE
+//   timer NAME IDX:COUNT ...
+//______________________________________________________________________
+int timing_file_t::save(const char *fn, Timer **timers, const char **tnames, int ntimers)
+{
+   FILE *fp = fopen(fn, "w");
+   if (! fp) {
+      err_ret("timing_file_t::save: fopen(\"%s\")", fn);
+      return -1;
+   }
+   fprintf(fp, "# supix timing, nsec histograms of LatencyHist\n");
+   for (size_t i=0; i < keys.size(); i++)
+      fprintf(fp, "param %s %.9g\n", keys[i].c_str(), values[i]);
+   for (int i=0; i < ntimers; i++) {
+      std::string s = tnames[i];
+      for (size_t k=0; k < s.size(); k++)
+	 if (s[k] == ' ')	s[k] = '_';
+      fprintf(fp, "timer %s", s.c_str() );
+      LatencyHist &h = timers[i]->get_hist();
+      for (int k=0; k < LatencyHist::NBUCKETS; k++)
+	 if (h.get_count(k) )	fprintf(fp, " %d:%lu", k, h.get_count(k) );
+      fputc('\n', fp);
+   }
+   fclose(fp);
+   return ntimers;
+}
+
+int timing_file_t::load(const char *fn)
+{
+   FILE *fp = fopen(fn, "r");
+   if (! fp)	return -1;
+
+   char line[1 << 16];
+   int ntimers = 0;
+   while (fgets(line, sizeof(line), fp) ) {
+      std::istringstream iss(line);
+      std::string tag, name;
+      iss >> tag >> name;
+      if (tag == "param") {
+	 double x = 0;
+	 iss >> x;
+	 add_param(name.c_str(), x);
+      }
+      else if (tag == "timer") {
+	 LatencyHist *h = new LatencyHist;
+	 std::string tok;
+	 while (iss >> tok) {
+	    int k;
+	    unsigned long n;
+	    if (sscanf(tok.c_str(), "%d:%lu", &k, &n) == 2 && k >= 0 && k < LatencyHist::NBUCKETS)
+	       h->add(LatencyHist::lower(k), n);
+	 }
+	 names.push_back(name);
+	 hists.push_back(h);
+	 ntimers++;
+      }
+   }
+   fclose(fp);
+   return ntimers;
+}
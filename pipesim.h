@@ -0,0 +1,190 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * discrete-event simulation of the DAQ pipeline for sizing pipeline_max.
+ *
+ * model, per frame read from the FIFO:
+ *   - arrival: reader pace sampled from the measured "read" times.
+ *   - lost if the pipeline is full: the FIFO keeps running while the
+ *     reader is blocked (dead time).
+ *   - writer cost: common stages + skip, or + write per recorded frame.
+ *     A trigger outside a window writes pre+1 frames at once, the post
+ *     frames one by one; a trigger inside the post window holds its
+ *     count down for a frame, as O_T1P1 in pipeline_t.
+ *   - triggers: random (trig_ratio per frame, optionally in bursts)
+ *     and/or periodic.
+ *   - file rotation: a stall every rotate_frames recorded frames.
+ *   - pre frames stay in the pipeline for the pre-trigger window.
+ *
+ * usage:
+ *   pipesim_t sim;
+ *   sim.set_dist(PSIM_READ, timer->get_hist() );	// or set_const()
+ *   ...
+ *   pipesim_result_t r = sim.run(cfg, 10000000);
+ *   int L = sim.recommend(cfg, 1e-3);
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef pipesim_h
+#define pipesim_h
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "Timer.h"	// LatencyHist
+
+// stage time distributions
+enum psim_stages_t
+   {
+    PSIM_READ			// per frame read
+    , PSIM_COMM			// per frame processed, any number of parts
+    , PSIM_SKIP			// per frame not recorded
+    , PSIM_WRITE		// per frame recorded
+    , PSIM_ROTATE		// per new output files
+    , PSIM_NSTAGES
+   };
+
+//
+// fast pseudo random numbers (xorshift64*)
+//______________________________________________________________________
+typedef struct psim_rng_t
+{
+   psim_rng_t(uint64_t seed=1)	{ x = seed ? seed : 0x9E3779B97F4A7C15ULL; }
+   uint64_t next()
+   {
+      x ^= x >> 12;
+      x ^= x << 25;
+      x ^= x >> 27;
+      return x * 0x2545F4914F6CDD1DULL;
+   }
+   double uniform()	{ return (next() >> 11) * (1.0 / 9007199254740992.0); }	// [0, 1)
+   uint64_t x;
+}
+   psim_rng_t
+   ;
+
+//
+// empirical distribution of a stage time, usec
+//______________________________________________________________________
+class psim_dist_t
+{
+public:
+   psim_dist_t()	{ clear(); }
+
+   void clear()		{ m_x.clear(); m_cum.clear(); m_mean = 0; }
+   void set_const(double usec);
+   void set_hist(LatencyHist &h);	// nsec buckets of a Timer
+   void add_bucket(double usec, uint64_t count);	// build by hand / from file
+   void scale(double f);		// all values x f
+   bool empty()		{ return m_x.empty(); }
+   double get_mean()	{ return m_mean; }
+
+   double sample(psim_rng_t &rng)
+   {
+      size_t n = m_x.size();
+      if (n <= 1)	return n ? m_x[0] : 0;
+      uint64_t u = rng.next() % m_cum[n-1];
+      size_t lo = 0, hi = n - 1;		// first m_cum > u
+      while (lo < hi) {
+	 size_t mid = (lo + hi) / 2;
+	 if (m_cum[mid] > u)	hi = mid;
+	 else			lo = mid + 1;
+      }
+      return m_x[lo];
+   }
+
+private:
+   std::vector<double>		m_x;	// bucket values
+   std::vector<uint64_t>	m_cum;	// cumulative counts
+   double			m_mean;
+};
+
+//______________________________________________________________________
+typedef struct pipesim_config_t
+{
+   pipesim_config_t()
+      : pipeline_max(1000), pre_trigs(0), post_trigs(0)
+      , trig_ratio(0), trig_period(0)
+      , burst_factor(1), burst_frac(0), burst_len(1000)
+      , rotate_frames(0), window(0)
+   {}
+
+   int		pipeline_max;
+   int		pre_trigs;
+   int		post_trigs;
+   double	trig_ratio;	// random triggers per frame
+   int		trig_period;	// periodic trigger per N frames, 0 = none
+   double	burst_factor;	// trig_ratio x factor in bursts
+   double	burst_frac;	// fraction of frames in bursts
+   double	burst_len;	// mean burst length in frames
+   unsigned long rotate_frames;	// recorded frames per output file, 0 = none
+   unsigned long window;	// frames per overflow window, 0 = 1 sec
+}
+   pipesim_config_t
+   ;
+
+typedef struct pipesim_result_t
+{
+   unsigned long frames;	// arrived
+   unsigned long lost;		// arrived at a full pipeline
+   unsigned long recorded;
+   unsigned long triggers;
+   unsigned long windows;
+   unsigned long windows_lost;	// windows with any frame lost
+   double	deadtime;	// lost / frames
+   double	p_overflow;	// windows_lost / windows
+   double	occ_mean;	// pipeline occupancy at arrival, fraction
+   double	occ_max;
+   double	sim_sec;	// simulated DAQ time
+   double	cpu_sec;	// time taken
+}
+   pipesim_result_t
+   ;
+
+//______________________________________________________________________
+class pipesim_t
+{
+public:
+   pipesim_t()	{}
+
+   psim_dist_t & dist(int k)	{ return m_dist[k]; }
+   void set_dist(int k, LatencyHist &h)		{ m_dist[k].set_hist(h); }
+   void set_const(int k, double usec)		{ m_dist[k].set_const(usec); }
+   void add_comm(LatencyHist &h)		{ m_comm.resize(m_comm.size()+1); m_comm.back().set_hist(h); }
+
+   pipesim_result_t run(const pipesim_config_t &cfg, unsigned long nframes, uint64_t seed=1);
+
+   // smallest pipeline_max in [pre+post+2, Lmax] with p_overflow <= p_max, -1 if none
+   int recommend(pipesim_config_t cfg, double p_max=1e-3, int Lmax=1000000, unsigned long nframes=0);
+
+   std::string sprint(const pipesim_result_t &r);
+
+private:
+   psim_dist_t			m_dist[PSIM_NSTAGES];
+   std::vector<psim_dist_t>	m_comm;		// parts of PSIM_COMM, summed
+};
+
+//
+// timing of the last run: Timer histograms and run parameters, text
+//______________________________________________________________________
+typedef struct timing_file_t
+{
+   std::vector<std::string>	names;		// timers, blanks as '_'
+   std::vector<LatencyHist*>	hists;		// owned
+   std::vector<std::string>	keys;		// parameters
+   std::vector<double>		values;
+
+   ~timing_file_t();
+   void add_param(const char *key, double x)	{ keys.push_back(key); values.push_back(x); }
+   double get_param(const char *key, double def=0);
+   LatencyHist * get_hist(const char *name);	// NULL if not found
+
+   int save(const char *fn, Timer **timers, const char **tnames, int ntimers);
+   int load(const char *fn);		// return timers read, -1 on error
+}
+   timing_file_t
+   ;
+
+#endif //~ pipesim_h
@@ -0,0 +1,184 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * ROOT write settings of the DAQ tree: a grid of compression, basket
+ * size and AutoFlush, each filled with the same frames and read back
+ * by SupixTree.
+ *
+ * - frames replayed from a raw data file (-i), or synthetic.
+ * - split level n/a: the DAQ branches are leaf lists, never split.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "SupixDAQ.h"
+#include "SupixTree.h"
+#include "Timer.h"	// timer_now_ns()
+
+#include "TFile.h"
+
+#include <unistd.h>     // for getopt()
+#include <stdio.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+//______________________________________________________________________
+void usage(char **argv) {
+   cout << "Usage: " << argv[0] << " [options]" << endl
+	<< "\t\t -h		# print this" << endl
+	<< "\t\t -b LIST	# [32000] basket sizes in bytes" << endl
+	<< "\t\t -c LIST	# [0,101,106,404,505,207] compression = algorithm*100 + level" << endl
+	<< "\t\t			#   1=ZLIB 2=LZMA 4=LZ4 5=ZSTD" << endl
+	<< "\t\t -f LIST	# [-30000000] AutoFlush, < 0 in bytes, > 0 in entries" << endl
+	<< "\t\t -i FILE	# raw data file to replay, default synthetic frames; CDS thresholds by its noise" << endl
+	<< "\t\t -k		# keep ROOT files" << endl
+	<< "\t\t -n INT		# [20000] frames per setting, up to whole passes of the frame bank" << endl
+	<< "\t\t -o FILE	# [rootbench.tsv] results appended" << endl
+	<< "\t\t -r PATHNAME	# [/tmp] dir for ROOT files" << endl
+	<< "\t\t -y FLOAT	# [0.01] synthetic: ratio of frames with pulses" << endl
+      ;
+   exit(0);
+}
+
+// comma separated numbers
+template<class T>
+vector<T> parse_list(const char *s)
+{
+   vector<T> v;
+   istringstream iss(s);
+   string tok;
+   while (getline(iss, tok, ',') ) {
+      T x;
+      istringstream(tok) >> x;
+      v.push_back(x);
+   }
+   return v;
+}
+
+// read all entries by SupixTree, return sec
+//______________________________________________________________________
+double read_back(const char *fn, double &bytes)
+{
+   TFile *file = new TFile(fn);
+   TTree *tree = NULL;
+   file->GetObject("supix", tree);
+   bytes = 0;
+   if (! tree) {
+      delete file;
+      return 0;
+   }
+   SupixTree st(tree);		// file deleted with it
+   unsigned long long t0 = timer_now_ns();
+   Long64_t n = tree->GetEntries();
+   for (Long64_t i=0; i < n; i++)
+      bytes += st.GetEntry(i);
+   return (timer_now_ns() - t0) * 1e-9;
+}
+
+//======================================================================
+int main(int argc, char **argv)
+{
+   vector<int>	compress = parse_list<int>("0,101,106,404,505,207");
+   vector<int>	basket	 = parse_list<int>("32000");
+   vector<long>	flush	 = parse_list<long>("-30000000");
+   string input;
+   string dir = "/tmp";
+   string outfn = "rootbench.tsv";
+   unsigned long nframes = 20000;
+   double ratio = 0.01;
+   bool keep = false;
+
+   int copt;
+   while ( (copt = getopt(argc, argv, "hb:c:f:i:kn:o:r:y:")) != -1) {
+      switch (copt) {
+      case 'b':
+	 basket = parse_list<int>(optarg);
+	 break;
+      case 'c':
+	 compress = parse_list<int>(optarg);
+	 break;
+      case 'f':
+	 flush = parse_list<long>(optarg);
+	 break;
+      case 'i':
+	 input = optarg;
+	 break;
+      case 'k':
+	 keep = true;
+	 break;
+      case 'n':
+         sscanf(optarg, "%lu", &nframes);
+         break;
+      case 'o':
+	 outfn = optarg;
+	 break;
+      case 'r':
+	 dir = optarg;
+	 break;
+      case 'y':
+         sscanf(optarg, "%lf", &ratio);
+         break;
+      case 'h':
+      default:
+	 usage(argv);
+      }
+   }
+
+   SupixDAQ *supix = new SupixDAQ;
+   supix->set_filename(dir.c_str(), "rootbench");
+   supix->set_trig_cds_x(5);
+   supix->set_source(0, input.size() ? 0 : ratio);	// not paced
+   if (input.size() && supix->load_source(input.c_str() ) <= 0)
+      return 1;
+
+   bool header = access(outfn.c_str(), F_OK) != 0;
+   FILE *fp = fopen(outfn.c_str(), "a");
+   if (! fp) {
+      perror(outfn.c_str() );
+      return 1;
+   }
+   const char *cols = "input\tcompress\tbasket\tautoflush\tentries\tfills_per_sec"
+      "\tMBps_in\tMBps_out\tratio\tfile_MB\twrite_sec\tread_fps\tread_MBps";
+   if (header)	fprintf(fp, "%s\n", cols);
+   printf("%s\n", cols);
+
+   const char *tag = input.size() ? input.c_str() : "synthetic";
+   for (size_t ic=0; ic < compress.size(); ic++) {
+      for (size_t ib=0; ib < basket.size(); ib++) {
+	 for (size_t ia=0; ia < flush.size(); ia++) {
+	    ostringstream oss;
+	    oss << dir << "/rootbench_" << compress[ic] << "_" << basket[ib] << "_" << flush[ia] << ".root";
+	    string fn = oss.str();
+
+	    tree_bench_t r;
+	    supix->set_root_settings(compress[ic], basket[ib], flush[ia]);
+	    supix->bench_tree(nframes, fn.c_str(), r);
+	    double rbytes = 0;
+	    double rsec = read_back(fn.c_str(), rbytes);
+	    if (! keep)	unlink(fn.c_str() );
+
+	    double sec = r.fill_sec + r.write_sec;
+	    char line[512];
+	    snprintf(line, sizeof(line)
+		     , "%s\t%d\t%d\t%ld\t%lu\t%.0f\t%.1f\t%.1f\t%.2f\t%.2f\t%.3f\t%.0f\t%.1f"
+		     , tag, compress[ic], basket[ib], flush[ia], r.entries
+		     , r.entries / sec
+		     , r.tot_bytes / MiB / sec
+		     , r.zip_bytes / MiB / sec
+		     , r.zip_bytes > 0 ? r.tot_bytes / r.zip_bytes : 0
+		     , r.file_bytes / MiB
+		     , r.write_sec
+		     , rsec > 0 ? r.entries / rsec : 0
+		     , rsec > 0 ? rbytes / MiB / rsec : 0 );
+	    printf("%s\n", line);
+	    fprintf(fp, "%s\n", line);
+	    fflush(fp);
+	 }
+      }
+   }
+   fclose(fp);
+   delete supix;
+   return 0;
+}
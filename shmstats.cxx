@@ -0,0 +1,57 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * live DAQ statistics in a POSIX shared-memory segment.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "shmstats.h"
+#include "error.h"
+
+#include <sys/stat.h>	// mode_t
+
+
+// create (or re-initialize) the segment
+//______________________________________________________________________
+shm_stats_t * shmstats_create(const char *name)
+{
+   mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH ;
+   int fd = shm_open(name, O_CREAT | O_RDWR, mode);
+   if (fd < 0) {
+      err_ret("shm_open(\"%s\")", name);
+      return NULL;
+   }
+   if (ftruncate(fd, sizeof(shm_stats_t)) < 0) {
+      err_ret("ftruncate(\"%s\")", name);
+      close(fd);
+      return NULL;
+   }
+   void *ptr = mmap(NULL, sizeof(shm_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (ptr == MAP_FAILED) {
+      err_ret("mmap(\"%s\")", name);
+      return NULL;
+   }
+
+   // magic last: monitors ignore a half-initialized segment
+   shm_stats_t *p = (shm_stats_t*)ptr;
+   p->magic = 0;
+   memset(ptr, 0, sizeof(shm_stats_t));
+   p->version	= SHMSTATS_VERSION;
+   p->pid	= getpid();
+   p->running.store(1);
+   std::atomic_thread_fence(std::memory_order_release);
+   p->magic	= SHMSTATS_MAGIC;
+   return p;
+}
+
+// mark the run finished and unmap
+// - the segment is kept for monitors to show the final numbers
+//______________________________________________________________________
+void shmstats_close(shm_stats_t *p)
+{
+   if (! p)	return;
+   p->running.store(0);
+   munmap(p, sizeof(shm_stats_t));
+}
@@ -0,0 +1,153 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * live DAQ statistics in a POSIX shared-memory segment.
+ *
+ * - one block per thread, cache-line aligned, written by its owner
+ *   only under a sequence lock: the writer never waits, readers retry.
+ * - readers (SupixGUI monitor) map the segment read-only and never
+ *   touch the DAQ process.
+ *
+ * usage (DAQ):
+ *   shm_stats_t *p = shmstats_create(SHMSTATS_NAME);
+ *   shmstats_begin(&p->thread[i]);  ... stores ...  shmstats_end(&p->thread[i]);
+ *
+ * usage (monitor):
+ *   const shm_stats_t *p = shmstats_attach(SHMSTATS_NAME);
+ *   shm_thread_t snap;
+ *   shmstats_read(&p->thread[i], &snap);
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef shmstats_h
+#define shmstats_h
+
+#include <fcntl.h>	// O_RDONLY
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>	// shm_open(), mmap()
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#define SHMSTATS_NAME		"/supix_stats"
+#define SHMSTATS_MAGIC		0x58505553	// "SUPX"
+#define SHMSTATS_VERSION	1
+#define SHMSTATS_THREADS	4
+#define SHMSTATS_TIMERS		32
+#define SHMSTATS_NAMELEN	16
+#define CACHELINE		64
+
+enum shm_threads_t { SHM_RD, SHM_WR };
+
+// counters, each owned by one thread
+enum shm_counts_t
+   {
+    SHM_READS, SHM_SAVED, SHM_PROCS, SHM_RECORDS, SHM_TRIGS
+    , SHM_BYTES			// written to raw and ROOT files
+    , SHM_OCCUPANCY		// pipeline occupancy in ppm
+    , SHM_ISFULL, SHM_WAITNEW, SHM_WAITFIRST, SHM_NONINTEGRITY, SHM_TIMEOUT
+    , SHM_NCOUNTS
+   };
+
+// per thread block
+//______________________________________________________________________
+struct alignas(CACHELINE) shm_thread_t
+{
+   std::atomic<uint64_t>	seq;		// odd = being updated
+   std::atomic<uint64_t>	t_ns;		// CLOCK_MONOTONIC at last update
+   std::atomic<uint64_t>	counts[SHM_NCOUNTS];
+   std::atomic<uint64_t>	timer_n[SHMSTATS_TIMERS];	// samples
+   std::atomic<uint64_t>	timer_ns[SHMSTATS_TIMERS];	// total time
+};
+
+//______________________________________________________________________
+struct shm_stats_t
+{
+   uint32_t	magic;
+   uint32_t	version;
+   int32_t	pid;
+   int32_t	pipeline_max;
+   std::atomic<int32_t>	running;	// 0 after finalize
+   int32_t	ntimers;
+   char		timer_name[SHMSTATS_TIMERS][SHMSTATS_NAMELEN];
+   int32_t	timer_thread[SHMSTATS_TIMERS];	// owner, shm_threads_t
+   shm_thread_t	thread[SHMSTATS_THREADS];
+};
+
+inline uint64_t shmstats_now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//
+// writer side, owner thread only
+//______________________________________________________________________
+inline void shmstats_begin(shm_thread_t *p)
+{
+   p->seq.fetch_add(1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void shmstats_set(std::atomic<uint64_t> &x, uint64_t v)
+{  x.store(v, std::memory_order_relaxed);  }
+
+inline void shmstats_end(shm_thread_t *p)
+{
+   p->t_ns.store(shmstats_now(), std::memory_order_relaxed);
+   p->seq.fetch_add(1, std::memory_order_release);
+}
+
+// create (or re-initialize) the segment, NULL on failure
+shm_stats_t * shmstats_create(const char *name = SHMSTATS_NAME);
+// mark the run finished and unmap
+void shmstats_close(shm_stats_t *p);
+
+//
+// reader side, header only for ROOT macros
+//______________________________________________________________________
+
+// map read-only, NULL if not existing or not compatible
+inline const shm_stats_t * shmstats_attach(const char *name = SHMSTATS_NAME)
+{
+   int fd = shm_open(name, O_RDONLY, 0);
+   if (fd < 0)	return NULL;
+   void *ptr = mmap(NULL, sizeof(shm_stats_t), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (ptr == MAP_FAILED)	return NULL;
+   const shm_stats_t *p = (const shm_stats_t*)ptr;
+   if (p->magic != SHMSTATS_MAGIC || p->version != SHMSTATS_VERSION) {
+      munmap(ptr, sizeof(shm_stats_t));
+      return NULL;
+   }
+   return p;
+}
+
+inline void shmstats_detach(const shm_stats_t *p)
+{
+   if (p)	munmap((void*)p, sizeof(shm_stats_t));
+}
+
+// consistent snapshot of a thread block
+inline void shmstats_read(const shm_thread_t *p, shm_thread_t *snap)
+{
+   uint64_t s0, s1;
+   do {
+      s0 = p->seq.load(std::memory_order_acquire);
+      snap->t_ns.store(p->t_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      for (int i=0; i < SHM_NCOUNTS; i++)
+	 snap->counts[i].store(p->counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      for (int i=0; i < SHMSTATS_TIMERS; i++) {
+	 snap->timer_n[i].store(p->timer_n[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	 snap->timer_ns[i].store(p->timer_ns[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      s1 = p->seq.load(std::memory_order_relaxed);
+   } while ( (s0 & 1) || s0 != s1 );
+   snap->seq.store(s1, std::memory_order_relaxed);
+}
+
+#endif //~ shmstats_h
@@ -0,0 +1,362 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * Skim of DAQ trees: triged frames of selected types and their waveform
+ * windows, optionally zero suppressed and cropped around the seed.
+ *
+ * - the output has the same tree "supix" and RunInfo (noise arrays
+ *   included), i.e. book.exe and SupixAnly read it as is.
+ * - a window is the pre/post frames of RunInfo, or -w, kept only if
+ *   their frame numbers are adjacent to the triged one.
+ * - -z X: pixels with CDS/sigma > -X zeroed; -R N: pixels off the
+ *   (2N+1)x(2N+1) around the seed zeroed. The per-pixel noise histograms
+ *   of such a skim are meaningless.
+ * - files on -j threads, one output per input file, by default in skim/
+ *   beside the input: not matched by the pattern of the input files.
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "RunInfo.h"
+#include "Timer.h"
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TNamed.h>
+
+// C headers
+#include <pthread.h>
+#include <stdio.h>	// sscanf()
+#include <stdlib.h>
+#include <string.h>	// strerror()
+#include <unistd.h>     // for getopt()
+#include <errno.h>
+#include <sys/stat.h>	// mkdir()
+
+// C++ headers
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+using namespace std;
+
+typedef struct skim_opt_t
+{
+   int		trig_mask;	// trig & mask kept
+   int		pre, post;	// window, < 0 = RunInfo
+   double	zs;		// sigma, 0 = none
+   int		roi;		// half width around the seed, < 0 = none
+   string	outdir;		// "" = skim/ beside the input
+}
+   skim_opt_t
+   ;
+
+typedef struct skim_file_t
+{
+   string	in, out;
+   Long64_t	nin, nout;
+   Long64_t	ntrigs;
+   Long64_t	bytes_in, bytes_out;	// on disk
+   bool		ok;
+}
+   skim_file_t
+   ;
+
+typedef struct skim_job_t
+{
+   const skim_opt_t *	opt;
+   vector<skim_file_t> *files;
+   size_t		next;
+   pthread_mutex_t	mutex;
+}
+   skim_job_t
+   ;
+
+void
+usage(char **argv)
+{
+   cout << "Usage: " << argv[0] << " [options] /path/to/pattern*.root" << endl
+	<< "\t\t -t MASK	# [2] trig types kept, trig & MASK; 3 = periodic too" << endl
+	<< "\t\t -w PRE:POST	# frames around a triged one, default of RunInfo" << endl
+	<< "\t\t -z X		# zero suppression: pixels of CDS/sigma > -X zeroed" << endl
+	<< "\t\t -R N		# ROI: pixels off (2N+1)x(2N+1) around the seed zeroed" << endl
+	<< "\t\t -j NUM		# [1] files in parallel" << endl
+	<< "\t\t -o dir		# output directory, default skim/ beside the input" << endl
+	<< endl;
+   exit(0);
+}
+
+// <dir>/<name>-skim.root; dir = <input dir>/skim by default, not beside
+// the input where book.exe /path/to/pattern*.root would count it again
+static string skim_name(const string &in, const string &outdir)
+{
+   string base = in;
+   size_t n = base.rfind(".root");
+   if (n != string::npos)	base = base.substr(0, n);
+   size_t slash = base.rfind('/');
+   string dir	= outdir.size() ? outdir
+      : slash == string::npos ? string("skim") : base.substr(0, slash) + "/skim";
+   return dir + "/" + base.substr(slash + 1) + "-skim.root";
+}
+
+// directory of fn, if not there yet
+static bool make_dir(const string &fn)
+{
+   string dir = fn.substr(0, fn.rfind('/') );
+   if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+      LOG << dir << ": " << strerror(errno) << endl;
+      return false;
+   }
+   return true;
+}
+
+//______________________________________________________________________
+static bool skim_file(skim_file_t &f, const skim_opt_t &opt)
+{
+   TFile *fin = TFile::Open(f.in.c_str(), "READ");
+   if (! fin || fin->IsZombie() ) {
+      LOG << f.in << ": can't open" << endl;
+      delete fin;
+      return false;
+   }
+   TTree *t = 0;
+   fin->GetObject("supix", t);
+   RunInfo *ri = t ? (RunInfo*)t->GetUserInfo()->At(0) : 0;
+   if (! ri) {
+      LOG << f.in << ": no tree supix or RunInfo" << endl;
+      delete fin;
+      return false;
+   }
+
+   Int_t	pixel_cds[NROWS][NCOLS];
+   UShort_t	pixel_adc[NROWS][NCOLS];
+   UShort_t	pixid[NPIXS];
+   ULong64_t	frame;
+   UShort_t	npixs;
+   UChar_t	trig;
+   TBranch *b_frame, *b_npixs, *b_trig, *b_pixid, *b_pixel_cds;
+   t->SetBranchAddress("pixel_cds", pixel_cds, &b_pixel_cds);
+   t->SetBranchAddress("pixel_adc", pixel_adc);
+   t->SetBranchAddress("pixid", pixid, &b_pixid);
+   t->SetBranchAddress("frame", &frame, &b_frame);
+   t->SetBranchAddress("npixs", &npixs, &b_npixs);
+   t->SetBranchAddress("trig", &trig, &b_trig);
+
+   int pre  = opt.pre  < 0 ? ri->pre_trigs  : opt.pre;
+   int post = opt.post < 0 ? ri->post_trigs : opt.post;
+
+   // pass 1: triged frames and their windows by trig & frame only; the
+   // seed of a window is that of its triged frame
+   Long64_t n = t->GetEntries();
+   vector<ULong64_t> frames(n);
+   vector<char> keep(n, 0);
+   vector<short> seed(n, -1);		// pixid
+   for (Long64_t i=0; i < n; i++) {
+      b_frame->GetEntry(i);
+      frames[i] = frame;
+   }
+   f.ntrigs = 0;
+   for (Long64_t i=0; i < n; i++) {
+      b_trig->GetEntry(i);
+      if (! (trig & opt.trig_mask) || trig >= TRIG_PRE)	continue;
+      f.ntrigs++;
+      int s = -1;
+      if (opt.roi >= 0) {
+	 b_npixs->GetEntry(i);
+	 b_pixid->GetEntry(i);
+	 b_pixel_cds->GetEntry(i);
+	 double min = 0;
+	 for (int k=0; k < npixs && k < NPIXS; k++) {
+	    int r = pixid[k] >> NBITS_COL;
+	    int c = pixid[k] &  MASK_COL;
+	    double snr = (pixel_cds[r][c] - ri->cds_mean[r][c]) / ri->cds_sigma[r][c];
+	    if (snr < min) {
+	       min = snr;
+	       s = pixid[k];
+	    }
+	 }
+      }
+      for (Long64_t j = i - pre; j <= i + post; j++) {
+	 if (j < 0 || j >= n)	continue;
+	 ULong64_t d = frames[j] > frames[i] ? frames[j] - frames[i] : frames[i] - frames[j];
+	 if (d > (ULong64_t)(j < i ? pre : post) )	continue;
+	 keep[j] = 1;
+	 if (seed[j] < 0)	seed[j] = s;
+      }
+   }
+
+   // pass 2: the kept entries in full
+   TFile *fout = TFile::Open(f.out.c_str(), "RECREATE");
+   if (! fout || fout->IsZombie() ) {
+      LOG << f.out << ": can't create" << endl;
+      delete fout;
+      delete fin;
+      return false;
+   }
+   TTree *o = t->CloneTree(0);		// RunInfo in UserInfo too
+   if (! o->GetUserInfo()->At(0) )
+      o->GetUserInfo()->Add(ri->Clone() );
+   f.nout = 0;
+   for (Long64_t i=0; i < n; i++) {
+      if (! keep[i])	continue;
+      t->GetEntry(i);
+      if (opt.zs > 0 || opt.roi >= 0) {
+	 int sr = seed[i] < 0 ? -1 : seed[i] >> NBITS_COL;
+	 int sc = seed[i] < 0 ? -1 : seed[i] &  MASK_COL;
+	 for (int r=0; r < NROWS; r++) {
+	    for (int c=0; c < NCOLS; c++) {
+	       bool zero = opt.zs > 0
+		  && (pixel_cds[r][c] - ri->cds_mean[r][c]) / ri->cds_sigma[r][c] > -opt.zs;
+	       if (opt.roi >= 0)
+		  zero = zero || sr < 0 || abs(r - sr) > opt.roi || abs(c - sc) > opt.roi;
+	       if (zero) {
+		  pixel_cds[r][c] = 0;
+		  pixel_adc[r][c] = 0;
+	       }
+	    }
+	 }
+      }
+      o->Fill();
+      f.nout++;
+   }
+
+   ostringstream oss;
+   oss << "trig&" << opt.trig_mask << " window=" << pre << ":" << post
+       << " zs=" << opt.zs << " roi=" << opt.roi << " of " << f.in;
+   TNamed note("skim", oss.str().c_str() );
+   note.Write();
+   o->Write();
+   f.nin	= n;
+   f.bytes_in	= fin->GetSize();
+   delete fout;		// o too
+   delete fin;
+   TFile *chk = TFile::Open(f.out.c_str(), "READ");
+   f.bytes_out	= chk ? chk->GetSize() : 0;
+   delete chk;
+   return true;
+}
+
+static void * skim_worker(void *arg)
+{
+   skim_job_t *job = (skim_job_t*)arg;
+   while (1) {
+      pthread_mutex_lock(&job->mutex);
+      size_t i = job->next++;
+      pthread_mutex_unlock(&job->mutex);
+      if (i >= job->files->size() )	break;
+      skim_file_t &f = (*job->files)[i];
+      f.ok = skim_file(f, *job->opt);
+      if (f.ok)
+	 LOG << f.in << " => " << f.out << ": " << f.nout << "/" << f.nin
+	     << " frames, " << f.ntrigs << " triged" << endl;
+   }
+   return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+   // defaults
+   skim_opt_t opt;
+   opt.trig_mask	= TRIG_CDS;
+   opt.pre		= -1;
+   opt.post		= -1;
+   opt.zs		= 0;
+   opt.roi		= -1;
+   int nthreads = 1;
+
+   //................................................ command line options
+   int copt;
+   while ((copt = getopt(argc, argv, "j:o:t:w:z:R:")) != -1) {
+      switch (copt) {
+      case 't':		// trig types
+	 opt.trig_mask = strtol(optarg, NULL, 0);
+         break;
+      case 'w':		// window
+	 if (sscanf(optarg, "%d:%d", &opt.pre, &opt.post) != 2)
+	    usage(argv);
+         break;
+      case 'z':		// zero suppression
+	 opt.zs = atof(optarg);
+         break;
+      case 'R':		// ROI
+	 opt.roi = atoi(optarg);
+         break;
+      case 'j':		// threads
+	 nthreads = atoi(optarg);
+         break;
+      case 'o':		// output directory
+	 opt.outdir = optarg;
+         break;
+      default:
+         usage(argv);
+      }
+   }
+   if (optind >= argc)
+      usage(argv);
+
+   vector<skim_file_t> files(argc - optind);
+   map<string, string> outs;		// -o DIR: same basenames of other dirs
+   for (size_t i=0; i < files.size(); i++) {
+      files[i].in	= argv[optind + i];
+      files[i].out	= skim_name(files[i].in, opt.outdir);
+      if (outs.count(files[i].out) ) {
+	 LOG << files[i].in << " and " << outs[files[i].out] << ": both to "
+	     << files[i].out << ", skim them apart or without -o" << endl;
+	 return 1;
+      }
+      outs[files[i].out] = files[i].in;
+      if (! make_dir(files[i].out) )
+	 return 1;
+      files[i].nin = files[i].nout = files[i].ntrigs = 0;
+      files[i].bytes_in = files[i].bytes_out = 0;
+      files[i].ok	= false;
+   }
+
+   Timer timer("skim");
+   timer.start();
+   skim_job_t job;
+   job.opt	= &opt;
+   job.files	= &files;
+   job.next	= 0;
+   pthread_mutex_init(&job.mutex, NULL);
+   int n = nthreads < 1 ? 1 : nthreads > (int)files.size() ? (int)files.size() : nthreads;
+   if (n > 1) {
+      ROOT::EnableThreadSafety();
+      vector<pthread_t> tid(n);
+      for (int k=0; k < n; k++) {
+	 int err = pthread_create(&tid[k], NULL, skim_worker, &job);
+	 if (err) {
+	    LOG << "pthread_create: " << strerror(err) << endl;
+	    exit(-1);
+	 }
+      }
+      for (int k=0; k < n; k++)
+	 pthread_join(tid[k], NULL);
+   }
+   else
+      skim_worker(&job);
+   pthread_mutex_destroy(&job.mutex);
+   timer.stop();
+
+   Long64_t nin = 0, nout = 0, bin = 0, bout = 0;
+   int nok = 0;
+   for (size_t i=0; i < files.size(); i++) {
+      if (! files[i].ok)	continue;
+      nok++;
+      nin	+= files[i].nin;
+      nout	+= files[i].nout;
+      bin	+= files[i].bytes_in;
+      bout	+= files[i].bytes_out;
+   }
+   LOG << "skim: " << nok << "/" << files.size() << " files, "
+       << nout << "/" << nin << " frames, "
+       << bout / 1048576. << "/" << bin / 1048576. << " MB, reduction x"
+       << (bout > 0 ? (double)bin / bout : 0)
+       << endl;
+   timer.print(1);
+   return nok == (int)files.size() ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * benchmark of the reader/writer handoff through pipeline_t, with the
+ * protocol of SupixDAQ::reader_run() and writer_run().
+ *   - RD: wait non-full, "read" a frame, stamp it, next_in(first)
+ *   - WR: wait new, is_first(), latency = now - stamp, process,
+ *         next_out(mode) with periodic triggers
+ *
+ * load profiles:
+ *   steady	frames arrive every <pace> usec
+ *   bursty	<burst> frames back-to-back, then a gap, the same mean rate
+ *   slow	steady, the writer stalls <stall> usec every <nstall> frames
+ * each with and without next_in(true) first-frame waits.
+ *
+ * reported per profile: handoff latency p50/p99/p99.9/max, frames/s,
+ * lock acquisitions and CPU per frame of each thread, waits.
+ *
+ * usage:
+ *   test/bench_pipeline.exe [-p steady|bursty|slow] [-c RD,WR] ...
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "pipeline.h"
+#include "Timer.h"	// LatencyHist, timer_now_ns()
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>	// getopt(), usleep()
+#include <sys/time.h>
+#include <sys/resource.h>	// getrusage()
+
+#include <string>
+#include <vector>
+using namespace std;
+
+enum profile_t { P_STEADY, P_BURSTY, P_SLOW, NPROFILES };
+const char *profile_name[NPROFILES] = { "steady", "bursty", "slow" };
+
+// configuration
+int	g_framesize	= 4096;
+int	g_pipeline_max	= 1000;
+int	g_pre		= 3;
+int	g_post		= 6;
+long	g_nframes	= 200000;
+double	g_pace		= 10;		// usec per frame arriving
+double	g_work		= 5;		// usec per frame processed
+int	g_burst		= 100;		// frames per burst
+int	g_nstall	= 10000;	// frames per writer stall
+double	g_stall		= 5000;		// usec per stall
+int	g_trig_period	= 100;		// frames per trigger
+int	g_first_every	= 1000;		// frames per next_in(true)
+int	g_timewait	= 10;		// usec per poll, 0 = sched_yield()
+int	g_cpu[2]	= { -1, -1 };	// RD, WR
+
+// per thread results
+struct side_t
+{
+   unsigned long locks;		// rwlock acquisitions
+   unsigned long waits;		// RD: ISFULL, WR: WAITNEW
+   unsigned long waitfirst;	// RD: next_in(true) refused
+   double	 cpu;		// sec, user + sys
+   side_t() : locks(0), waits(0), waitfirst(0), cpu(0) {}
+};
+
+struct run_t
+{
+   profile_t	profile;
+   bool		first;		// with first-frame waits
+   pipeline_t *	pipe;
+   side_t	rd, wr;
+   LatencyHist	hist;		// handoff latency, nsec
+   volatile bool done;
+   unsigned long long t0, t1;
+};
+
+// busy wait, as a FIFO read or a processing stage
+inline void spin_until(unsigned long long t)
+{
+   while (timer_now_ns() < t)
+      ;
+}
+
+inline void poll_wait()
+{
+   if (g_timewait > 0)	usleep(g_timewait);
+   else			sched_yield();
+}
+
+double thread_cpu()
+{
+   struct rusage ru;
+   getrusage(RUSAGE_THREAD, &ru);
+   return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6
+      + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+void pin(int cpu)
+{
+   if (cpu < 0)	return;
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   int rv = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+   if (rv)	fprintf(stderr, "pthread_setaffinity_np(%d): %s\n", cpu, strerror(rv) );
+}
+
+// physical core and package of a cpu, -1 if unknown
+int cpu_topology(int cpu, const char *what)
+{
+   char fn[128];
+   snprintf(fn, sizeof(fn), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, what);
+   FILE *fp = fopen(fn, "r");
+   if (! fp)	return -1;
+   int id = -1;
+   if (fscanf(fp, "%d", &id) != 1)	id = -1;
+   fclose(fp);
+   return id;
+}
+
+//______________________________________________________________________
+void * writer(void *arg)
+{
+   run_t *r = (run_t*)arg;
+   pipeline_t *p = r->pipe;
+   pin(g_cpu[1]);
+   double cpu0 = thread_cpu();
+
+   for (long n = 0; n < g_nframes; n++) {
+      r->wr.locks++;
+      while (! p->is_new() ) {
+	 r->wr.waits++;
+	 poll_wait();
+	 r->wr.locks++;
+      }
+      unsigned long long now = timer_now_ns();
+      r->wr.locks++;
+      unsigned long long stamp;
+      memcpy(&stamp, p->get_out_ptr(), sizeof(stamp) );
+      r->hist.add(now - stamp);
+
+      r->wr.locks++;
+      p->is_first();
+
+      unsigned long long t = now + (unsigned long long)(g_work * 1000);
+      if (r->profile == P_SLOW && n % g_nstall == g_nstall - 1)
+	 t += (unsigned long long)(g_stall * 1000);
+      spin_until(t);
+
+      OUT_MODE_t mode = n % g_trig_period == 0 ? O_T1P0 : p->is_post() ? O_T0P1 : O_T0P0;
+      r->wr.locks++;
+      p->next_out(mode);
+   }
+   r->wr.cpu = thread_cpu() - cpu0;
+   r->t1 = timer_now_ns();
+   r->done = true;
+   return NULL;
+}
+
+//______________________________________________________________________
+void reader(run_t *r)
+{
+   pipeline_t *p = r->pipe;
+   pin(g_cpu[0]);
+   double cpu0 = thread_cpu();
+   unsigned long long pace = (unsigned long long)(g_pace * 1000);
+   unsigned long long tnext = timer_now_ns();
+   r->t0 = tnext;
+
+   for (long n = 0; n < g_nframes; n++) {
+      // arrival of frame n
+      if (r->profile == P_BURSTY) {
+	 if (n % g_burst == 0)	spin_until(tnext);
+	 if (n % g_burst == g_burst - 1)	tnext += pace * g_burst;
+      }
+      else {
+	 spin_until(tnext);
+	 tnext += pace;
+      }
+
+      r->rd.locks++;
+      while (p->is_full() ) {
+	 r->rd.waits++;
+	 poll_wait();
+	 r->rd.locks++;
+      }
+      r->rd.locks++;
+      unsigned long long stamp = timer_now_ns();
+      memcpy(p->get_in_ptr(), &stamp, sizeof(stamp) );
+
+      bool first = r->first && n % g_first_every == 0;
+      r->rd.locks++;
+      while (p->next_in(first) ) {
+	 r->rd.waitfirst++;
+	 poll_wait();
+	 r->rd.locks++;
+      }
+   }
+   r->rd.cpu = thread_cpu() - cpu0;
+}
+
+//______________________________________________________________________
+void run(profile_t profile, bool first)
+{
+   run_t r;
+   r.profile	= profile;
+   r.first	= first;
+   r.done	= false;
+   r.pipe	= new pipeline_t(g_framesize, g_pipeline_max, g_pre, g_post);
+
+   pthread_t tid;
+   int err = pthread_create(&tid, NULL, writer, &r);
+   if (err) {
+      fprintf(stderr, "pthread_create: %s\n", strerror(err) );
+      exit(1);
+   }
+   reader(&r);
+   pthread_join(tid, NULL);
+   delete r.pipe;
+
+   double sec = (r.t1 - r.t0) * 1e-9;
+   double n = g_nframes;
+   printf("%-7s %-5s %10.0f %9.1f %9.1f %9.1f %9.1f %6.2f %6.2f %7.2f %7.2f %8.3f %8.3f %6lu\n"
+	  , profile_name[profile], first ? "yes" : "no"
+	  , n / sec
+	  , r.hist.get_percentile(50) * 1e-3
+	  , r.hist.get_percentile(99) * 1e-3
+	  , r.hist.get_percentile(99.9) * 1e-3
+	  , r.hist.get_max() * 1e-3
+	  , r.rd.locks / n, r.wr.locks / n
+	  , r.rd.cpu / n * 1e6, r.wr.cpu / n * 1e6
+	  , r.rd.waits / n, r.wr.waits / n
+	  , r.rd.waitfirst
+      );
+   fflush(stdout);
+}
+
+//______________________________________________________________________
+void usage(char **argv)
+{
+   printf("Usage: %s [options]\n", argv[0]);
+   printf("\t\t -h		# print this\n"
+	  "\t\t -p NAME	# [all] profile: steady, bursty, slow\n"
+	  "\t\t -F		# with first-frame waits only, default both\n"
+	  "\t\t -c RD,WR	# pin reader and writer to cpus\n"
+	  "\t\t -n INT		# [%ld] frames per run\n"
+	  "\t\t -L INT		# [%d] pipeline_max\n"
+	  "\t\t -r FLOAT	# [%g] usec per frame arriving\n"
+	  "\t\t -w FLOAT	# [%g] usec per frame processed\n"
+	  "\t\t -b INT		# [%d] frames per burst\n"
+	  "\t\t -s N:USEC	# [%d:%g] writer stall every N frames\n"
+	  "\t\t -o INT		# [%d] frames per trigger\n"
+	  "\t\t -f INT		# [%d] frames per first-frame\n"
+	  "\t\t -t INT		# [%d] usec per poll, 0 = sched_yield()\n"
+	  , g_nframes, g_pipeline_max, g_pace, g_work, g_burst, g_nstall, g_stall
+	  , g_trig_period, g_first_every, g_timewait);
+   exit(0);
+}
+
+//======================================================================
+int main(int argc, char **argv)
+{
+   int profile = -1;
+   bool first_only = false;
+   int copt;
+   while ( (copt = getopt(argc, argv, "hp:Fc:n:L:r:w:b:s:o:f:t:")) != -1) {
+      switch (copt) {
+      case 'p':
+	 for (int k=0; k < NPROFILES; k++)
+	    if (! strcmp(optarg, profile_name[k]) )	profile = k;
+	 if (profile < 0)	usage(argv);
+	 break;
+      case 'F':	first_only = true;				break;
+      case 'c':	sscanf(optarg, "%d,%d", &g_cpu[0], &g_cpu[1]);	break;
+      case 'n':	sscanf(optarg, "%ld", &g_nframes);		break;
+      case 'L':	sscanf(optarg, "%d", &g_pipeline_max);		break;
+      case 'r':	sscanf(optarg, "%lf", &g_pace);			break;
+      case 'w':	sscanf(optarg, "%lf", &g_work);			break;
+      case 'b':	sscanf(optarg, "%d", &g_burst);			break;
+      case 's':	sscanf(optarg, "%d:%lf", &g_nstall, &g_stall);	break;
+      case 'o':	sscanf(optarg, "%d", &g_trig_period);		break;
+      case 'f':	sscanf(optarg, "%d", &g_first_every);		break;
+      case 't':	sscanf(optarg, "%d", &g_timewait);		break;
+      case 'h':
+      default:
+	 usage(argv);
+      }
+   }
+   if (g_burst < 1)		g_burst = 1;
+   if (g_nstall < 1)		g_nstall = 1;
+   if (g_trig_period < 1)	g_trig_period = 1;
+   if (g_first_every < 1)	g_first_every = 1;
+
+   if (g_cpu[0] >= 0 && g_cpu[1] >= 0) {
+      int core[2], pkg[2];
+      for (int k=0; k < 2; k++) {
+	 core[k] = cpu_topology(g_cpu[k], "core_id");
+	 pkg[k]  = cpu_topology(g_cpu[k], "physical_package_id");
+      }
+      const char *where = g_cpu[0] == g_cpu[1] ? "same cpu"
+	 : core[0] < 0 || core[1] < 0 || pkg[0] < 0 || pkg[1] < 0 ? "topology unknown"
+	 : pkg[0] != pkg[1] ? "cross-socket"
+	 : core[0] == core[1] ? "SMT siblings" : "same socket";
+      printf("# RD on cpu%d, WR on cpu%d: %s\n", g_cpu[0], g_cpu[1], where);
+   }
+   printf("# %ld frames, pipeline_max=%d pre=%d post=%d, arrive %g usec, process %g usec, poll %d usec\n"
+	  , g_nframes, g_pipeline_max, g_pre, g_post, g_pace, g_work, g_timewait);
+   printf("%-7s %-5s %10s %9s %9s %9s %9s %6s %6s %7s %7s %8s %8s %6s\n"
+	  , "profile", "first", "frames/s", "p50_us", "p99_us", "p999_us", "max_us"
+	  , "lk_rd", "lk_wr", "cpu_rd", "cpu_wr", "full/fr", "new/fr", "w1st");
+
+   for (int k=0; k < NPROFILES; k++) {
+      if (profile >= 0 && k != profile)	continue;
+      if (! first_only)	run( (profile_t)k, false);
+      run( (profile_t)k, true);
+   }
+   return 0;
+}
@@ -0,0 +1,122 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * closed-loop control of DAQ load.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "throttle.h"
+
+// add a sample of cumulative counters
+//______________________________________________________________________
+void rate_window_t::add(double t, double ntrigs, double nbytes, double occupancy)
+{
+   _t[_head]	 = t;
+   _trigs[_head] = ntrigs;
+   _bytes[_head] = nbytes;
+   _occ[_head]	 = occupancy;
+   _head = (_head + 1) % NSLOTS;
+   if (_n < NSLOTS)	_n++;
+}
+
+double rate_window_t::get_dt()
+{
+   if (_n < 2)	return 0;
+   return _t[last()] - _t[first()];
+}
+
+double rate_window_t::get_trig_rate()
+{
+   double dt = get_dt();
+   if (dt <= 0)	return 0;
+   return (_trigs[last()] - _trigs[first()]) / dt;
+}
+
+double rate_window_t::get_byte_rate()
+{
+   double dt = get_dt();
+   if (dt <= 0)	return 0;
+   return (_bytes[last()] - _bytes[first()]) / dt;
+}
+
+double rate_window_t::get_occupancy()
+{
+   double occ = 0;
+   for (int i=0; i < _n; i++) {
+      if (_occ[i] > occ)	occ = _occ[i];
+   }
+   return occ;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// decide only on a full window
+//______________________________________________________________________
+bool trig_control_t::update(double t, double ntrigs, double nbytes, double occupancy, double &x)
+{
+   _window.add(t, ntrigs, nbytes, occupancy);
+   if (! _window.is_full() )	return false;
+
+   _occ	 = _window.get_occupancy();
+   _bw	 = _window.get_byte_rate();
+   _rate = _window.get_trig_rate();
+   bool over  = _occ > _occ_max || (_bw_max > 0 && _bw > _bw_max);
+   bool under = _occ < _low * _occ_max && (_bw_max <= 0 || _bw < _low * _bw_max);
+
+   double xnew = x;
+   if (over)
+      xnew = x * (1 + _step);
+   else if (under)
+      xnew = x / (1 + _step);
+   if (xnew > _xmax)	xnew = _xmax;
+   if (xnew < _xmin)	xnew = _xmin;
+
+   if (xnew == x)	return false;
+
+   x = xnew;
+   _nadjust++;
+   _window.clear();		// measure the new setting from scratch
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________
+shed_t::shed_t(int nlevels, double low, double high, double hyst)
+   : _nlevels(nlevels), _level(0), _hyst(hyst), _tlast(-1)
+{
+   if (_nlevels > SHED_MAXLEVELS)	_nlevels = SHED_MAXLEVELS;
+   if (_nlevels < 2)			_nlevels = 2;
+   if (high < low)			high = low;
+   for (int k=0; k < SHED_MAXLEVELS; k++) {
+      _mark[k]	  = 0;
+      _entered[k] = 0;
+      _frames[k]  = 0;
+      _seconds[k] = 0;
+   }
+   for (int k=1; k < _nlevels; k++) {
+      _mark[k] = _nlevels == 2 ? low : low + (high - low) * (k-1) / (_nlevels - 2);
+   }
+}
+
+// called per frame
+//______________________________________________________________________
+int shed_t::update(double occupancy, double t)
+{
+   // account the interval to the level it was spent at
+   if (_tlast >= 0)	_seconds[_level] += t - _tlast;
+   _tlast = t;
+
+   int level = _level;
+   while (level < _nlevels - 1 && occupancy >= _mark[level+1]) {
+      level++;
+      _entered[level]++;
+   }
+   while (level > 0 && occupancy < _mark[level] - _hyst) {
+      level--;
+   }
+   _level = level;
+   _frames[_level]++;
+   return _level;
+}
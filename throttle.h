@@ -0,0 +1,143 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * closed-loop control of DAQ load: trigger threshold vs. pipeline
+ * occupancy and output bandwidth.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef throttle_h
+#define throttle_h
+
+#include <time.h>
+
+// monotonic time in sec
+inline double mono_sec()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//
+// a sliding window of cumulative counters sampled in time.
+//   rate = (last - first) / (t_last - t_first)
+//______________________________________________________________________
+typedef struct rate_window_t
+{
+   enum { NSLOTS = 16 };
+
+   rate_window_t()	{ clear(); }
+
+   void clear()		{ _n = 0; _head = 0; }
+   void add(double t, double ntrigs, double nbytes, double occupancy);
+   bool is_full()	{ return _n == NSLOTS; }
+   int  get_size()	{ return _n; }
+   double get_dt();		// time span of window in sec
+   double get_trig_rate();	// Hz
+   double get_byte_rate();	// bytes/sec
+   double get_occupancy();	// max occupancy in window
+
+private:
+   int		_n;		// samples in window
+   int		_head;		// next slot to fill
+   double	_t[NSLOTS];
+   double	_trigs[NSLOTS];
+   double	_bytes[NSLOTS];
+   double	_occ[NSLOTS];
+   int first()	{ return _n < NSLOTS ? 0 : _head; }
+   int last()	{ return (_head + NSLOTS - 1) % NSLOTS; }
+}
+   rate_window_t
+   ;
+
+//
+// adjust trigger threshold factor x (trig_cds_x) within [xmin, xmax]
+// to keep pipeline occupancy and output bandwidth below targets.
+//   - raise x by <step> if any target exceeded
+//   - lower x by <step> if all below <low> * target
+//   - window restarted after each adjustment
+// usage:
+//   trig_control_t ctrl(xmin, xmax, occ_max, bw_max);
+//   ...
+//   if (ctrl.update(t, ntrigs, nbytes, occ, x)) set new x.
+//______________________________________________________________________
+typedef struct trig_control_t
+{
+   trig_control_t(double xmin, double xmax, double occ_max=0.5, double bw_max=0)
+      : _xmin(xmin), _xmax(xmax), _occ_max(occ_max), _bw_max(bw_max)
+      , _step(0.1), _low(0.5), _nadjust(0)
+      , _occ(0), _bw(0), _rate(0)
+   {
+      if (_xmax < _xmin)	_xmax = _xmin;
+   }
+
+   void set_step(double x)	{ _step = x; }
+   void set_low(double x)	{ _low = x; }
+
+   // return true if x changed
+   bool update(double t, double ntrigs, double nbytes, double occupancy, double &x);
+
+   unsigned long get_nadjust()	{ return _nadjust; }
+   // measured at the last decision
+   double get_occupancy()	{ return _occ; }
+   double get_byte_rate()	{ return _bw; }
+   double get_trig_rate()	{ return _rate; }
+
+private:
+   double	_xmin;
+   double	_xmax;
+   double	_occ_max;	// max pipeline occupancy, fraction
+   double	_bw_max;	// max output, bytes/sec, 0 = no limit
+   double	_step;		// relative step of x
+   double	_low;		// fraction of targets to lower x
+   unsigned long	_nadjust;
+   double	_occ;		// last measured
+   double	_bw;
+   double	_rate;
+   rate_window_t	_window;
+}
+   trig_control_t
+   ;
+
+//
+// graduated load-shedding on pipeline occupancy.
+//   level k (1..nlevels-1) entered at occupancy >= watermark[k],
+//   left below watermark[k] - hysteresis.
+//   watermarks spaced evenly in [low, high].
+// usage:
+//   shed_t shed(nlevels, low, high);
+//   ...
+//   int level = shed.update(occupancy, t);	// per frame
+//______________________________________________________________________
+#define SHED_MAXLEVELS	8
+
+typedef struct shed_t
+{
+   shed_t(int nlevels, double low=0.5, double high=0.9, double hyst=0.05);
+
+   int update(double occupancy, double t);	// return current level
+   int get_level()			{ return _level; }
+   int get_nlevels()			{ return _nlevels; }
+   double get_watermark(int k)		{ return _mark[k]; }
+
+   // accounting per level
+   unsigned long get_entered(int k)	{ return _entered[k]; }
+   unsigned long get_frames(int k)	{ return _frames[k]; }	// frames processed at level k
+   double get_seconds(int k)		{ return _seconds[k]; }	// time spent at level k
+
+private:
+   int		_nlevels;
+   int		_level;
+   double	_hyst;
+   double	_tlast;		// time of last update, < 0 = none
+   double	_mark[SHED_MAXLEVELS];
+   unsigned long	_entered[SHED_MAXLEVELS];
+   unsigned long	_frames[SHED_MAXLEVELS];
+   double		_seconds[SHED_MAXLEVELS];
+}
+   shed_t
+   ;
+
+#endif //~ throttle_h
@@ -0,0 +1,113 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * per-thread span tracing.
+ *
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#include "trace.h"
+#include "error.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+//______________________________________________________________________
+trace_ring_t::trace_ring_t(const char *name, int nbits)
+   : m_name(name), m_tid(0), m_head(0)
+   , m_every(0), m_threshold(~0ULL), m_frame(0), m_sample(false)
+{
+   m_mask   = (1ULL << nbits) - 1;
+   m_events = new trace_event_t[m_mask + 1];
+}
+
+trace_ring_t::~trace_ring_t()
+{
+   delete[] m_events;
+}
+
+void trace_ring_t::set_tid()
+{
+#ifdef __linux__
+   m_tid = syscall(SYS_gettid);
+#else
+   m_tid = getpid();
+#endif
+}
+
+// the owner may write meanwhile:
+// valid are [head - size, head) at the end of the copy
+//______________________________________________________________________
+int trace_ring_t::snapshot(trace_event_t *out)
+{
+   uint64_t size = m_mask + 1;
+   uint64_t h1	 = m_head.load(std::memory_order_acquire);
+   uint64_t h0	 = h1 > size ? h1 - size : 0;
+   for (uint64_t i=h0; i < h1; i++)
+      out[i - h0] = m_events[i & m_mask];
+   std::atomic_thread_fence(std::memory_order_acquire);
+   uint64_t h2	 = m_head.load(std::memory_order_relaxed);
+   uint64_t skip = h2 + 1 > h0 + size ? h2 + 1 - size - h0 : 0;	// overwritten, or being written
+   if (skip >= h1 - h0)	return 0;
+   int n = 0;
+   for (uint64_t i=skip; i < h1 - h0; i++)
+      out[n++] = out[i];
+   return n;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+int trace_dump(const char *fn, trace_ring_t **rings, int nrings)
+{
+   FILE *fp = fopen(fn, "w");
+   if (! fp) {
+      err_ret("trace_dump: fopen(\"%s\")", fn);
+      return -1;
+   }
+
+   int pid = getpid();
+   int nspans = 0;
+   fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+   for (int r=0; r < nrings; r++) {
+      trace_ring_t *ring = rings[r];
+      fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+	      r ? ",\n" : "", pid, ring->get_tid(), ring->get_name() );
+
+      trace_event_t *events = new trace_event_t[ring->get_size()];
+      int n = ring->snapshot(events);
+      for (int i=0; i < n; i++) {
+	 const trace_event_t &e = events[i];
+	 fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d"
+		 ",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%lu}}",
+		 e.name, pid, ring->get_tid(), e.t0 / 1e3, e.dur / 1e3, e.frame);
+      }
+      nspans += n;
+      delete[] events;
+   }
+   fprintf(fp, "\n]}\n");
+   fclose(fp);
+   return nspans;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+static volatile sig_atomic_t trace_flag = 0;
+
+static void trace_handler(int)
+{
+   trace_flag = 1;		// dumped by the polling thread
+}
+
+void trace_signal(int signo)
+{
+   signal(signo, trace_handler);
+}
+
+bool trace_requested()
+{
+   if (! trace_flag)	return false;
+   trace_flag = 0;
+   return true;
+}
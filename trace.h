@@ -0,0 +1,95 @@
+/*******************************************************************//**
+ * $Id$
+ *
+ * per-thread span tracing, dumped as Chrome trace JSON
+ * (chrome://tracing, ui.perfetto.dev).
+ *
+ * - one ring per thread, written by its owner only (single producer);
+ *   the oldest spans are overwritten, the writer never blocks.
+ * - a span is kept if its frame is sampled (1 in <every>) or it lasts
+ *   at least <threshold> nsec, so rare stalls are always captured.
+ * - a dump may run in another thread: spans overwritten during the
+ *   copy are discarded.
+ *
+ * usage:
+ *   trace_ring_t ring("writer");
+ *   ring.set_frame(iframe);				// per frame
+ *   ring.span("stage", t0_ns, dur_ns);			// or via Timer::set_trace()
+ *   trace_ring_t *rings[] = { &ring, ... };
+ *   trace_dump("trace.json", rings, n);
+ *
+ * @copyright:  (c)2020 HEPG - Shandong University. All Rights Reserved.
+ ***********************************************************************/
+#ifndef trace_h
+#define trace_h
+
+#include <stdint.h>
+
+#include <atomic>
+
+typedef struct trace_event_t
+{
+   uint64_t	t0;		// nsec, CLOCK_MONOTONIC_RAW
+   uint64_t	dur;		// nsec
+   const char *	name;		// static string
+   unsigned long frame;
+}
+   trace_event_t
+   ;
+
+//______________________________________________________________________
+class trace_ring_t
+{
+public:
+   trace_ring_t(const char *name, int nbits=16);	// 2^nbits spans
+   ~trace_ring_t();
+
+   void set_sample(unsigned long every)	{ m_every = every; }	// 0 = threshold only
+   void set_threshold(uint64_t ns)	{ m_threshold = ns; }
+
+   void set_frame(unsigned long frame)
+   {
+      m_frame  = frame;
+      m_sample = m_every > 0 && frame % m_every == 0;
+   }
+
+   void span(const char *name, uint64_t t0, uint64_t dur)
+   {
+      if (! m_sample && dur < m_threshold)	return;
+      uint64_t h = m_head.load(std::memory_order_relaxed);
+      trace_event_t &e = m_events[h & m_mask];
+      e.t0	= t0;
+      e.dur	= dur;
+      e.name	= name;
+      e.frame	= m_frame;
+      m_head.store(h + 1, std::memory_order_release);
+   }
+
+   // copy of spans still in ring, return number copied
+   int snapshot(trace_event_t *out);
+   int get_size()		{ return (int)(m_mask + 1); }
+   const char * get_name()	{ return m_name; }
+   int get_tid()		{ return m_tid; }
+   void set_tid();		// in the owner thread
+   uint64_t get_total()		{ return m_head.load(); }	// spans ever kept
+
+private:
+   const char *	m_name;
+   int		m_tid;
+   uint64_t	m_mask;
+   trace_event_t *	m_events;
+   std::atomic<uint64_t>	m_head;
+   unsigned long	m_every;
+   uint64_t	m_threshold;
+   unsigned long	m_frame;
+   bool		m_sample;
+};
+
+// write rings as Chrome trace JSON, return spans written or -1
+int trace_dump(const char *fn, trace_ring_t **rings, int nrings);
+
+// dump on request by signal (e.g. SIGUSR1)
+void trace_signal(int signo);
+bool trace_requested();		// true once per signal
+
+#endif //~ trace_h